@@ -47,8 +47,9 @@ const uint16_t OFBC_ORIGINAL_FILENAME = 0x0028;                    // The origin
 const uint16_t OFBC_RENAMED_FILE = 0x0029;                         // A timestamped event to indicate when a file has been renamed by one of Vulintus' automatic data organizing programs.
 const uint16_t OFBC_DOWNLOAD_TIME = 0x002A;                        // A timestamp indicating when the data file was downloaded from the OmniTrak device to a computer.
 const uint16_t OFBC_DOWNLOAD_SYSTEM = 0x002B;                      // The computer system name and the COM port used to download the data file form the OmniTrak device.
+const uint16_t OFBC_METADATA_TRAILER = 0x002C;                     // Frames the file metadata blocks (ORIGINAL_FILENAME, RENAMED_FILE, DOWNLOAD_TIME, DOWNLOAD_SYSTEM) appended as a trailer at the end of the file, so they can be found with one read from the end.
 
-const uint16_t OFBC_INCOMPLETE_BLOCK = 0x0032;                     // Indicates that the file will end in an incomplete block.
+const uint16_t OFBC_INCOMPLETE_BLOCK = 0x0032;                     // Marks the next block as split across two device writes, giving its code and start and end bytes; a file that ends inside that block was cut off between the writes.
 
 const uint16_t OFBC_USER_TIME = 0x003C;                            // Date/time values from a user-set timestamp.
 
@@ -126,6 +127,7 @@ const uint16_t OFBC_MLX90640_ENABLED = 0x03F0;                     // Indicates
 const uint16_t OFBC_ZMOD4410_ENABLED = 0x03F1;                     // Indicates that an ZMOD4410 VOC/eC02 sensor is present in the system.
 
 const uint16_t OFBC_AMBULATION_XY_THETA = 0x0400;                  // A point in a tracked ambulation path, with absolute x- and y-coordinates in millimeters, with facing direction theta, in degrees.
+const uint16_t OFBC_AMBULATION_XY_THETA_PACKED = 0x0401;           // A batch of tracked ambulation path points (see AMBULATION_XY_THETA), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
 
 const uint16_t OFBC_AMG8833_THERM_CONV = 0x044C;                   // The conversion factor, in degrees Celsius, for converting 16-bit integer AMG8833 pixel readings to temperature.
 const uint16_t OFBC_AMG8833_THERM_FL = 0x044D;                     // The current AMG8833 thermistor reading as a converted float32 value, in Celsius.
@@ -181,6 +183,7 @@ const uint16_t OFBC_MLX90640_IM_WRITE_TIME = 0x05F2;               // The SD car
 const uint16_t OFBC_MLX90640_INT_WRITE_TIME = 0x05F3;              // The SD card write time for the MLX90640 raw uint16 data.
 
 const uint16_t OFBC_ALSPT19_LIGHT = 0x0640;                        // The current analog value of the ALS-PT19 ambient light sensor, as an unsigned integer ADC value.
+const uint16_t OFBC_ALSPT19_LIGHT_PACKED = 0x0641;                 // A batch of ALS-PT19 ambient light sensor ADC values (see ALSPT19_LIGHT), packed as delta-of-delta millisecond timestamps and bit-packed value deltas.
 
 const uint16_t OFBC_ZMOD4410_MOX_BOUND = 0x06A4;                   // The current lower and upper bounds for the ZMOD4410 ADC reading used in calculations.
 const uint16_t OFBC_ZMOD4410_CONFIG_PARAMS = 0x06A5;               // Current configuration values for the ZMOD4410.
@@ -248,9 +251,11 @@ const uint16_t OFBC_MOTOTRAK_V3P0_OUTCOME = 0x09C4;                // MotoTrak v
 const uint16_t OFBC_MOTOTRAK_V3P0_SIGNAL = 0x09C5;                 // MotoTrak version 3.0 trial stream signal.
 
 const uint16_t OFBC_POKE_BITMASK = 0x0A00;                         // Nosepoke status bitmask, typically written only when it changes.
+const uint16_t OFBC_POKE_BITMASK_PACKED = 0x0A01;                  // A batch of nosepoke status bitmasks (see POKE_BITMASK), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
 
 const uint16_t OFBC_CAPSENSE_BITMASK = 0x0A10;                     // Capacitive sensor status bitmask, typically written only when it changes.
 const uint16_t OFBC_CAPSENSE_VALUE = 0x0A11;                       // Capacitive sensor reading for one sensor, in ADC ticks or clock cycles.
+const uint16_t OFBC_CAPSENSE_VALUE_PACKED = 0x0A12;                // A batch of capacitive sensor readings for one sensor (see CAPSENSE_VALUE), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
 
 const uint16_t OFBC_OUTPUT_TRIGGER_NAME = 0x0A28;                  // Name/description of the output trigger type for the given index.
 
@@ -0,0 +1,743 @@
+/*
+	OmniTrak_File_Block_Sizes.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Block Codes (OFBC) Payload Size Table
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	The *.OmniTrak format has no per-block length field, so a reader can only
+	find the next block by knowing how many payload bytes follow each block
+	code. This table gives, for every code in OmniTrak_File_Block_Codes.h,
+	either a fixed payload size or the rule for computing it from the first
+	few payload bytes (length-prefixed strings, counted arrays, type
+	bitmasks, and the handful of trial/trace blocks with nested counts).
+
+	The layouts follow the MATLAB OmniTrakFileRead_ReadBlock_* functions,
+	falling back to the "Data Block Definitions" tables where MATLAB has no
+	reader yet. Blocks with no documented layout are marked UNDEFINED, and a
+	reader must stop when it meets one. Keep this table in step with
+	OmniTrak_File_Block_Codes.h whenever a block code is added.
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OFBC_BLOCK_SIZES_H_
+#define _VULINTUS_OFBC_BLOCK_SIZES_H_
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "OmniTrak_File_Block_Codes.h"
+
+const uint64_t OFBC_FILE_HEADER_SIZE = 6;                          // 0xABCD verify code + FILE_VERSION code + uint16 version.
+const uint16_t OFBC_LOOKUP_RANGE = 0x1000;                         // Every tabled block code must be below this value.
+
+enum OFBC_Size_Rule : uint8_t {
+	OFBC_RULE_FIXED,                                               // Payload is always "fixed" bytes.
+	OFBC_RULE_COUNTED,                                             // "fixed" header bytes, ending in an element count, then count * elem_size bytes.
+	OFBC_RULE_CUSTOM,                                              // Size computed by a block-specific function below.
+	OFBC_RULE_UNDEFINED,                                           // No documented layout; the block can't be skipped.
+};
+
+enum OFBC_Size_Status : uint8_t {
+	OFBC_SIZE_OK,                                                  // "size" holds the payload size.
+	OFBC_SIZE_NEED_MORE,                                           // "size" holds how many payload bytes must be visible to continue.
+	OFBC_SIZE_UNKNOWN_CODE,                                        // The block code isn't in the table.
+	OFBC_SIZE_UNDEFINED_LAYOUT,                                    // The block code is known, but its layout isn't.
+	OFBC_SIZE_BAD_VERSION,                                         // The block's leading version field isn't one we can size.
+	OFBC_SIZE_INVALID,                                             // The payload contents can't describe a real block.
+};
+
+struct OFBC_Size_Result {
+	OFBC_Size_Status status;
+	uint64_t size;
+};
+
+struct OFBC_Block_Layout {
+	uint16_t code;                                                 // OFBC block code.
+	const char *name;                                              // Definition name, without the "OFBC_" prefix.
+	OFBC_Size_Rule rule;                                           // How the payload size is found.
+	uint8_t version_bytes;                                         // Width of a leading version field that must equal 1 (0 if unversioned).
+	uint32_t fixed;                                                // FIXED: payload size. COUNTED: header bytes, including the count.
+	uint8_t count_bytes;                                           // COUNTED: width of the count that ends the header (1, 2, or 4).
+	uint8_t elem_size;                                             // COUNTED: bytes per counted element.
+};
+
+
+//Table entry constructors.
+constexpr OFBC_Block_Layout ofbc_layout_fixed(uint16_t code, const char *name, uint32_t size, uint8_t version_bytes = 0)
+{
+	return {code, name, OFBC_RULE_FIXED, version_bytes, size, 0, 0};
+}
+
+constexpr OFBC_Block_Layout ofbc_layout_counted(uint16_t code, const char *name, uint32_t head, uint8_t count_bytes, uint8_t elem_size, uint8_t version_bytes = 0)
+{
+	return {code, name, OFBC_RULE_COUNTED, version_bytes, head + count_bytes, count_bytes, elem_size};
+}
+
+constexpr OFBC_Block_Layout ofbc_layout_custom(uint16_t code, const char *name)
+{
+	return {code, name, OFBC_RULE_CUSTOM, 0, 0, 0, 0};
+}
+
+constexpr OFBC_Block_Layout ofbc_layout_undefined(uint16_t code, const char *name)
+{
+	return {code, name, OFBC_RULE_UNDEFINED, 0, 0, 0, 0};
+}
+
+#define OFBC_FIXED(def, ...)		ofbc_layout_fixed(OFBC_##def, #def, __VA_ARGS__)
+#define OFBC_STR8(def)				ofbc_layout_counted(OFBC_##def, #def, 0, 1, 1)
+#define OFBC_STR16(def)				ofbc_layout_counted(OFBC_##def, #def, 0, 2, 1)
+#define OFBC_COUNTED(def, ...)		ofbc_layout_counted(OFBC_##def, #def, __VA_ARGS__)
+#define OFBC_CUSTOM(def)			ofbc_layout_custom(OFBC_##def, #def)
+#define OFBC_UNDEFINED(def)			ofbc_layout_undefined(OFBC_##def, #def)
+
+
+//Payload layouts for every block code, in block code order.
+constexpr OFBC_Block_Layout OFBC_BLOCK_LAYOUTS[] = {
+
+	OFBC_FIXED(FILE_VERSION, 2),                                   // uint16 version.
+	OFBC_FIXED(MS_FILE_START, 4),                                  // uint32 millis.
+	OFBC_FIXED(MS_FILE_STOP, 4),                                   // uint32 millis.
+	OFBC_STR16(SUBJECT_DEPRECATED),                                // uint16 N, N chars.
+	OFBC_FIXED(CLOCK_FILE_START, 8),                               // float64 serial date.
+	OFBC_FIXED(CLOCK_FILE_STOP, 8),                                // float64 serial date.
+	OFBC_FIXED(DEVICE_FILE_INDEX, 4),                              // uint32 index.
+	OFBC_FIXED(NTP_SYNC, 9),                                       // uint32 NTP time, uint32 millis, uint8 rollovers.
+	OFBC_FIXED(NTP_SYNC_FAIL, 0),                                  // No data.
+	OFBC_CUSTOM(CLOCK_SYNC),                                       // uint8 version, uint8 port, uint8 type bitmask, masked fields.
+	OFBC_FIXED(MS_TIMER_ROLLOVER, 0),                              // No data.
+	OFBC_FIXED(US_TIMER_ROLLOVER, 0),                              // No data.
+	OFBC_FIXED(TIME_ZONE_OFFSET, 8),                               // float64 offset, in days.
+	OFBC_FIXED(TIME_ZONE_OFFSET_HHMM, 2),                          // int8 hours, uint8 minutes.
+	OFBC_STR16(RTC_STRING_DEPRECATED),                             // uint16 N, N chars.
+	OFBC_COUNTED(RTC_STRING, 4, 2, 1),                             // uint32 millis, uint16 N, N chars.
+	OFBC_FIXED(RTC_VALUES, 11),                                    // uint32 millis, uint16 year, 5x uint8 month/day/hour/minute/second.
+	OFBC_STR16(ORIGINAL_FILENAME),                                 // uint16 N, N chars.
+	OFBC_CUSTOM(RENAMED_FILE),                                     // float64 serial date, uint16 N, N chars, uint16 N, N chars.
+	OFBC_FIXED(DOWNLOAD_TIME, 8),                                  // float64 serial date.
+	OFBC_CUSTOM(DOWNLOAD_SYSTEM),                                  // uint8 N, N chars, uint8 N, N chars.
+	OFBC_FIXED(METADATA_TRAILER, 18, 1),                           // uint8 version, uint8 blocks, uint32 trailer bytes, uint64 previous trailer end, uint32 CRC-32.
+	OFBC_FIXED(INCOMPLETE_BLOCK, 10),                              // uint16 block code, uint32 start byte, uint32 end byte (low 32 bits).
+	OFBC_FIXED(USER_TIME, 10),                                     // uint32 millis, uint8 year, 5x uint8 month/day/hour/minute/second.
+
+	OFBC_FIXED(SYSTEM_TYPE, 1),                                    // uint8 system ID.
+	OFBC_STR8(SYSTEM_NAME),                                        // uint8 N, N chars.
+	OFBC_FIXED(SYSTEM_HW_VER, 4),                                  // float32 version.
+	OFBC_STR8(SYSTEM_FW_VER),                                      // uint8 N, N chars.
+	OFBC_STR8(SYSTEM_SN),                                          // uint8 N, N chars.
+	OFBC_STR8(SYSTEM_MFR),                                         // uint8 N, N chars.
+	OFBC_STR8(COMPUTER_NAME),                                      // uint8 N, N chars.
+	OFBC_STR8(COM_PORT),                                           // uint8 N, N chars.
+	OFBC_STR8(DEVICE_ALIAS),                                       // uint8 N, N chars.
+	OFBC_CUSTOM(PRIMARY_MODULE),                                   // uint8 N, N chars (uint16 N in early files).
+	OFBC_STR16(PRIMARY_INPUT),                                     // uint16 N, N chars.
+	OFBC_FIXED(SAMD_CHIP_ID, 16),                                  // 4x uint32 ID words.
+	OFBC_FIXED(ESP8266_MAC_ADDR, 6),                               // 6x uint8 address bytes.
+	OFBC_FIXED(ESP8266_IP4_ADDR, 4),                               // 4x uint8 address fields.
+	OFBC_FIXED(ESP8266_CHIP_ID, 4),                                // uint32 ID.
+	OFBC_FIXED(ESP8266_FLASH_ID, 4),                               // uint32 ID.
+	OFBC_STR8(USER_SYSTEM_NAME),                                   // uint8 N, N chars.
+	OFBC_FIXED(DEVICE_RESET_COUNT, 2),                             // uint16 count.
+	OFBC_STR8(CTRL_FW_FILENAME),                                   // uint8 N, N chars.
+	OFBC_STR8(CTRL_FW_DATE),                                       // uint8 N, N chars.
+	OFBC_STR8(CTRL_FW_TIME),                                       // uint8 N, N chars.
+	OFBC_COUNTED(MODULE_FW_FILENAME, 1, 1, 1),                     // uint8 module index, uint8 N, N chars.
+	OFBC_COUNTED(MODULE_FW_DATE, 1, 1, 1),                         // uint8 module index, uint8 N, N chars.
+	OFBC_COUNTED(MODULE_FW_TIME, 1, 1, 1),                         // uint8 module index, uint8 N, N chars.
+	OFBC_COUNTED(MODULE_NAME, 1, 1, 1),                            // uint8 module index, uint8 N, N chars.
+	OFBC_COUNTED(MODULE_SKU, 1, 1, 1),                             // uint8 module index, uint8 N, N chars.
+	OFBC_FIXED(WINC1500_MAC_ADDR, 6),                              // 6x uint8 address bytes.
+	OFBC_FIXED(WINC1500_IP4_ADDR, 4),                              // 4x uint8 address fields.
+	OFBC_COUNTED(MODULE_SN, 1, 1, 1),                              // uint8 module index, uint8 N, N chars.
+	OFBC_FIXED(BATTERY_SOC, 6),                                    // uint32 millis, uint16 percent.
+	OFBC_FIXED(BATTERY_VOLTS, 6),                                  // uint32 millis, uint16 millivolts.
+	OFBC_FIXED(BATTERY_CURRENT, 6),                                // uint32 millis, int16 milliamps.
+	OFBC_FIXED(BATTERY_FULL, 6),                                   // uint32 millis, uint16 mAh.
+	OFBC_FIXED(BATTERY_REMAIN, 6),                                 // uint32 millis, uint16 mAh.
+	OFBC_FIXED(BATTERY_POWER, 6),                                  // uint32 millis, int16 milliwatts.
+	OFBC_FIXED(BATTERY_SOH, 6),                                    // uint32 millis, int16 percent.
+	OFBC_FIXED(BATTERY_STATUS, 18),                                // uint32 millis, 7x 16-bit readings.
+	OFBC_FIXED(FEED_SERVO_MAX_RPM, 5),                             // uint8 dispenser index, float32 RPM.
+	OFBC_FIXED(FEED_SERVO_SPEED, 2),                               // uint8 dispenser index, uint8 speed.
+
+	OFBC_STR16(SUBJECT_NAME),                                      // uint16 N, N chars.
+	OFBC_STR16(GROUP_NAME),                                        // uint16 N, N chars.
+	OFBC_STR8(ADMIN_NAME),                                         // uint8 N, N chars.
+	OFBC_STR16(EXP_NAME),                                          // uint16 N, N chars.
+	OFBC_STR16(TASK_TYPE),                                         // uint16 N, N chars.
+	OFBC_STR16(STAGE_NAME),                                        // uint16 N, N chars.
+	OFBC_STR16(STAGE_DESCRIPTION),                                 // uint16 N, N chars.
+	OFBC_COUNTED(SESSION_PARAMS_JSON, 1, 4, 1, 1),                 // uint8 version, uint32 N, N chars.
+	OFBC_COUNTED(TRIAL_PARAMS_JSON, 1, 4, 1, 1),                   // uint8 version, uint32 N, N chars.
+
+	OFBC_FIXED(AMG8833_ENABLED, 0),                                // No data.
+	OFBC_FIXED(BMP280_ENABLED, 0),                                 // No data.
+	OFBC_FIXED(BME280_ENABLED, 0),                                 // No data.
+	OFBC_FIXED(BME680_ENABLED, 0),                                 // No data.
+	OFBC_FIXED(CCS811_ENABLED, 0),                                 // No data.
+	OFBC_FIXED(SGP30_ENABLED, 0),                                  // No data.
+	OFBC_FIXED(VL53L0X_ENABLED, 0),                                // No data.
+	OFBC_FIXED(ALSPT19_ENABLED, 0),                                // No data.
+	OFBC_FIXED(MLX90640_ENABLED, 0),                               // No data.
+	OFBC_FIXED(ZMOD4410_ENABLED, 0),                               // No data.
+	OFBC_FIXED(AMBULATION_XY_THETA, 17, 1),                        // uint8 version, uint32 micros, 2x float32 xy, float32 theta.
+	OFBC_CUSTOM(AMBULATION_XY_THETA_PACKED),                       // Packed sample batch, 3 channels.
+	OFBC_FIXED(AMG8833_THERM_CONV, 5),                             // uint8 ID, float32 factor.
+	OFBC_FIXED(AMG8833_THERM_FL, 9),                               // uint8 ID, uint32 millis, float32 Celsius.
+	OFBC_FIXED(AMG8833_THERM_INT, 7),                              // uint8 ID, uint32 millis, int16 reading.
+	OFBC_FIXED(AMG8833_PIXELS_CONV, 5),                            // uint8 ID, float32 factor.
+	OFBC_FIXED(AMG8833_PIXELS_FL, 5 + 64 * 4),                     // uint8 ID, uint32 millis, 64x float32 Celsius.
+	OFBC_FIXED(AMG8833_PIXELS_INT, 5 + 64 * 2),                    // uint8 ID, uint32 millis, 64x int16 readings.
+	OFBC_FIXED(HTPA32X32_PIXELS_FP62, 5 + 1024),                   // uint8 ID, uint32 millis, 1024x uint8 FP6.2 Celsius.
+	OFBC_FIXED(HTPA32X32_PIXELS_INT_K, 5 + 1024 * 2),              // uint8 ID, uint32 millis, 1024x uint16 deciKelvin.
+	OFBC_FIXED(HTPA32X32_AMBIENT_TEMP, 9),                         // uint8 ID, uint32 millis, float32 Celsius.
+	OFBC_FIXED(HTPA32X32_PIXELS_INT12_C, 5 + 1024 * 3 / 2),        // uint8 ID, uint32 millis, 1024x int12 deciCelsius.
+	OFBC_UNDEFINED(HTPA32X32_HOTTEST_PIXEL_FP62),                  // Not yet documented.
+	OFBC_FIXED(BH1749_RGB, 15),                                    // uint8 ID, uint32 millis, 5x uint16 channels.
+	OFBC_STR16(DEBUG_SANITY_CHECK),                                // uint16 N, N chars.
+	OFBC_FIXED(BME280_TEMP_FL, 9),                                 // uint8 ID, uint32 millis, float32 Celsius.
+	OFBC_FIXED(BMP280_TEMP_FL, 9),                                 // uint8 ID, uint32 millis, float32 Celsius.
+	OFBC_FIXED(BME680_TEMP_FL, 9),                                 // uint8 ID, uint32 millis, float32 Celsius.
+	OFBC_FIXED(BME280_PRES_FL, 9),                                 // uint8 ID, uint32 millis, float32 Pascals.
+	OFBC_FIXED(BMP280_PRES_FL, 9),                                 // uint8 ID, uint32 millis, float32 Pascals.
+	OFBC_FIXED(BME680_PRES_FL, 9),                                 // uint8 ID, uint32 millis, float32 Pascals.
+	OFBC_FIXED(BME280_HUM_FL, 9),                                  // uint8 ID, uint32 millis, float32 percent.
+	OFBC_FIXED(BME680_HUM_FL, 9),                                  // uint8 ID, uint32 millis, float32 percent.
+	OFBC_FIXED(BME680_GAS_FL, 9),                                  // uint8 ID, uint32 millis, float32 kOhms.
+	OFBC_FIXED(VL53L0X_DIST, 7),                                   // uint8 ID, uint32 millis, int16 millimeters.
+	OFBC_FIXED(VL53L0X_FAIL, 5),                                   // uint8 ID, uint32 millis.
+	OFBC_FIXED(SGP30_SN, 7),                                       // uint8 ID, 3x uint16 serial number words.
+	OFBC_FIXED(SGP30_EC02, 7),                                     // uint8 ID, uint32 millis, uint16 ppm.
+	OFBC_FIXED(SGP30_TVOC, 7),                                     // uint8 ID, uint32 millis, uint16 ppm.
+	OFBC_UNDEFINED(MLX90640_DEVICE_ID),                            // Not yet documented.
+	OFBC_FIXED(MLX90640_EEPROM_DUMP, 5 + 832 * 2),                 // uint8 ID, uint32 millis, 832x uint16 EEPROM words.
+	OFBC_FIXED(MLX90640_ADC_RES, 6),                               // uint8 ID, uint32 millis, uint8 bits.
+	OFBC_FIXED(MLX90640_REFRESH_RATE, 6),                          // uint8 ID, uint32 millis, uint8 rate setting.
+	OFBC_FIXED(MLX90640_I2C_CLOCKRATE, 9),                         // uint8 ID, uint32 millis, uint32 kHz.
+	OFBC_FIXED(MLX90640_PIXELS_TO, 5 + 768 * 4),                   // uint8 ID, uint32 millis, 768x float32 Celsius.
+	OFBC_FIXED(MLX90640_PIXELS_IM, 5 + 768 * 4),                   // uint8 ID, uint32 millis, 768x float32 uncalibrated.
+	OFBC_FIXED(MLX90640_PIXELS_INT, 5 + 834 * 2),                  // uint8 ID, uint32 millis, 834x uint16 frame words.
+	OFBC_FIXED(MLX90640_I2C_TIME, 9),                              // uint8 ID, uint32 start millis, uint32 stop millis.
+	OFBC_FIXED(MLX90640_CALC_TIME, 9),                             // uint8 ID, uint32 start millis, uint32 stop millis.
+	OFBC_FIXED(MLX90640_IM_WRITE_TIME, 9),                         // uint8 ID, uint32 start millis, uint32 stop millis.
+	OFBC_FIXED(MLX90640_INT_WRITE_TIME, 9),                        // uint8 ID, uint32 start millis, uint32 stop millis.
+	OFBC_FIXED(ALSPT19_LIGHT, 7),                                  // uint8 ID, uint32 millis, uint16 ADC value.
+	OFBC_CUSTOM(ALSPT19_LIGHT_PACKED),                             // Packed sample batch, 1 channel.
+	OFBC_FIXED(ZMOD4410_MOX_BOUND, 5),                             // uint8 ID, uint16 lower bound, uint16 upper bound.
+	OFBC_FIXED(ZMOD4410_CONFIG_PARAMS, 7),                         // uint8 ID, 6x uint8 registers.
+	OFBC_FIXED(ZMOD4410_ERROR, 6),                                 // uint8 ID, uint32 millis, uint8 error code.
+	OFBC_FIXED(ZMOD4410_READING_FL, 9),                            // uint8 ID, uint32 millis, float32 reading.
+	OFBC_FIXED(ZMOD4410_READING_INT, 7),                           // uint8 ID, uint32 millis, uint16 ADC value.
+	OFBC_UNDEFINED(ZMOD4410_ECO2),                                 // Not yet documented.
+	OFBC_UNDEFINED(ZMOD4410_IAQ),                                  // Not yet documented.
+	OFBC_UNDEFINED(ZMOD4410_TVOC),                                 // Not yet documented.
+	OFBC_UNDEFINED(ZMOD4410_R_CDA),                                // Not yet documented.
+	OFBC_FIXED(LSM303_ACC_SETTINGS, 25),                           // uint8 ID, uint32 millis, 2x uint32, 3x float32.
+	OFBC_FIXED(LSM303_MAG_SETTINGS, 25),                           // uint8 ID, uint32 millis, 2x uint32, 3x float32.
+	OFBC_FIXED(LSM303_ACC_FL, 17),                                 // uint8 ID, uint32 millis, 3x float32 m/s^2.
+	OFBC_FIXED(LSM303_MAG_FL, 17),                                 // uint8 ID, uint32 millis, 3x float32 uT.
+	OFBC_FIXED(LSM303_TEMP_FL, 9),                                 // uint8 ID, uint32 millis, float32 Celsius.
+	OFBC_COUNTED(SPECTRO_WAVELEN, 1, 4, 4),                        // uint8 ID, uint32 N, N float32 nanometers.
+	OFBC_CUSTOM(SPECTRO_TRACE),                                    // 25-byte header, uint32 N, uint16 reps, reps * N float64.
+
+	OFBC_FIXED(PELLET_DISPENSE, 7),                                // uint32 millis, uint8 dispenser index, uint16 trial.
+	OFBC_FIXED(PELLET_FAILURE, 5),                                 // uint8 dispenser index, uint32 millis (index first, unlike PELLET_DISPENSE).
+	OFBC_FIXED(HARD_PAUSE_START, 4),                               // uint32 millis.
+	OFBC_FIXED(HARD_PAUSE_STOP, 4),                                // uint32 millis.
+	OFBC_FIXED(SOFT_PAUSE_START, 4),                               // uint32 millis.
+	OFBC_FIXED(SOFT_PAUSE_STOP, 4),                                // uint32 millis.
+	OFBC_FIXED(TRIAL_START_SERIAL_DATE, 10),                       // float64 serial date, uint16 trial.
+	OFBC_FIXED(POSITION_START_X, 5),                               // uint8 index, float32 x.
+	OFBC_FIXED(POSITION_MOVE_X, 9),                                // uint8 index, uint32 millis, float32 x (index first, unlike MOVE_XY/XYZ).
+	OFBC_FIXED(POSITION_START_XY, 9),                              // uint8 index, 2x float32 xy.
+	OFBC_FIXED(POSITION_MOVE_XY, 13),                              // uint32 millis, uint8 index, 2x float32 xy.
+	OFBC_FIXED(POSITION_START_XYZ, 13),                            // uint8 index, 3x float32 xyz.
+	OFBC_FIXED(POSITION_MOVE_XYZ, 17),                             // uint32 millis, uint8 index, 3x float32 xyz.
+	OFBC_CUSTOM(TTL_PULSETRAIN),                                   // uint8 version, then a fixed (v1) or bitmasked (v2) field list.
+	OFBC_CUSTOM(TTL_PULSETRAIN_ABORT),                             // uint8 version, uint8 source, uint8 channel, uint8 bitmask, masked fields.
+	OFBC_COUNTED(STREAM_INPUT_NAME, 1, 1, 1),                      // uint8 input index, uint8 N, N chars.
+	OFBC_FIXED(CALIBRATION_BASELINE, 5),                           // uint8 module index, float32 coefficient.
+	OFBC_FIXED(CALIBRATION_SLOPE, 5),                              // uint8 module index, float32 coefficient.
+	OFBC_FIXED(CALIBRATION_BASELINE_ADJUST, 9),                    // uint32 millis, uint8 module index, float32 coefficient.
+	OFBC_FIXED(CALIBRATION_SLOPE_ADJUST, 9),                       // uint32 millis, uint8 module index, float32 coefficient.
+	OFBC_FIXED(CALIBRATION_DATE, 9),                               // uint8 module index, float64 serial date.
+	OFBC_COUNTED(HIT_THRESH_TYPE, 1, 2, 1),                        // uint8 input index, uint16 N, N chars.
+	OFBC_COUNTED(SECONDARY_THRESH_NAME, 1, 1, 1),                  // uint8 threshold index, uint8 N, N chars.
+	OFBC_COUNTED(INIT_THRESH_TYPE, 1, 2, 1),                       // uint8 input index, uint16 N, N chars.
+	OFBC_FIXED(REMOTE_MANUAL_FEED, 7),                             // uint8 dispenser index, uint32 millis, uint16 feedings.
+	OFBC_FIXED(HWUI_MANUAL_FEED, 11),                              // uint8 dispenser index, float64 serial date, uint16 feedings.
+	OFBC_FIXED(FW_RANDOM_FEED, 7),                                 // uint8 dispenser index, uint32 millis, uint16 feedings.
+	OFBC_FIXED(SWUI_MANUAL_FEED_DEPRECATED, 9),                    // float64 serial date, uint8 feedings.
+	OFBC_FIXED(FW_OPERANT_FEED, 7),                                // uint8 dispenser index, uint32 millis, uint16 feedings.
+	OFBC_FIXED(SWUI_MANUAL_FEED, 11),                              // uint8 dispenser index, float64 serial date, uint16 feedings.
+	OFBC_FIXED(SW_RANDOM_FEED, 11),                                // uint8 dispenser index, float64 serial date, uint16 feedings.
+	OFBC_FIXED(SW_OPERANT_FEED, 11),                               // uint8 dispenser index, float64 serial date, uint16 feedings.
+	OFBC_CUSTOM(MOTOTRAK_V3P0_OUTCOME),                            // Trial header, counted thresholds/hits/triggers, pre-trial samples.
+	OFBC_CUSTOM(MOTOTRAK_V3P0_SIGNAL),                             // Trial header, hit window and post-trial samples.
+	OFBC_FIXED(POKE_BITMASK, 15, 1),                               // uint8 version, float64 serial date, float32 micros, uint8 sensors, uint8 bitmask.
+	OFBC_CUSTOM(POKE_BITMASK_PACKED),                              // Packed sample batch, 2 channels.
+	OFBC_FIXED(CAPSENSE_BITMASK, 15, 1),                           // uint8 version, float64 serial date, float32 micros, uint8 sensors, uint8 bitmask.
+	OFBC_FIXED(CAPSENSE_VALUE, 18, 1),                             // CAPSENSE_BITMASK fields, uint8 sensor index, uint16 value.
+	OFBC_CUSTOM(CAPSENSE_VALUE_PACKED),                            // Packed sample batch, 3 channels.
+	OFBC_COUNTED(OUTPUT_TRIGGER_NAME, 1, 1, 1),                    // uint8 trigger index, uint8 N, N chars.
+	OFBC_CUSTOM(VIBRATION_TASK_TRIAL_OUTCOME),                     // Trial fields, counted feed times, counted signal samples.
+	OFBC_CUSTOM(VIBROTACTILE_DETECTION_TASK_TRIAL),                // uint16 version, then VIBRATION_TASK_TRIAL_OUTCOME-style fields.
+	OFBC_CUSTOM(LED_DETECTION_TASK_TRIAL_OUTCOME),                 // Trial fields, counted feed times, counted signal samples.
+	OFBC_COUNTED(LIGHT_SRC_MODEL, 3, 1, 1),                        // uint8 module index, uint16 source index, uint8 N, N chars.
+	OFBC_COUNTED(LIGHT_SRC_TYPE, 3, 1, 1),                         // uint8 module index, uint16 source index, uint8 N, N chars.
+	OFBC_CUSTOM(STTC_2AFC_TRIAL_OUTCOME),                          // Trial fields, counted feed times, pad label, counted signal samples.
+	OFBC_FIXED(STTC_NUM_PADS, 2),                                  // uint8 module index, uint8 pads.
+	OFBC_FIXED(MODULE_MICROSTEP, 2),                               // uint8 module index, uint8 microstep.
+	OFBC_FIXED(MODULE_STEPS_PER_ROT, 3),                           // uint8 module index, uint16 steps.
+	OFBC_FIXED(MODULE_PITCH_CIRC, 5),                              // uint8 module index, float32 millimeters.
+	OFBC_FIXED(MODULE_CENTER_OFFSET, 5),                           // uint8 module index, float32 millimeters.
+	OFBC_CUSTOM(STAP_2AFC_TRIAL_OUTCOME),                          // Trial fields, counted feed times, excursion type, counted signal samples.
+	OFBC_FIXED(FR_TASK_TRIAL, 29, 2),                              // uint16 version, uint16 trial, float64 serial date, trial fields.
+
+	OFBC_CUSTOM(SCOPE_TRACE),                                      // uint16 version, named float64 parameters, uint64 samples, uint8 signals, float32 samples.
+};
+
+#undef OFBC_FIXED
+#undef OFBC_STR8
+#undef OFBC_STR16
+#undef OFBC_COUNTED
+#undef OFBC_CUSTOM
+#undef OFBC_UNDEFINED
+
+const size_t OFBC_NUM_BLOCK_LAYOUTS = sizeof(OFBC_BLOCK_LAYOUTS) / sizeof(OFBC_BLOCK_LAYOUTS[0]);
+const uint8_t OFBC_NO_LAYOUT = 0xFF;
+
+
+//Dense code-to-table-index lookup, built at compile time.
+constexpr std::array<uint8_t, OFBC_LOOKUP_RANGE> ofbc_build_layout_index()
+{
+	std::array<uint8_t, OFBC_LOOKUP_RANGE> index {};
+	for (size_t i = 0; i < index.size(); i++) {
+		index[i] = OFBC_NO_LAYOUT;
+	}
+	for (size_t i = 0; i < OFBC_NUM_BLOCK_LAYOUTS; i++) {
+		index[OFBC_BLOCK_LAYOUTS[i].code] = (uint8_t) i;
+	}
+	return index;
+}
+
+constexpr bool ofbc_layout_table_is_valid()
+{
+	if (OFBC_NUM_BLOCK_LAYOUTS >= OFBC_NO_LAYOUT) {
+		return false;
+	}
+	for (size_t i = 0; i < OFBC_NUM_BLOCK_LAYOUTS; i++) {
+		if (OFBC_BLOCK_LAYOUTS[i].code >= OFBC_LOOKUP_RANGE) {
+			return false;
+		}
+		for (size_t j = i + 1; j < OFBC_NUM_BLOCK_LAYOUTS; j++) {
+			if (OFBC_BLOCK_LAYOUTS[i].code == OFBC_BLOCK_LAYOUTS[j].code) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static_assert(ofbc_layout_table_is_valid(), "OFBC_BLOCK_LAYOUTS has a duplicate or out-of-range block code.");
+
+constexpr std::array<uint8_t, OFBC_LOOKUP_RANGE> OFBC_LAYOUT_INDEX = ofbc_build_layout_index();
+
+
+//Returns the layout entry for a block code, or nullptr if the code isn't tabled.
+constexpr const OFBC_Block_Layout *ofbc_find_layout(uint16_t code)
+{
+	if (code >= OFBC_LOOKUP_RANGE || OFBC_LAYOUT_INDEX[code] == OFBC_NO_LAYOUT) {
+		return nullptr;
+	}
+	return &OFBC_BLOCK_LAYOUTS[OFBC_LAYOUT_INDEX[code]];
+}
+
+//Returns the definition name for a block code, or nullptr if the code isn't tabled.
+constexpr const char *ofbc_block_name(uint16_t code)
+{
+	const OFBC_Block_Layout *layout = ofbc_find_layout(code);
+	return layout ? layout->name : nullptr;
+}
+
+//Returns the payload size of a fixed-size block code, or -1 if the size depends on the payload.
+constexpr int32_t ofbc_fixed_payload_size(uint16_t code)
+{
+	const OFBC_Block_Layout *layout = ofbc_find_layout(code);
+	return (layout && layout->rule == OFBC_RULE_FIXED) ? (int32_t) layout->fixed : -1;
+}
+
+
+//Bounds-checked little-endian reader over a partially visible payload.
+class OFBC_Payload_Cursor {
+
+	public:
+
+		OFBC_Payload_Cursor(const uint8_t *payload, uint64_t avail)
+			: _p(payload), _avail(avail) {}
+
+		uint64_t pos = 0;                                          // Current offset into the payload.
+		uint64_t need = 0;                                         // Bytes required to continue, set when a read fails.
+
+		bool skip(uint64_t n)
+		{
+			if (n > _avail || pos > _avail - n) {
+				need = (n > UINT64_MAX - pos) ? UINT64_MAX : pos + n;
+				return false;
+			}
+			pos += n;
+			return true;
+		}
+
+		template <typename T> bool read(T &value)
+		{
+			uint64_t at = pos;
+			if (!skip(sizeof(T))) {
+				return false;
+			}
+			memcpy(&value, _p + at, sizeof(T));
+			return true;
+		}
+
+		//Peeks at a byte "ahead" bytes past the cursor without moving it.
+		bool peek_u8(uint64_t ahead, uint8_t &value)
+		{
+			uint64_t save = pos;
+			bool ok = skip(ahead) && read(value);
+			pos = save;
+			return ok;
+		}
+
+		//Skips "count" elements of "elem_size" bytes, guarding against overflow.
+		bool skip_array(uint64_t count, uint64_t elem_size)
+		{
+			if (elem_size != 0 && count > UINT64_MAX / elem_size) {
+				need = UINT64_MAX;
+				return false;
+			}
+			return skip(count * elem_size);
+		}
+
+		OFBC_Size_Result more() const
+		{
+			return {OFBC_SIZE_NEED_MORE, need};
+		}
+
+		OFBC_Size_Result done() const
+		{
+			return {OFBC_SIZE_OK, pos};
+		}
+
+	private:
+
+		const uint8_t *_p;
+		uint64_t _avail;
+};
+
+
+//Block-specific size functions for the OFBC_RULE_CUSTOM entries.
+inline OFBC_Size_Result ofbc_size_clock_sync(OFBC_Payload_Cursor &c)
+{
+	uint8_t ver, port, mask;
+	if (!c.read(ver)) return c.more();
+	if (ver != 1) return {OFBC_SIZE_BAD_VERSION, 0};
+	if (!c.read(port) || !c.read(mask)) return c.more();
+	if (mask & ~0x07) return {OFBC_SIZE_INVALID, 0};
+	if ((mask & 0x01) && !c.skip(8)) return c.more();              // float64 serial date.
+	if ((mask & 0x02) && !c.skip(4)) return c.more();              // uint32 millis.
+	if ((mask & 0x04) && !c.skip(4)) return c.more();              // uint32 micros.
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_primary_module(OFBC_Payload_Cursor &c)
+{
+	uint8_t n, first;
+	if (!c.read(n)) return c.more();
+	if (n > 0) {
+		if (!c.peek_u8(0, first)) return c.more();
+		if (first == 0) {                                          // Early files used a uint16 character count.
+			uint16_t n16 = n;
+			if (!c.skip(1)) return c.more();
+			if (!c.skip(n16)) return c.more();
+			return c.done();
+		}
+	}
+	if (!c.skip(n)) return c.more();
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_renamed_file(OFBC_Payload_Cursor &c)
+{
+	uint16_t n;
+	if (!c.skip(8)) return c.more();                               // float64 serial date.
+	if (!c.read(n) || !c.skip(n)) return c.more();                 // Old filename.
+	if (!c.read(n) || !c.skip(n)) return c.more();                 // New filename.
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_download_system(OFBC_Payload_Cursor &c)
+{
+	uint8_t n;
+	if (!c.read(n) || !c.skip(n)) return c.more();                 // Computer name.
+	if (!c.read(n) || !c.skip(n)) return c.more();                 // COM port.
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_spectro_trace(OFBC_Payload_Cursor &c)
+{
+	uint32_t n;
+	uint16_t reps;
+	if (!c.skip(25) || !c.read(n) || !c.read(reps)) return c.more();
+	if (!c.skip_array((uint64_t) n * reps, 8)) return c.more();
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_ttl_pulsetrain(OFBC_Payload_Cursor &c)
+{
+	uint8_t ver, mask;
+	if (!c.read(ver)) return c.more();
+	if (ver == 1) {                                                // float64 date, uint8 channel, float32 volts, uint32 duration.
+		if (!c.skip(17)) return c.more();
+		return c.done();
+	}
+	if (ver != 2) return {OFBC_SIZE_BAD_VERSION, 0};
+	if (!c.skip(2) || !c.read(mask)) return c.more();              // uint8 source, uint8 channel, uint8 bitmask.
+	if (mask & 0x80) return {OFBC_SIZE_INVALID, 0};
+	const uint8_t field_size[7] = {8, 4, 4, 4, 4, 4, 2};
+	for (uint8_t i = 0; i < 7; i++) {
+		if ((mask & (1 << i)) && !c.skip(field_size[i])) return c.more();
+	}
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_ttl_pulsetrain_abort(OFBC_Payload_Cursor &c)
+{
+	uint8_t ver, mask;
+	if (!c.read(ver)) return c.more();
+	if (ver != 1) return {OFBC_SIZE_BAD_VERSION, 0};
+	if (!c.skip(2) || !c.read(mask)) return c.more();              // uint8 source, uint8 channel, uint8 bitmask.
+	if (mask & ~0x03) return {OFBC_SIZE_INVALID, 0};
+	if ((mask & 0x01) && !c.skip(8)) return c.more();              // float64 serial date.
+	if ((mask & 0x02) && !c.skip(4)) return c.more();              // uint32 millis.
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_mototrak_outcome(OFBC_Payload_Cursor &c)
+{
+	uint16_t pre_n;
+	uint8_t n, num_signals;
+	if (!c.skip(7) || !c.read(pre_n) || !c.skip(12)) return c.more();  // Trial, start, outcome, pre-N, hit-N, post-N, thresholds.
+	if (!c.read(n) || !c.skip_array(n, 4)) return c.more();        // Secondary hit thresholds.
+	if (!c.read(n) || !c.skip_array(n, 4)) return c.more();        // Hit times.
+	if (!c.read(n) || (n > 0 && !c.skip(4))) return c.more();      // Trigger time.
+	if (!c.read(num_signals)) return c.more();
+	if (!c.skip_array(pre_n, 4 + 2 * (uint64_t) num_signals)) return c.more();
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_mototrak_signal(OFBC_Payload_Cursor &c)
+{
+	uint8_t num_signals;
+	uint16_t pre_n, hitwin_n, post_n;
+	if (!c.skip(2) || !c.read(num_signals)) return c.more();
+	if (!c.read(pre_n) || !c.read(hitwin_n) || !c.read(post_n)) return c.more();
+	if (!c.skip_array((uint64_t) hitwin_n + post_n, 4 + 2 * (uint64_t) num_signals)) return c.more();
+	return c.done();
+}
+
+//Shared tail of the trial outcome blocks: uint8 signals, uint32 N, N uint32 times, then signals x N samples.
+inline OFBC_Size_Result ofbc_size_trial_signals(OFBC_Payload_Cursor &c, uint64_t first_signal_size = 4)
+{
+	uint8_t num_signals;
+	uint32_t n;
+	if (!c.read(num_signals) || !c.read(n)) return c.more();
+	if (!c.skip_array(n, 4)) return c.more();
+	if (first_signal_size != 4) {                                  // First signal stored at a different width.
+		if (!c.skip_array(n, first_signal_size)) return c.more();
+		num_signals = (num_signals > 0) ? num_signals - 1 : 0;
+	}
+	if (!c.skip_array((uint64_t) n * num_signals, 4)) return c.more();
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_size_vibration_trial(OFBC_Payload_Cursor &c, bool versioned)
+{
+	uint8_t n;
+	if (versioned) {
+		uint16_t ver;
+		if (!c.read(ver)) return c.more();
+		if (ver != 1) return {OFBC_SIZE_BAD_VERSION, 0};
+	}
+	if (!c.skip(11)) return c.more();                              // uint16 trial, float64 start, char outcome.
+	if (!c.read(n) || !c.skip_array(n, 8)) return c.more();        // Feed times.
+	if (!c.skip(8 * 4)) return c.more();                           // 8x float32 trial parameters.
+	if (!c.skip(versioned ? 3 * 2 : 4 * 2)) return c.more();       // uint16 trial parameters.
+	if (!c.skip(4)) return c.more();                               // uint32 pre-samples.
+	return ofbc_size_trial_signals(c);
+}
+
+inline OFBC_Size_Result ofbc_size_led_detection_trial(OFBC_Payload_Cursor &c)
+{
+	uint8_t n;
+	if (!c.skip(15)) return c.more();                              // uint16 trial, float64 start, uint32 millis, char outcome.
+	if (!c.read(n) || !c.skip_array(n, 8)) return c.more();        // Feed times.
+	if (!c.skip(4 + 2 + 3 * 4)) return c.more();                   // Hit window, light source index/PWM, durations.
+	return ofbc_size_trial_signals(c, 2);
+}
+
+inline OFBC_Size_Result ofbc_size_sttc_trial(OFBC_Payload_Cursor &c)
+{
+	uint8_t n;
+	if (!c.skip(16)) return c.more();                              // uint16 trial, float64 start, uint32 millis, 2x char.
+	if (!c.read(n) || !c.skip_array(n, 8)) return c.more();        // Feed times.
+	if (!c.skip(5 * 4 + 1)) return c.more();                       // 5x float32 durations, uint8 pad index.
+	if (!c.read(n) || !c.skip(n)) return c.more();                 // Pad label.
+	return ofbc_size_trial_signals(c);
+}
+
+inline OFBC_Size_Result ofbc_size_stap_trial(OFBC_Payload_Cursor &c)
+{
+	uint16_t t;
+	uint8_t n, first;
+	if (!c.read(t)) return c.more();
+	if (t == 0xFFFF) return {OFBC_SIZE_UNDEFINED_LAYOUT, 0};       // Newer layout with per-session parameter lists.
+	if (!c.skip(14)) return c.more();                              // float64 start, uint32 millis, 2x char.
+	if (!c.read(n) || !c.skip_array(n, 8)) return c.more();        // Feed times.
+	if (!c.skip(5 * 4)) return c.more();                           // 5x float32 durations.
+	if (!c.peek_u8(4, n) || (n > 0 && !c.peek_u8(5, first))) return c.more();
+	if (n == 0 || first != 'C') {                                  // Early files have no movement start time.
+		if (!c.skip(4)) return c.more();
+	}
+	if (!c.read(n) || !c.skip(n)) return c.more();                 // Excursion type.
+	if (!c.skip(2 * 4)) return c.more();                           // float32 amplitude, float32 speed.
+	return ofbc_size_trial_signals(c);
+}
+
+inline OFBC_Size_Result ofbc_size_scope_trace(OFBC_Payload_Cursor &c)
+{
+	uint16_t ver;
+	uint8_t num_fields, n, num_signals;
+	uint64_t num_samples;
+	if (!c.read(ver)) return c.more();
+	if (ver != 1) return {OFBC_SIZE_BAD_VERSION, 0};
+	if (!c.read(num_fields)) return c.more();
+	for (uint8_t i = 0; i < num_fields; i++) {                     // Named float64 parameters.
+		if (!c.read(n) || !c.skip((uint64_t) n + 8)) return c.more();
+	}
+	if (!c.read(num_samples) || !c.read(num_signals)) return c.more();
+	if (num_samples > UINT64_MAX / 4 / ((uint64_t) num_signals + 1)) return {OFBC_SIZE_INVALID, 0};
+	if (!c.skip_array(num_samples * ((uint64_t) num_signals + 1), 4)) return c.more();
+	return c.done();
+}
+
+//Packed sample batch: uint8 version, uint8 ID, uint8 channels C, uint8 samples N, float64 serial date,
+//uint32 first timestamp, int32 first delta, uint8 timestamp width, C uint8 value widths, C int32
+//first values, then N-2 timestamp and C x (N-1) value fields of those widths, padded to a byte.
+inline OFBC_Size_Result ofbc_size_packed_samples(OFBC_Payload_Cursor &c)
+{
+	uint8_t ver, num_channels, num_samples, width;
+	if (!c.read(ver)) return c.more();
+	if (ver != 1) return {OFBC_SIZE_BAD_VERSION, 0};
+	if (!c.skip(1) || !c.read(num_channels) || !c.read(num_samples)) return c.more();
+	if (num_samples == 0) return {OFBC_SIZE_INVALID, 0};
+	if (!c.skip(8 + 4 + 4) || !c.read(width)) return c.more();
+	if (width > 32) return {OFBC_SIZE_INVALID, 0};
+	uint64_t bits = (num_samples > 2) ? (uint64_t) (num_samples - 2) * width : 0;
+	for (uint8_t i = 0; i < num_channels; i++) {
+		if (!c.read(width)) return c.more();
+		if (width > 32) return {OFBC_SIZE_INVALID, 0};
+		bits += (uint64_t) (num_samples - 1) * width;
+	}
+	if (!c.skip_array(num_channels, 4) || !c.skip((bits + 7) / 8)) return c.more();
+	return c.done();
+}
+
+inline OFBC_Size_Result ofbc_custom_payload_size(uint16_t code, OFBC_Payload_Cursor &c)
+{
+	switch (code) {
+		case OFBC_CLOCK_SYNC:							return ofbc_size_clock_sync(c);
+		case OFBC_PRIMARY_MODULE:						return ofbc_size_primary_module(c);
+		case OFBC_RENAMED_FILE:							return ofbc_size_renamed_file(c);
+		case OFBC_DOWNLOAD_SYSTEM:						return ofbc_size_download_system(c);
+		case OFBC_SPECTRO_TRACE:						return ofbc_size_spectro_trace(c);
+		case OFBC_TTL_PULSETRAIN:						return ofbc_size_ttl_pulsetrain(c);
+		case OFBC_TTL_PULSETRAIN_ABORT:					return ofbc_size_ttl_pulsetrain_abort(c);
+		case OFBC_MOTOTRAK_V3P0_OUTCOME:				return ofbc_size_mototrak_outcome(c);
+		case OFBC_MOTOTRAK_V3P0_SIGNAL:					return ofbc_size_mototrak_signal(c);
+		case OFBC_VIBRATION_TASK_TRIAL_OUTCOME:			return ofbc_size_vibration_trial(c, false);
+		case OFBC_VIBROTACTILE_DETECTION_TASK_TRIAL:	return ofbc_size_vibration_trial(c, true);
+		case OFBC_LED_DETECTION_TASK_TRIAL_OUTCOME:		return ofbc_size_led_detection_trial(c);
+		case OFBC_STTC_2AFC_TRIAL_OUTCOME:				return ofbc_size_sttc_trial(c);
+		case OFBC_STAP_2AFC_TRIAL_OUTCOME:				return ofbc_size_stap_trial(c);
+		case OFBC_SCOPE_TRACE:							return ofbc_size_scope_trace(c);
+		case OFBC_AMBULATION_XY_THETA_PACKED:
+		case OFBC_ALSPT19_LIGHT_PACKED:
+		case OFBC_POKE_BITMASK_PACKED:
+		case OFBC_CAPSENSE_VALUE_PACKED:				return ofbc_size_packed_samples(c);
+	}
+	return {OFBC_SIZE_UNDEFINED_LAYOUT, 0};
+}
+
+
+//Computes the payload size of a block from however much of its payload is visible.
+inline OFBC_Size_Result ofbc_payload_size(const OFBC_Block_Layout &layout, const uint8_t *payload, uint64_t avail)
+{
+	OFBC_Payload_Cursor c(payload, avail);
+	if (layout.version_bytes > 0) {                                // Leading version field.
+		uint16_t ver = 0;
+		if (layout.version_bytes == 1) {
+			uint8_t ver8;
+			if (!c.read(ver8)) return c.more();
+			ver = ver8;
+		}
+		else if (!c.read(ver)) {
+			return c.more();
+		}
+		if (ver != 1) return {OFBC_SIZE_BAD_VERSION, 0};
+		c.pos = 0;
+	}
+	switch (layout.rule) {
+		case OFBC_RULE_FIXED:
+			return {OFBC_SIZE_OK, layout.fixed};
+		case OFBC_RULE_COUNTED: {
+			uint32_t count = 0;
+			if (!c.skip(layout.fixed - layout.count_bytes)) return c.more();
+			if (layout.count_bytes == 1) {
+				uint8_t n;
+				if (!c.read(n)) return c.more();
+				count = n;
+			}
+			else if (layout.count_bytes == 2) {
+				uint16_t n;
+				if (!c.read(n)) return c.more();
+				count = n;
+			}
+			else if (!c.read(count)) {
+				return c.more();
+			}
+			return {OFBC_SIZE_OK, layout.fixed + (uint64_t) count * layout.elem_size};
+		}
+		case OFBC_RULE_CUSTOM:
+			return ofbc_custom_payload_size(layout.code, c);
+		case OFBC_RULE_UNDEFINED:
+			break;
+	}
+	return {OFBC_SIZE_UNDEFINED_LAYOUT, 0};
+}
+
+inline OFBC_Size_Result ofbc_payload_size(uint16_t code, const uint8_t *payload, uint64_t avail)
+{
+	const OFBC_Block_Layout *layout = ofbc_find_layout(code);
+	if (!layout) {
+		return {OFBC_SIZE_UNKNOWN_CODE, 0};
+	}
+	return ofbc_payload_size(*layout, payload, avail);
+}
+
+#endif                                                             // #ifndef _VULINTUS_OFBC_BLOCK_SIZES_H_
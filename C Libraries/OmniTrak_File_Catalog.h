@@ -0,0 +1,119 @@
+/*
+	OmniTrak_File_Catalog.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Header-Only Catalog Reader
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Reads just enough of an *.OmniTrak file to catalog it: the subject name,
+	the system type, and the session start time. Like OmniTrakFileRead(...,
+	'header') in MATLAB, reading stops as soon as SUBJECT_NAME, SYSTEM_TYPE,
+	and either CLOCK_FILE_START or MS_FILE_START have all been read, so only
+	the first few hundred bytes of most files are ever touched.
+
+		OmniTrak_Catalog_Entry entry;
+		if (omnitrak_read_catalog("session.OmniTrak", entry)) { ... entry.subject ... }
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_CATALOG_H_
+#define _VULINTUS_OMNITRAK_FILE_CATALOG_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "OmniTrak_File_Reader.h"
+
+const size_t OMNITRAK_CATALOG_READ_SIZE = 16384;                   // Bytes read per attempt; doubled while the header blocks run past it.
+
+
+//Header fields of one *.OmniTrak file.
+struct OmniTrak_Catalog_Entry {
+	uint16_t file_version = 0;
+	std::string subject;
+	bool has_subject = false;
+	uint8_t system_type = 0;
+	bool has_system_type = false;
+	std::string system_name;                                       // SYSTEM_NAME, if it appears before the header is complete.
+	double start_datenum = 0;                                      // CLOCK_FILE_START serial date number.
+	bool has_start_datenum = false;
+	uint32_t start_millis = 0;                                     // MS_FILE_START device clock.
+	bool has_start_millis = false;
+	bool complete = false;                                         // True if all of the header fields were found.
+	OmniTrak_Read_Status status = OMNITRAK_READ_OK;                // Why reading stopped, if the header is incomplete.
+};
+
+
+//Reads the header fields of an *.OmniTrak file, returning false if the file can't be opened or isn't an *.OmniTrak file.
+inline bool omnitrak_read_catalog(const char *path, OmniTrak_Catalog_Entry &entry)
+{
+	entry = OmniTrak_Catalog_Entry();
+	FILE *fp = fopen(path, "rb");
+	if (!fp) {
+		return false;
+	}
+	std::vector<uint8_t> buf;
+	size_t want = OMNITRAK_CATALOG_READ_SIZE;
+	bool at_eof = false;
+	for (;;) {
+		size_t have = buf.size();                                  // Extend the buffer; parsing restarts from the header.
+		buf.resize(want);
+		buf.resize(have + fread(buf.data() + have, 1, want - have, fp));
+		at_eof = buf.size() < want;
+
+		entry = OmniTrak_Catalog_Entry();
+		OmniTrak_Block_Reader reader(buf.data(), buf.size());
+		if (reader.status() == OMNITRAK_READ_BAD_HEADER) {
+			fclose(fp);
+			entry.status = OMNITRAK_READ_BAD_HEADER;
+			return false;
+		}
+		entry.file_version = reader.file_version();
+		OmniTrak_Block_View blk;
+		while (!entry.complete && reader.next(blk)) {
+			switch (blk.code) {
+				case OFBC_SUBJECT_NAME:
+					entry.subject.assign((const char *) blk.payload + 2, blk.payload_size - 2);
+					entry.has_subject = true;
+					break;
+				case OFBC_SYSTEM_TYPE:
+					entry.system_type = blk.payload[0];
+					entry.has_system_type = true;
+					break;
+				case OFBC_SYSTEM_NAME:
+					entry.system_name.assign((const char *) blk.payload + 1, blk.payload_size - 1);
+					break;
+				case OFBC_CLOCK_FILE_START:
+					entry.start_datenum = blk.get<double>(0);
+					entry.has_start_datenum = true;
+					break;
+				case OFBC_MS_FILE_START:
+					entry.start_millis = blk.get<uint32_t>(0);
+					entry.has_start_millis = true;
+					break;
+			}
+			entry.complete = entry.has_subject && entry.has_system_type && (entry.has_start_datenum || entry.has_start_millis);
+		}
+		entry.status = entry.complete ? OMNITRAK_READ_OK : reader.status();
+		bool cut_off = entry.status == OMNITRAK_READ_TRUNCATED || entry.status == OMNITRAK_READ_MARKED_INCOMPLETE;
+		if (entry.complete || !cut_off || at_eof) {
+			break;
+		}
+		want *= 2;                                                 // The buffer ended mid-block; read further.
+	}
+	fclose(fp);
+	return true;
+}
+
+inline bool omnitrak_read_catalog(const std::string &path, OmniTrak_Catalog_Entry &entry)
+{
+	return omnitrak_read_catalog(path.c_str(), entry);
+}
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_CATALOG_H_
@@ -0,0 +1,568 @@
+/*
+	OmniTrak_File_Clock.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Clock Alignment
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Turns the device millis() and micros() timestamps in an *.OmniTrak file
+	into 64-bit unwrapped device time and into serial date numbers, local or
+	UTC. OmniTrak_Time_Base::build() makes one pass over the file's blocks:
+
+	  - Both 32-bit clocks are unwrapped as they go, using the order of the
+	    timestamps and the MS_TIMER_ROLLOVER / US_TIMER_ROLLOVER markers
+	    (which also catch a rollover hidden by a long gap between blocks).
+	    A block stamped just before a rollover but written just after it is
+	    kept in the earlier epoch.
+	  - CLOCK_SYNC, NTP_SYNC (UTC), and CLOCK_FILE_START with MS_FILE_START
+	    give sync points pairing device time with a serial date number.
+	    CLOCK_SYNC blocks with millis and micros but no date tie the
+	    microsecond clock to the millisecond one.
+	  - TIME_ZONE_OFFSET (or TIME_ZONE_OFFSET_HHMM) gives local - UTC.
+
+	Each clock's sync points, thinned to at least OMNITRAK_CLOCK_MIN_SEGMENT
+	apart so PC clock jitter doesn't turn into rate noise, become a
+	piecewise-linear map, so the device crystal's drift is corrected segment
+	by segment. unwrap() and to_datenum() then convert whole timestamp
+	columns (e.g. from OmniTrak_File_Columns.h, with their file_offset
+	column), using SSE2 where available.
+
+	omnitrak_merge_timelines() merges the per-file event times from several
+	files and devices into one time-ordered list with a k-way merge, so only
+	the small local disorder within each file is ever sorted.
+
+		OmniTrak_Time_Base clock;
+		clock.build(map.data(), map.size());
+		clock.unwrap(OMNITRAK_CLOCK_MILLIS, millis, offsets, n, ticks);
+		clock.to_datenum(OMNITRAK_CLOCK_MILLIS, ticks, n, utc, true);
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_CLOCK_H_
+#define _VULINTUS_OMNITRAK_FILE_CLOCK_H_
+
+#include <algorithm>
+#include <math.h>
+#include <queue>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "OmniTrak_File_Reader.h"
+#include "OmniTrak_File_Timestamps.h"
+
+#if !defined(OFBC_CLOCK_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+	#define OFBC_CLOCK_SIMD 1
+	#include <emmintrin.h>
+#else
+	#define OFBC_CLOCK_SIMD 0
+#endif
+
+const double OMNITRAK_CLOCK_MIN_SEGMENT = 60.0;                    // Seconds of device time between the sync points kept.
+const uint32_t OMNITRAK_CLOCK_MAX_DISORDER = 1u << 28;             // Largest step back, in ticks, taken as out-of-order blocks rather than a rollover.
+const double OMNITRAK_DATENUM_NTP_EPOCH = 693962.0;                // Serial date number of January 1, 1900 (NTP time 0).
+const double OMNITRAK_DATENUM_UNIX_EPOCH = 719529.0;               // Serial date number of January 1, 1970.
+
+enum OmniTrak_Clock : uint8_t {
+	OMNITRAK_CLOCK_MILLIS,                                         // Device millisecond clock.
+	OMNITRAK_CLOCK_MICROS,                                         // Device microsecond clock.
+};
+
+//A device clock reading paired with a serial date number (local time).
+struct OmniTrak_Sync_Point {
+	int64_t ticks;                                                 // Unwrapped device time.
+	double datenum;
+};
+
+inline double omnitrak_datenum_to_unix(double datenum)
+{
+	return (datenum - OMNITRAK_DATENUM_UNIX_EPOCH) * 86400.0;
+}
+
+
+//Unwraps one 32-bit device clock, in file order, and remembers where each epoch starts.
+class OmniTrak_Clock_Track {
+
+	public:
+
+		//Where unwrapping stands, so a later pass over appended blocks can carry on (see resume()).
+		struct State {
+			uint32_t epoch;
+			uint32_t last;
+			uint8_t flags;                                         // Bit 0: started, 1: marker pending, 2: recent wrap.
+		};
+
+		//Unwraps the timestamp of the block at "offset".
+		int64_t sample(uint32_t t, uint64_t offset)
+		{
+			if (!_started) {
+				_started = true;
+				_last = t;
+				return t;
+			}
+			uint32_t behind = _last - t;
+			if (behind != 0 && behind < OMNITRAK_CLOCK_MAX_DISORDER) {   // Stamped a little before the last sample.
+				if (t > _last && _epoch > 0) {                     // ...and before the rollover that came between them.
+					_late.push_back(offset);
+					return current(t) - ((int64_t) 1 << 32);
+				}
+				return current(t);
+			}
+			if (_marker_pending && t >= _last && 0u - t < OMNITRAK_CLOCK_MAX_DISORDER) {
+				wrap(0, offset);                                   // Stamped just before the marked rollover: start the new
+				_late.push_back(offset);                           // epoch here, at its earliest time, and keep this block behind it.
+				return current(t) - ((int64_t) 1 << 32);
+			}
+			if (t < _last || _marker_pending) {                    // Ran past 0xFFFFFFFF, maybe during a long gap.
+				wrap(t, offset);
+				return current(t);
+			}
+			_last = t;
+			if (t >= 0x80000000u) {
+				_recent_wrap = false;                              // Too long ago for a marker to still be on its way.
+			}
+			return current(t);
+		}
+
+		//Records a rollover marker.
+		void marker()
+		{
+			if (!_started) {
+				return;
+			}
+			if (_recent_wrap) {                                    // Already seen in the timestamps.
+				_recent_wrap = false;
+			}
+			else {
+				_marker_pending = true;
+			}
+		}
+
+		//Epoch (number of rollovers) of the block at "offset".
+		uint32_t epoch_at(uint64_t offset) const
+		{
+			size_t i = std::upper_bound(_starts.begin(), _starts.end(), offset) - _starts.begin();
+			uint32_t epoch = (uint32_t) i;
+			if (epoch > 0 && std::binary_search(_late.begin(), _late.end(), offset)) {
+				epoch--;
+			}
+			return epoch;
+		}
+
+		State state() const
+		{
+			return {_epoch, _last, (uint8_t) (_started | (_marker_pending << 1) | (_recent_wrap << 2))};
+		}
+
+		//Carries on unwrapping from a saved state. epoch_starts() and late_blocks() then only
+		//list what's seen from here on.
+		void resume(const State &state)
+		{
+			*this = OmniTrak_Clock_Track();
+			_epoch = state.epoch;
+			_last = state.last;
+			_started = state.flags & 1;
+			_marker_pending = state.flags & 2;
+			_recent_wrap = state.flags & 4;
+		}
+
+		const std::vector<uint64_t> &epoch_starts() const { return _starts; }   // File offset where each rollover was first seen.
+		const std::vector<uint64_t> &late_blocks() const { return _late; }
+
+	private:
+
+		int64_t current(uint32_t t) const
+		{
+			return ((int64_t) _epoch << 32) + t;
+		}
+
+		void wrap(uint32_t t, uint64_t offset)
+		{
+			_epoch++;
+			_starts.push_back(offset);
+			_recent_wrap = !_marker_pending;
+			_marker_pending = false;
+			_last = t;
+		}
+
+		std::vector<uint64_t> _starts;
+		std::vector<uint64_t> _late;
+		uint32_t _epoch = 0;
+		uint32_t _last = 0;
+		bool _started = false;
+		bool _marker_pending = false;                              // A marker arrived before the timestamps showed the rollover.
+		bool _recent_wrap = false;                                 // The timestamps showed a rollover its marker hasn't followed yet.
+};
+
+
+//Piecewise-linear map from unwrapped device time to serial date numbers.
+class OmniTrak_Clock_Map {
+
+	public:
+
+		//Builds the map from sync points in any order, keeping points at least "min_span" ticks apart.
+		void build(std::vector<OmniTrak_Sync_Point> points, double ticks_per_day, double min_span)
+		{
+			_ticks_per_day = ticks_per_day;
+			_knots.clear();
+			std::sort(points.begin(), points.end(),
+				[](const OmniTrak_Sync_Point &a, const OmniTrak_Sync_Point &b) { return a.ticks < b.ticks; });
+			for (size_t i = 0; i < points.size(); i++) {
+				bool last = (i + 1 == points.size());
+				if (_knots.empty() || (double) (points[i].ticks - _knots.back().ticks) >= min_span) {
+					_knots.push_back(points[i]);
+				}
+				else if (last && _knots.size() > 1) {
+					_knots.back() = points[i];                     // Always end on the last sync point.
+				}
+			}
+			_slopes.resize(_knots.size());
+			for (size_t k = 0; k < _knots.size(); k++) {
+				if (k + 1 < _knots.size()) {
+					_slopes[k] = (_knots[k + 1].datenum - _knots[k].datenum) / (double) (_knots[k + 1].ticks - _knots[k].ticks);
+				}
+				else {
+					_slopes[k] = (k > 0) ? _slopes[k - 1] : 1.0 / ticks_per_day;
+				}
+			}
+		}
+
+		bool valid() const { return !_knots.empty(); }
+		const std::vector<OmniTrak_Sync_Point> &knots() const { return _knots; }
+
+		//Maps one unwrapped device time (NaN if there are no sync points).
+		double map(int64_t ticks, double shift = 0) const
+		{
+			if (_knots.empty()) {
+				return NAN;
+			}
+			size_t k = segment(ticks, 0);
+			return _knots[k].datenum + shift + _slopes[k] * (double) (ticks - _knots[k].ticks);
+		}
+
+		//Maps a column of unwrapped device times, adding "shift" days to each.
+		void map(const int64_t *ticks, size_t n, double *out, double shift = 0) const
+		{
+			if (_knots.empty()) {
+				for (size_t i = 0; i < n; i++) {
+					out[i] = NAN;
+				}
+				return;
+			}
+			size_t k = 0;
+			size_t i = 0;
+#if OFBC_CLOCK_SIMD
+			for (; i + 2 <= n; i += 2) {
+				k = segment(ticks[i], k);
+				if (segment(ticks[i + 1], k) != k || ticks[i] < 0 || ticks[i + 1] < 0) {
+					out[i] = map_in(ticks[i], k, shift);
+					out[i + 1] = map_in(ticks[i + 1], segment(ticks[i + 1], k), shift);
+					continue;
+				}
+				__m128i x = _mm_loadu_si128((const __m128i *) (ticks + i));   // Exact int64 -> double below 2^52.
+				__m128d xd = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(x, _mm_castpd_si128(_mm_set1_pd(4503599627370496.0)))),
+					_mm_set1_pd(4503599627370496.0));
+				__m128d y = _mm_add_pd(_mm_set1_pd(_knots[k].datenum + shift),
+					_mm_mul_pd(_mm_set1_pd(_slopes[k]), _mm_sub_pd(xd, _mm_set1_pd((double) _knots[k].ticks))));
+				_mm_storeu_pd(out + i, y);
+			}
+#endif
+			for (; i < n; i++) {
+				k = segment(ticks[i], k);
+				out[i] = map_in(ticks[i], k, shift);
+			}
+		}
+
+	private:
+
+		double map_in(int64_t ticks, size_t k, double shift) const
+		{
+			return _knots[k].datenum + shift + _slopes[k] * (double) (ticks - _knots[k].ticks);
+		}
+
+		//Segment holding "ticks", searching from "hint" (columns are close to sorted).
+		size_t segment(int64_t ticks, size_t hint) const
+		{
+			size_t k = hint;
+			while (k + 1 < _knots.size() && ticks >= _knots[k + 1].ticks) {
+				k++;
+			}
+			while (k > 0 && ticks < _knots[k].ticks) {
+				k--;
+			}
+			return k;
+		}
+
+		std::vector<OmniTrak_Sync_Point> _knots;
+		std::vector<double> _slopes;                               // Days per tick from each knot to the next.
+		double _ticks_per_day = 86400e3;
+};
+
+
+//Adds "add" to a column of uint32 values, widening them to int64.
+inline void ofbc_widen_add(const uint32_t *raw, size_t n, int64_t add, int64_t *out)
+{
+	size_t i = 0;
+#if OFBC_CLOCK_SIMD
+	__m128i offset = _mm_set1_epi64x(add);
+	for (; i + 4 <= n; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (raw + i));
+		__m128i lo = _mm_unpacklo_epi32(x, _mm_setzero_si128());
+		__m128i hi = _mm_unpackhi_epi32(x, _mm_setzero_si128());
+		_mm_storeu_si128((__m128i *) (out + i), _mm_add_epi64(lo, offset));
+		_mm_storeu_si128((__m128i *) (out + i + 2), _mm_add_epi64(hi, offset));
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = add + raw[i];
+	}
+}
+
+
+class OmniTrak_Time_Base {
+
+	public:
+
+		//Makes one pass over an in-memory file's blocks. Returns false if the file header is
+		//missing; otherwise whatever was read before any bad block is used (see status()).
+		bool build(const uint8_t *data, uint64_t size)
+		{
+			*this = OmniTrak_Time_Base();
+			OmniTrak_Block_Reader reader(data, size);
+			_status = reader.status();
+			if (_status == OMNITRAK_READ_BAD_HEADER) {
+				return false;
+			}
+			std::vector<OmniTrak_Sync_Point> ms_points, us_points, ntp_points;
+			std::vector<std::pair<int64_t, int64_t>> ms_us_pairs;          // Millis and micros read at the same moment.
+			bool has_file_start = false, has_ms_start = false;
+			double file_start = 0;
+			int64_t ms_start = 0;
+
+			OmniTrak_Block_View blk;
+			while (reader.next(blk)) {
+				switch (blk.code) {
+					case OFBC_MS_TIMER_ROLLOVER:
+						_ms.marker();
+						continue;
+					case OFBC_US_TIMER_ROLLOVER:
+						_us.marker();
+						continue;
+					case OFBC_CLOCK_SYNC:
+						read_clock_sync(blk, ms_points, us_points, ms_us_pairs);
+						continue;
+					case OFBC_CLOCK_FILE_START:
+						file_start = blk.get<double>(0);
+						has_file_start = true;
+						continue;
+					case OFBC_TIME_ZONE_OFFSET:
+						_time_zone = blk.get<double>(0);
+						_has_time_zone = true;
+						continue;
+					case OFBC_TIME_ZONE_OFFSET_HHMM: {
+						int8_t hours = (int8_t) blk.payload[0];
+						double minutes = blk.payload[1];
+						_time_zone = (hours + (hours < 0 ? -minutes : minutes) / 60.0) / 24.0;
+						_has_time_zone = true;
+						continue;
+					}
+				}
+				OFBC_Timestamp ts = ofbc_block_timestamp(blk.code, blk.payload, blk.payload_size);
+				if (ts.type == OFBC_TIME_MILLIS) {
+					int64_t ticks = _ms.sample((uint32_t) ts.value, blk.offset);
+					if (blk.code == OFBC_MS_FILE_START) {
+						ms_start = ticks;
+						has_ms_start = true;
+					}
+					else if (blk.code == OFBC_NTP_SYNC) {
+						ntp_points.push_back({ticks, OMNITRAK_DATENUM_NTP_EPOCH + blk.get<uint32_t>(0) / 86400.0});
+					}
+				}
+				else if (ts.type == OFBC_TIME_MICROS) {
+					_us.sample((uint32_t) ts.value, blk.offset);
+				}
+			}
+			if (reader.status() != OMNITRAK_READ_END) {
+				_status = reader.status();
+			}
+
+			if (has_file_start && has_ms_start) {
+				ms_points.push_back({ms_start, file_start});
+			}
+			for (const OmniTrak_Sync_Point &p : ntp_points) {           // NTP time is UTC.
+				ms_points.push_back({p.ticks, p.datenum + _time_zone});
+			}
+			_ms_map.build(ms_points, 86400e3, OMNITRAK_CLOCK_MIN_SEGMENT * 1e3);
+			if (_ms_map.valid()) {
+				for (const std::pair<int64_t, int64_t> &pair : ms_us_pairs) {
+					us_points.push_back({pair.second, _ms_map.map(pair.first)});
+				}
+			}
+			_us_map.build(us_points, 86400e6, OMNITRAK_CLOCK_MIN_SEGMENT * 1e6);
+			return true;
+		}
+
+		//Unwraps a column of raw 32-bit timestamps, given the file offsets of their blocks in
+		//file order (as in the timestamp and file_offset columns of a column file).
+		void unwrap(OmniTrak_Clock clock, const uint32_t *raw, const uint64_t *offsets, size_t n, int64_t *out) const
+		{
+			const OmniTrak_Clock_Track &track = (clock == OMNITRAK_CLOCK_MILLIS) ? _ms : _us;
+			const std::vector<uint64_t> &starts = track.epoch_starts();
+			size_t i = 0;
+			while (i < n) {                                        // One run per epoch.
+				size_t e = std::upper_bound(starts.begin(), starts.end(), offsets[i]) - starts.begin();
+				size_t end = n;
+				if (e < starts.size()) {
+					end = std::lower_bound(offsets + i, offsets + n, starts[e]) - offsets;
+				}
+				ofbc_widen_add(raw + i, end - i, (int64_t) e << 32, out + i);
+				i = end;
+			}
+			for (uint64_t late : track.late_blocks()) {           // Stamped before a rollover, written after it.
+				const uint64_t *at = std::lower_bound(offsets, offsets + n, late);
+				if (at != offsets + n && *at == late) {
+					out[at - offsets] -= (int64_t) 1 << 32;
+				}
+			}
+		}
+
+		//Unwraps one raw timestamp from the block at "offset".
+		int64_t unwrap(OmniTrak_Clock clock, uint32_t raw, uint64_t offset) const
+		{
+			const OmniTrak_Clock_Track &track = (clock == OMNITRAK_CLOCK_MILLIS) ? _ms : _us;
+			return ((int64_t) track.epoch_at(offset) << 32) + raw;
+		}
+
+		//Converts unwrapped device times to serial date numbers, local or UTC (NaN if the clock
+		//has no sync points).
+		void to_datenum(OmniTrak_Clock clock, const int64_t *ticks, size_t n, double *out, bool utc = false) const
+		{
+			map_for(clock).map(ticks, n, out, utc ? -_time_zone : 0);
+		}
+
+		double to_datenum(OmniTrak_Clock clock, int64_t ticks, bool utc = false) const
+		{
+			return map_for(clock).map(ticks, utc ? -_time_zone : 0);
+		}
+
+		//Converts a local serial date number (such as a block's own datenum timestamp) to UTC.
+		double local_to_utc(double datenum) const { return datenum - _time_zone; }
+
+		const std::vector<OmniTrak_Sync_Point> &sync_points(OmniTrak_Clock clock) const { return map_for(clock).knots(); }
+		const OmniTrak_Clock_Track &track(OmniTrak_Clock clock) const { return (clock == OMNITRAK_CLOCK_MILLIS) ? _ms : _us; }
+		bool has_time_zone() const { return _has_time_zone; }     // Without one, UTC is taken to be local time.
+		double time_zone() const { return _time_zone; }           // Local - UTC, in days.
+		OmniTrak_Read_Status status() const { return _status; }   // Why the pass stopped before the end, if it did.
+
+	private:
+
+		void read_clock_sync(const OmniTrak_Block_View &blk, std::vector<OmniTrak_Sync_Point> &ms_points,
+			std::vector<OmniTrak_Sync_Point> &us_points, std::vector<std::pair<int64_t, int64_t>> &ms_us_pairs)
+		{
+			uint8_t mask = blk.payload[2];
+			uint64_t at = 3;
+			double datenum = 0;
+			int64_t ms = 0, us = 0;
+			if (mask & 0x01) {
+				datenum = blk.get<double>(at);
+				at += 8;
+			}
+			if (mask & 0x02) {
+				ms = _ms.sample(blk.get<uint32_t>(at), blk.offset);
+				at += 4;
+			}
+			if (mask & 0x04) {
+				us = _us.sample(blk.get<uint32_t>(at), blk.offset);
+			}
+			if ((mask & 0x03) == 0x03) {
+				ms_points.push_back({ms, datenum});
+			}
+			if ((mask & 0x05) == 0x05) {
+				us_points.push_back({us, datenum});
+			}
+			else if ((mask & 0x06) == 0x06) {
+				ms_us_pairs.push_back({ms, us});
+			}
+		}
+
+		const OmniTrak_Clock_Map &map_for(OmniTrak_Clock clock) const
+		{
+			return (clock == OMNITRAK_CLOCK_MILLIS) ? _ms_map : _us_map;
+		}
+
+		OmniTrak_Clock_Track _ms;
+		OmniTrak_Clock_Track _us;
+		OmniTrak_Clock_Map _ms_map;
+		OmniTrak_Clock_Map _us_map;
+		double _time_zone = 0;
+		bool _has_time_zone = false;
+		OmniTrak_Read_Status _status = OMNITRAK_READ_OK;
+};
+
+
+//One event on a merged timeline.
+struct OmniTrak_Timeline_Event {
+	double time;
+	uint32_t source;                                               // Index of the source it came from.
+	uint64_t index;                                                // Index within that source.
+};
+
+//A source's event times, in file order (nearly, but not always exactly, sorted).
+struct OmniTrak_Timeline_Source {
+	const double *times;
+	size_t n;
+};
+
+//Merges the events of several sources into one time-ordered list. Each source is put in
+//order with an insertion sort, which costs next to nothing on file-ordered times, then the
+//sources are k-way merged. Ties keep source order, then file order. NaN times are left out.
+inline void omnitrak_merge_timelines(const std::vector<OmniTrak_Timeline_Source> &sources, std::vector<OmniTrak_Timeline_Event> &out)
+{
+	std::vector<std::vector<uint64_t>> orders(sources.size());
+	size_t total = 0;
+	for (size_t s = 0; s < sources.size(); s++) {
+		const double *t = sources[s].times;
+		std::vector<uint64_t> &order = orders[s];
+		order.reserve(sources[s].n);
+		for (uint64_t i = 0; i < sources[s].n; i++) {
+			if (isnan(t[i])) {
+				continue;
+			}
+			size_t j = order.size();
+			order.push_back(i);
+			while (j > 0 && t[order[j - 1]] > t[i]) {
+				order[j] = order[j - 1];
+				j--;
+			}
+			order[j] = i;
+		}
+		total += order.size();
+	}
+
+	typedef std::pair<double, std::pair<uint32_t, size_t>> Head;   // Time, then source and position in its order.
+	std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+	for (uint32_t s = 0; s < (uint32_t) sources.size(); s++) {
+		if (!orders[s].empty()) {
+			heads.push({sources[s].times[orders[s][0]], {s, 0}});
+		}
+	}
+	out.clear();
+	out.reserve(total);
+	while (!heads.empty()) {
+		Head head = heads.top();
+		heads.pop();
+		uint32_t s = head.second.first;
+		size_t at = head.second.second;
+		out.push_back({head.first, s, orders[s][at]});
+		if (++at < orders[s].size()) {
+			heads.push({sources[s].times[orders[s][at]], {s, at}});
+		}
+	}
+}
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_CLOCK_H_
@@ -0,0 +1,585 @@
+/*
+	OmniTrak_File_Columns.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Columnar Export (*.otkcol)
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Converts an *.OmniTrak file into one directory of typed, contiguous
+	column files per session, one set of columns per block family. Families
+	with a schema in OFBC_COLUMN_SCHEMAS (below) are split into their named
+	fields, e.g. BME280_TEMP_FL.millis (uint32) and BME280_TEMP_FL.value
+	(float32), or MLX90640_PIXELS_TO.pixels (768 float32 per row, raw sensor
+	order). Other fixed-size blocks are written as a single "payload" column
+	of raw payload bytes, and variable-size blocks as Arrow-style "payload"
+	bytes plus "payload_offsets" (uint64, rows + 1 entries). Every family
+	also gets a "file_offset" column (uint64) pointing back to the source
+	block.
+
+	Each column file is a 64-byte header followed by the values, so the data
+	is 64-byte aligned and can be memory-mapped directly (see
+	OmniTrak_Column_File), or wrapped as Arrow buffers without copying:
+		char[8]  "OTKCOL\0\1"
+		uint16   block code
+		uint8    value type (OFBC_Column_Type)
+		uint8    reserved
+		uint32   values per row
+		uint64   rows
+		char[32] field name (NUL-padded)
+		uint8[8] reserved
+
+		OmniTrak_Column_Converter converter;
+		if (!converter.convert("session.OmniTrak", "session_columns")) { ... converter.error() ... }
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_COLUMNS_H_
+#define _VULINTUS_OMNITRAK_FILE_COLUMNS_H_
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "OmniTrak_File_Reader.h"
+
+const char OMNITRAK_COLUMN_MAGIC[8] = {'O', 'T', 'K', 'C', 'O', 'L', 0, 1};
+const uint64_t OMNITRAK_COLUMN_HEADER_SIZE = 64;
+const uint64_t OMNITRAK_COLUMN_FLUSH_SIZE = 1 << 20;              // Most bytes buffered per column before appending to disk.
+const char *const OMNITRAK_COLUMN_EXTENSION = ".otkcol";
+
+
+//Column value types.
+enum OFBC_Column_Type : uint8_t {
+	OFBC_COL_U8,
+	OFBC_COL_I8,
+	OFBC_COL_U16,
+	OFBC_COL_I16,
+	OFBC_COL_U32,
+	OFBC_COL_I32,
+	OFBC_COL_U64,
+	OFBC_COL_I64,
+	OFBC_COL_F32,
+	OFBC_COL_F64,
+	OFBC_COL_CHAR,
+};
+
+constexpr uint8_t ofbc_column_type_size(OFBC_Column_Type type)
+{
+	switch (type) {
+		case OFBC_COL_U8: case OFBC_COL_I8: case OFBC_COL_CHAR:	return 1;
+		case OFBC_COL_U16: case OFBC_COL_I16:					return 2;
+		case OFBC_COL_U32: case OFBC_COL_I32: case OFBC_COL_F32:	return 4;
+		case OFBC_COL_U64: case OFBC_COL_I64: case OFBC_COL_F64:	return 8;
+	}
+	return 0;
+}
+
+inline const char *ofbc_column_type_name(OFBC_Column_Type type)
+{
+	static const char *const names[] = {"uint8", "int8", "uint16", "int16", "uint32", "int32",
+		"uint64", "int64", "float32", "float64", "char"};
+	return type <= OFBC_COL_CHAR ? names[type] : "unknown";
+}
+
+
+//One field of a fixed-size block: "count" consecutive values starting at a payload offset.
+struct OFBC_Column_Field {
+	const char *name;
+	OFBC_Column_Type type;
+	uint16_t offset;
+	uint16_t count;
+};
+
+//The fields a block family is split into.
+struct OFBC_Column_Schema {
+	uint16_t code;
+	const OFBC_Column_Field *fields;
+	uint8_t num_fields;
+};
+
+
+//Field sets shared by several block families.
+constexpr OFBC_Column_Field OFBC_COLS_ID_MS_F32[] = {             // uint8 ID, uint32 millis, float32 value.
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"value", OFBC_COL_F32, 5, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_ID_MS_I16[] = {             // uint8 ID, uint32 millis, int16 value.
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"value", OFBC_COL_I16, 5, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_ID_MS_U16[] = {             // uint8 ID, uint32 millis, uint16 value.
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"value", OFBC_COL_U16, 5, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_ID_MS_XYZ[] = {             // uint8 ID, uint32 millis, 3x float32.
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"xyz", OFBC_COL_F32, 5, 3}};
+constexpr OFBC_Column_Field OFBC_COLS_MS_U16[] = {                // uint32 millis, uint16 reading.
+	{"millis", OFBC_COL_U32, 0, 1}, {"value", OFBC_COL_U16, 4, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_MS_I16[] = {                // uint32 millis, int16 reading.
+	{"millis", OFBC_COL_U32, 0, 1}, {"value", OFBC_COL_I16, 4, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_MS[] = {                    // uint32 millis.
+	{"millis", OFBC_COL_U32, 0, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_FEED_MS[] = {               // uint8 dispenser, uint32 millis, uint16 feedings.
+	{"dispenser", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"num_feedings", OFBC_COL_U16, 5, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_FEED_DATENUM[] = {          // uint8 dispenser, float64 serial date, uint16 feedings.
+	{"dispenser", OFBC_COL_U8, 0, 1}, {"datenum", OFBC_COL_F64, 1, 1}, {"num_feedings", OFBC_COL_U16, 9, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_BITMASK[] = {               // uint8 version, float64 serial date, float32 micros, uint8 sensors, uint8 bitmask.
+	{"datenum", OFBC_COL_F64, 1, 1}, {"micros", OFBC_COL_F32, 9, 1}, {"num_sensors", OFBC_COL_U8, 13, 1},
+	{"bitmask", OFBC_COL_U8, 14, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_CAPSENSE_VALUE[] = {        // OFBC_COLS_BITMASK, uint8 sensor index, uint16 value.
+	{"datenum", OFBC_COL_F64, 1, 1}, {"micros", OFBC_COL_F32, 9, 1}, {"num_sensors", OFBC_COL_U8, 13, 1},
+	{"bitmask", OFBC_COL_U8, 14, 1}, {"sensor", OFBC_COL_U8, 15, 1}, {"value", OFBC_COL_U16, 16, 1}};
+
+//Field sets for individual block families.
+constexpr OFBC_Column_Field OFBC_COLS_NTP_SYNC[] = {
+	{"ntp", OFBC_COL_U32, 0, 1}, {"millis", OFBC_COL_U32, 4, 1}, {"rollovers", OFBC_COL_U8, 8, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_BATTERY_STATUS[] = {
+	{"millis", OFBC_COL_U32, 0, 1}, {"readings", OFBC_COL_U16, 4, 7}};
+constexpr OFBC_Column_Field OFBC_COLS_AMBULATION_XY_THETA[] = {
+	{"micros", OFBC_COL_U32, 1, 1}, {"path_xy", OFBC_COL_F32, 5, 2}, {"orientation", OFBC_COL_F32, 13, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_BH1749_RGB[] = {
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"channels", OFBC_COL_U16, 5, 5}};
+constexpr OFBC_Column_Field OFBC_COLS_AMG8833_PIXELS_FL[] = {
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"pixels", OFBC_COL_F32, 5, 64}};
+constexpr OFBC_Column_Field OFBC_COLS_AMG8833_PIXELS_INT[] = {
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"pixels", OFBC_COL_I16, 5, 64}};
+constexpr OFBC_Column_Field OFBC_COLS_HTPA32X32_PIXELS_FP62[] = {
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"pixels", OFBC_COL_U8, 5, 1024}};
+constexpr OFBC_Column_Field OFBC_COLS_HTPA32X32_PIXELS_INT_K[] = {
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"pixels", OFBC_COL_U16, 5, 1024}};
+constexpr OFBC_Column_Field OFBC_COLS_HTPA32X32_PIXELS_INT12_C[] = {
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"pixels_packed", OFBC_COL_U8, 5, 1536}};
+constexpr OFBC_Column_Field OFBC_COLS_MLX90640_PIXELS_FL[] = {
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"pixels", OFBC_COL_F32, 5, 768}};
+constexpr OFBC_Column_Field OFBC_COLS_MLX90640_PIXELS_INT[] = {
+	{"id", OFBC_COL_U8, 0, 1}, {"millis", OFBC_COL_U32, 1, 1}, {"frame", OFBC_COL_U16, 5, 834}};
+constexpr OFBC_Column_Field OFBC_COLS_PELLET_DISPENSE[] = {
+	{"millis", OFBC_COL_U32, 0, 1}, {"dispenser", OFBC_COL_U8, 4, 1}, {"trial", OFBC_COL_U16, 5, 1}};
+constexpr OFBC_Column_Field OFBC_COLS_POSITION_MOVE_XY[] = {
+	{"millis", OFBC_COL_U32, 0, 1}, {"index", OFBC_COL_U8, 4, 1}, {"xy", OFBC_COL_F32, 5, 2}};
+constexpr OFBC_Column_Field OFBC_COLS_POSITION_MOVE_XYZ[] = {
+	{"millis", OFBC_COL_U32, 0, 1}, {"index", OFBC_COL_U8, 4, 1}, {"xyz", OFBC_COL_F32, 5, 3}};
+constexpr OFBC_Column_Field OFBC_COLS_FR_TASK_TRIAL[] = {
+	{"trial", OFBC_COL_U16, 2, 1}, {"datenum", OFBC_COL_F64, 4, 1}, {"outcome", OFBC_COL_CHAR, 12, 1},
+	{"target_poke", OFBC_COL_U8, 13, 1}, {"thresh", OFBC_COL_U8, 14, 1}, {"poke_count", OFBC_COL_U16, 15, 1},
+	{"hit_time", OFBC_COL_F32, 17, 1}, {"reward_dur", OFBC_COL_F32, 21, 1}, {"num_licks", OFBC_COL_U16, 25, 1},
+	{"num_feedings", OFBC_COL_U16, 27, 1}};
+
+#define OFBC_SCHEMA(def, cols)		{OFBC_##def, cols, (uint8_t) (sizeof(cols) / sizeof(cols[0]))}
+
+//Column schemas, by block code.
+constexpr OFBC_Column_Schema OFBC_COLUMN_SCHEMAS[] = {
+	OFBC_SCHEMA(NTP_SYNC, OFBC_COLS_NTP_SYNC),
+	OFBC_SCHEMA(BATTERY_SOC, OFBC_COLS_MS_U16),
+	OFBC_SCHEMA(BATTERY_VOLTS, OFBC_COLS_MS_U16),
+	OFBC_SCHEMA(BATTERY_CURRENT, OFBC_COLS_MS_I16),
+	OFBC_SCHEMA(BATTERY_FULL, OFBC_COLS_MS_U16),
+	OFBC_SCHEMA(BATTERY_REMAIN, OFBC_COLS_MS_U16),
+	OFBC_SCHEMA(BATTERY_POWER, OFBC_COLS_MS_I16),
+	OFBC_SCHEMA(BATTERY_SOH, OFBC_COLS_MS_I16),
+	OFBC_SCHEMA(BATTERY_STATUS, OFBC_COLS_BATTERY_STATUS),
+	OFBC_SCHEMA(AMBULATION_XY_THETA, OFBC_COLS_AMBULATION_XY_THETA),
+	OFBC_SCHEMA(AMG8833_THERM_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(AMG8833_THERM_INT, OFBC_COLS_ID_MS_I16),
+	OFBC_SCHEMA(AMG8833_PIXELS_FL, OFBC_COLS_AMG8833_PIXELS_FL),
+	OFBC_SCHEMA(AMG8833_PIXELS_INT, OFBC_COLS_AMG8833_PIXELS_INT),
+	OFBC_SCHEMA(HTPA32X32_PIXELS_FP62, OFBC_COLS_HTPA32X32_PIXELS_FP62),
+	OFBC_SCHEMA(HTPA32X32_PIXELS_INT_K, OFBC_COLS_HTPA32X32_PIXELS_INT_K),
+	OFBC_SCHEMA(HTPA32X32_AMBIENT_TEMP, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(HTPA32X32_PIXELS_INT12_C, OFBC_COLS_HTPA32X32_PIXELS_INT12_C),
+	OFBC_SCHEMA(BH1749_RGB, OFBC_COLS_BH1749_RGB),
+	OFBC_SCHEMA(BME280_TEMP_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(BMP280_TEMP_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(BME680_TEMP_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(BME280_PRES_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(BMP280_PRES_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(BME680_PRES_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(BME280_HUM_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(BME680_HUM_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(BME680_GAS_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(VL53L0X_DIST, OFBC_COLS_ID_MS_I16),
+	OFBC_SCHEMA(SGP30_EC02, OFBC_COLS_ID_MS_U16),
+	OFBC_SCHEMA(SGP30_TVOC, OFBC_COLS_ID_MS_U16),
+	OFBC_SCHEMA(MLX90640_PIXELS_TO, OFBC_COLS_MLX90640_PIXELS_FL),
+	OFBC_SCHEMA(MLX90640_PIXELS_IM, OFBC_COLS_MLX90640_PIXELS_FL),
+	OFBC_SCHEMA(MLX90640_PIXELS_INT, OFBC_COLS_MLX90640_PIXELS_INT),
+	OFBC_SCHEMA(ALSPT19_LIGHT, OFBC_COLS_ID_MS_U16),
+	OFBC_SCHEMA(ZMOD4410_READING_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(ZMOD4410_READING_INT, OFBC_COLS_ID_MS_U16),
+	OFBC_SCHEMA(LSM303_ACC_FL, OFBC_COLS_ID_MS_XYZ),
+	OFBC_SCHEMA(LSM303_MAG_FL, OFBC_COLS_ID_MS_XYZ),
+	OFBC_SCHEMA(LSM303_TEMP_FL, OFBC_COLS_ID_MS_F32),
+	OFBC_SCHEMA(PELLET_DISPENSE, OFBC_COLS_PELLET_DISPENSE),
+	OFBC_SCHEMA(HARD_PAUSE_START, OFBC_COLS_MS),
+	OFBC_SCHEMA(HARD_PAUSE_STOP, OFBC_COLS_MS),
+	OFBC_SCHEMA(SOFT_PAUSE_START, OFBC_COLS_MS),
+	OFBC_SCHEMA(SOFT_PAUSE_STOP, OFBC_COLS_MS),
+	OFBC_SCHEMA(POSITION_MOVE_XY, OFBC_COLS_POSITION_MOVE_XY),
+	OFBC_SCHEMA(POSITION_MOVE_XYZ, OFBC_COLS_POSITION_MOVE_XYZ),
+	OFBC_SCHEMA(REMOTE_MANUAL_FEED, OFBC_COLS_FEED_MS),
+	OFBC_SCHEMA(HWUI_MANUAL_FEED, OFBC_COLS_FEED_DATENUM),
+	OFBC_SCHEMA(FW_RANDOM_FEED, OFBC_COLS_FEED_MS),
+	OFBC_SCHEMA(FW_OPERANT_FEED, OFBC_COLS_FEED_MS),
+	OFBC_SCHEMA(SWUI_MANUAL_FEED, OFBC_COLS_FEED_DATENUM),
+	OFBC_SCHEMA(SW_RANDOM_FEED, OFBC_COLS_FEED_DATENUM),
+	OFBC_SCHEMA(SW_OPERANT_FEED, OFBC_COLS_FEED_DATENUM),
+	OFBC_SCHEMA(POKE_BITMASK, OFBC_COLS_BITMASK),
+	OFBC_SCHEMA(CAPSENSE_BITMASK, OFBC_COLS_BITMASK),
+	OFBC_SCHEMA(CAPSENSE_VALUE, OFBC_COLS_CAPSENSE_VALUE),
+	OFBC_SCHEMA(FR_TASK_TRIAL, OFBC_COLS_FR_TASK_TRIAL),
+};
+
+#undef OFBC_SCHEMA
+
+//Checks that every schema belongs to a fixed-size block and every field fits inside its payload.
+constexpr bool ofbc_column_schemas_fit()
+{
+	for (const OFBC_Column_Schema &schema : OFBC_COLUMN_SCHEMAS) {
+		const OFBC_Block_Layout *layout = ofbc_find_layout(schema.code);
+		if (layout == nullptr || layout->rule != OFBC_RULE_FIXED) {
+			return false;
+		}
+		for (uint8_t i = 0; i < schema.num_fields; i++) {
+			const OFBC_Column_Field &f = schema.fields[i];
+			if ((uint32_t) f.offset + (uint32_t) f.count * ofbc_column_type_size(f.type) > layout->fixed) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+static_assert(ofbc_column_schemas_fit(), "OFBC_COLUMN_SCHEMAS field runs past a block payload");
+
+inline const OFBC_Column_Schema *ofbc_find_column_schema(uint16_t code)
+{
+	for (const OFBC_Column_Schema &schema : OFBC_COLUMN_SCHEMAS) {
+		if (schema.code == code) {
+			return &schema;
+		}
+	}
+	return nullptr;
+}
+
+
+//Fixed-size header at the start of every column file.
+struct OmniTrak_Column_Header {
+	char magic[8];
+	uint16_t code;
+	uint8_t type;
+	uint8_t reserved1;
+	uint32_t count;                                                // Values per row.
+	uint64_t rows;
+	char name[32];
+	uint8_t reserved2[8];
+};
+static_assert(sizeof(OmniTrak_Column_Header) == OMNITRAK_COLUMN_HEADER_SIZE, "column header must be 64 bytes");
+
+
+//Appends rows to one column file, buffering writes and patching the row count on finish().
+class OmniTrak_Column_Writer {
+
+	public:
+
+		bool create(const std::string &path, uint16_t code, const char *name, OFBC_Column_Type type, uint32_t count)
+		{
+			_path = path;
+			memset(&_header, 0, sizeof(_header));
+			memcpy(_header.magic, OMNITRAK_COLUMN_MAGIC, 8);
+			_header.code = code;
+			_header.type = type;
+			_header.count = count;
+			strncpy(_header.name, name, sizeof(_header.name) - 1);
+			_row_bytes = (uint64_t) count * ofbc_column_type_size(type);
+			_buffer.clear();
+			return write_header("wb");
+		}
+
+		void append(const void *values)
+		{
+			buffer((const uint8_t *) values, _row_bytes);
+			_header.rows++;
+		}
+
+		//Appends raw bytes to a uint8 column (one row per byte).
+		void append_bytes(const void *bytes, uint64_t n)
+		{
+			buffer((const uint8_t *) bytes, n);
+			_header.rows += n;
+		}
+
+		//Writes any buffered rows and the final row count. Returns false if any write failed.
+		bool finish()
+		{
+			flush();
+			return write_header("r+b") && _ok;
+		}
+
+		uint64_t rows() const { return _header.rows; }
+		const std::string &path() const { return _path; }
+
+	private:
+
+		//Buffers "n" bytes. The buffer grows as rows arrive, so sparse columns stay small,
+		//and is flushed before it would grow past OMNITRAK_COLUMN_FLUSH_SIZE.
+		void buffer(const uint8_t *p, uint64_t n)
+		{
+			if (_buffer.size() + n > OMNITRAK_COLUMN_FLUSH_SIZE) {
+				flush();
+				if (n > OMNITRAK_COLUMN_FLUSH_SIZE) {
+					write(p, n);                                   // Too big to buffer; write it straight through.
+					return;
+				}
+			}
+			if (_buffer.size() + n > _buffer.capacity()) {
+				_buffer.reserve((size_t) std::min(std::max<uint64_t>(2 * _buffer.capacity(), _buffer.size() + n), OMNITRAK_COLUMN_FLUSH_SIZE));
+			}
+			_buffer.insert(_buffer.end(), p, p + n);
+		}
+
+		void flush()
+		{
+			write(_buffer.data(), _buffer.size());
+			_buffer.clear();
+		}
+
+		//Appends bytes to the file. The file is only held open while writing, so a
+		//conversion with hundreds of columns doesn't run out of file descriptors.
+		void write(const uint8_t *p, uint64_t n)
+		{
+			if (n == 0) {
+				return;
+			}
+			FILE *fp = fopen(_path.c_str(), "ab");
+			_ok = _ok && fp && fwrite(p, 1, n, fp) == n;
+			if (fp) {
+				_ok = (fclose(fp) == 0) && _ok;
+			}
+		}
+
+		bool write_header(const char *mode)
+		{
+			FILE *fp = fopen(_path.c_str(), mode);
+			if (!fp) {
+				return _ok = false;
+			}
+			bool ok = fwrite(&_header, sizeof(_header), 1, fp) == 1;
+			return (fclose(fp) == 0) && ok;
+		}
+
+		std::string _path;
+		OmniTrak_Column_Header _header;
+		uint64_t _row_bytes = 0;
+		std::vector<uint8_t> _buffer;
+		bool _ok = true;
+};
+
+
+//Read-only, memory-mapped view of one column file.
+class OmniTrak_Column_File {
+
+	public:
+
+		bool open(const std::string &path)
+		{
+			if (!_map.open(path.c_str())) {
+				_error = _map.error();
+				return false;
+			}
+			if (_map.size() < OMNITRAK_COLUMN_HEADER_SIZE) {
+				return fail(path);
+			}
+			memcpy(&_header, _map.data(), sizeof(_header));
+			uint64_t row_bytes = (uint64_t) _header.count * ofbc_column_type_size((OFBC_Column_Type) _header.type);
+			if (memcmp(_header.magic, OMNITRAK_COLUMN_MAGIC, 8) != 0 || _header.type > OFBC_COL_CHAR
+					|| _map.size() != OMNITRAK_COLUMN_HEADER_SIZE + _header.rows * row_bytes) {
+				return fail(path);
+			}
+			return true;
+		}
+
+		//The column values, in row-major order ("count" values per row).
+		template <typename T> const T *values() const
+		{
+			return (const T *) (_map.data() + OMNITRAK_COLUMN_HEADER_SIZE);
+		}
+
+		uint16_t code() const { return _header.code; }
+		OFBC_Column_Type type() const { return (OFBC_Column_Type) _header.type; }
+		uint32_t count() const { return _header.count; }
+		uint64_t rows() const { return _header.rows; }
+		std::string name() const { return std::string(_header.name, strnlen(_header.name, sizeof(_header.name))); }
+		const std::string &error() const { return _error; }
+
+	private:
+
+		bool fail(const std::string &path)
+		{
+			_map.close();
+			_error = "\"" + path + "\" isn't a valid column file";
+			return false;
+		}
+
+		OmniTrak_File_Map _map;
+		OmniTrak_Column_Header _header {};
+		std::string _error;
+};
+
+
+//Converts one *.OmniTrak file into a directory of column files.
+class OmniTrak_Column_Converter {
+
+	public:
+
+		//Converts "source" into "out_dir" (created if needed), first removing any column files
+		//left there by an earlier conversion. A file that ends on a truncated or unreadable
+		//block is still converted up to that block; see stop_status().
+		bool convert(const std::string &source, const std::string &out_dir)
+		{
+			_families = std::array<std::unique_ptr<Family>, OFBC_LOOKUP_RANGE>();
+			_blocks = 0;
+			_error.clear();
+			OmniTrak_File_Map map;
+			if (!map.open(source.c_str())) {
+				return fail(map.error());
+			}
+			std::error_code ec;
+			std::filesystem::create_directories(out_dir, ec);
+			if (ec) {
+				return fail("can't create \"" + out_dir + "\"");
+			}
+			OmniTrak_Block_Reader reader(map.data(), map.size());
+			if (reader.status() == OMNITRAK_READ_BAD_HEADER) {
+				return fail("\"" + source + "\" isn't an *.OmniTrak file");
+			}
+			if (!remove_columns(out_dir)) {
+				return fail("can't remove old column files from \"" + out_dir + "\"");
+			}
+			OmniTrak_Block_View blk;
+			while (reader.next(blk)) {
+				std::unique_ptr<Family> &family = _families[blk.code];   // The reader only returns codes below OFBC_LOOKUP_RANGE.
+				if (!family) {
+					family.reset(new Family);
+					if (!family->create(out_dir, blk.code)) {
+						return fail("can't create column files in \"" + out_dir + "\"");
+					}
+				}
+				family->append(blk);
+				_blocks++;
+			}
+			_stop_status = reader.status();
+			_stop_offset = reader.position();
+			bool ok = true;
+			for (std::unique_ptr<Family> &family : _families) {
+				if (family) {
+					ok = family->finish() && ok;
+				}
+			}
+			return ok ? true : fail("error writing column files in \"" + out_dir + "\"");
+		}
+
+		uint64_t blocks() const { return _blocks; }
+		OmniTrak_Read_Status stop_status() const { return _stop_status; }
+		uint64_t stop_offset() const { return _stop_offset; }
+		const std::string &error() const { return _error; }
+
+	private:
+
+		//Deletes the column files (not subdirectories or other files) directly inside "dir".
+		static bool remove_columns(const std::string &dir)
+		{
+			std::error_code ec;
+			for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+				if (it->path().extension() == OMNITRAK_COLUMN_EXTENSION && it->is_regular_file(ec)) {
+					std::filesystem::remove(it->path(), ec);
+				}
+			}
+			return !ec;
+		}
+
+		//The column writers for one block code.
+		class Family {
+
+			public:
+
+				bool create(const std::string &dir, uint16_t code)
+				{
+					_schema = ofbc_find_column_schema(code);
+					_layout = ofbc_find_layout(code);
+					std::string base = (std::filesystem::path(dir) / ofbc_block_name(code)).string() + ".";
+					bool ok = add(base, code, "file_offset", OFBC_COL_U64, 1);
+					if (_schema) {
+						for (uint8_t i = 0; i < _schema->num_fields; i++) {
+							const OFBC_Column_Field &f = _schema->fields[i];
+							ok = ok && add(base, code, f.name, f.type, f.count);
+						}
+					}
+					else if (_layout->rule == OFBC_RULE_FIXED) {
+						ok = ok && add(base, code, "payload", OFBC_COL_U8, _layout->fixed);
+					}
+					else {
+						ok = ok && add(base, code, "payload", OFBC_COL_U8, 1) && add(base, code, "payload_offsets", OFBC_COL_U64, 1);
+						uint64_t zero = 0;
+						_columns[2].append(&zero);
+					}
+					return ok;
+				}
+
+				void append(const OmniTrak_Block_View &blk)
+				{
+					_columns[0].append(&blk.offset);
+					if (_schema) {
+						for (uint8_t i = 0; i < _schema->num_fields; i++) {
+							_columns[i + 1].append(blk.payload + _schema->fields[i].offset);
+						}
+					}
+					else if (_layout->rule == OFBC_RULE_FIXED) {
+						_columns[1].append(blk.payload);
+					}
+					else {
+						_columns[1].append_bytes(blk.payload, blk.payload_size);
+						uint64_t end = _columns[1].rows();
+						_columns[2].append(&end);
+					}
+				}
+
+				bool finish()
+				{
+					bool ok = true;
+					for (OmniTrak_Column_Writer &column : _columns) {
+						ok = column.finish() && ok;
+					}
+					return ok;
+				}
+
+			private:
+
+				bool add(const std::string &base, uint16_t code, const char *name, OFBC_Column_Type type, uint32_t count)
+				{
+					_columns.emplace_back();
+					return _columns.back().create(base + name + OMNITRAK_COLUMN_EXTENSION, code, name, type, count);
+				}
+
+				const OFBC_Column_Schema *_schema = nullptr;
+				const OFBC_Block_Layout *_layout = nullptr;
+				std::vector<OmniTrak_Column_Writer> _columns;
+		};
+
+		bool fail(const std::string &msg)
+		{
+			_error = msg;
+			return false;
+		}
+
+		std::array<std::unique_ptr<Family>, OFBC_LOOKUP_RANGE> _families;
+		uint64_t _blocks = 0;
+		OmniTrak_Read_Status _stop_status = OMNITRAK_READ_OK;
+		uint64_t _stop_offset = 0;
+		std::string _error;
+};
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_COLUMNS_H_
@@ -0,0 +1,469 @@
+/*
+	OmniTrak_File_Index.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Sidecar Block Index (*.otkidx)
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Builds, in one pass over a memory-mapped *.OmniTrak file, a compact index
+	of every block's code, file offset, and primary timestamp (see
+	OmniTrak_File_Timestamps.h), grouped into one run per block code and
+	sorted by timestamp within each run. Queries such as "all
+	AMG8833_PIXELS_FL frames between t0 and t1" or "every FR_TASK_TRIAL
+	block" are then binary searches instead of a full-file decode.
+
+	millis() and micros() timestamps are unwrapped across clock rollovers
+	as they're indexed (see OmniTrak_Clock_Track in OmniTrak_File_Clock.h),
+	so they're stored and queried as epoch * 2^32 + the 32-bit value, and a
+	run stays in time order through any number of rollovers.
+
+	The index records the source file's size and modification time, plus
+	hashes of the file's first bytes and of the bytes just before the last
+	indexed block boundary. An index whose size and mtime still match is
+	used as-is. If the file has grown and both hashes still match, the new
+	blocks are indexed incrementally from the last boundary and merged in.
+	Anything else, including a same-size file with a new mtime, rejects the
+	index and it is rebuilt. So does an index file whose entry counts don't
+	add up to its size.
+
+		OmniTrak_File_Index index;
+		if (!index.open("session.OmniTrak")) { ... index.error() ... }
+		for (const OmniTrak_Index_Entry &e : index.blocks(OFBC_AMG8833_PIXELS_FL, t0, t1)) {
+			... e.offset() ...
+		}
+
+	Index file layout (little-endian):
+		char[8]  "OTKIDX\0\1"
+		uint32   format version (1)
+		uint32   number of runs
+		uint64   number of entries
+		uint64   source file size
+		int64    source file modification time
+		uint64   indexed bytes (offset just past the last indexed block)
+		uint64   hash of the source's first OMNITRAK_INDEX_HASH_SPAN bytes
+		uint64   hash of the OMNITRAK_INDEX_HASH_SPAN bytes before "indexed bytes"
+		uint8    reader status where indexing stopped, then 7 reserved bytes
+		2 x      clock unwrapping state (millis, then micros): uint32 epoch,
+		         uint32 last timestamp, uint8 flags, 7 reserved bytes
+		runs:    uint16 code, uint16 reserved, uint32 reserved, uint64 entry count
+		entries: uint64 time type (top 8 bits) and offset (low 56 bits), float64 time
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_INDEX_H_
+#define _VULINTUS_OMNITRAK_FILE_INDEX_H_
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "OmniTrak_File_Clock.h"
+#include "OmniTrak_File_Reader.h"
+#include "OmniTrak_File_Timestamps.h"
+
+const char OMNITRAK_INDEX_MAGIC[8] = {'O', 'T', 'K', 'I', 'D', 'X', 0, 1};
+const uint32_t OMNITRAK_INDEX_VERSION = 2;
+const uint64_t OMNITRAK_INDEX_HASH_SPAN = 4096;                    // Bytes covered by each of the head and tail hashes.
+const char *const OMNITRAK_INDEX_EXTENSION = ".otkidx";
+
+
+//One indexed block: file offset, timestamp type, and timestamp.
+struct OmniTrak_Index_Entry {
+
+	uint64_t packed;                                               // Timestamp type in the top 8 bits, file offset below.
+	double time;                                                   // Timestamp value (millis and micros unwrapped), or 0 for untimed blocks.
+
+	static OmniTrak_Index_Entry make(uint64_t offset, OFBC_Timestamp ts)
+	{
+		return {((uint64_t) ts.type << 56) | offset, ts.value};
+	}
+
+	uint64_t offset() const { return packed & 0x00FFFFFFFFFFFFFFULL; }
+	OFBC_Time_Type type() const { return (OFBC_Time_Type) (packed >> 56); }
+
+	//Run order: by timestamp type, then timestamp, then file offset.
+	bool operator<(const OmniTrak_Index_Entry &other) const
+	{
+		if (type() != other.type()) return type() < other.type();
+		if (time != other.time) return time < other.time;
+		return offset() < other.offset();
+	}
+};
+
+
+//A contiguous, sorted slice of one code's run.
+struct OmniTrak_Index_Range {
+
+	const OmniTrak_Index_Entry *first = nullptr;
+	const OmniTrak_Index_Entry *last = nullptr;
+
+	const OmniTrak_Index_Entry *begin() const { return first; }
+	const OmniTrak_Index_Entry *end() const { return last; }
+	size_t size() const { return (size_t) (last - first); }
+	bool empty() const { return first == last; }
+};
+
+
+//64-bit FNV-1a hash, used to detect in-place changes to the indexed part of a file.
+inline uint64_t omnitrak_index_hash(const uint8_t *data, uint64_t n)
+{
+	uint64_t h = 0xCBF29CE484222325ULL;
+	for (uint64_t i = 0; i < n; i++) {
+		h = (h ^ data[i]) * 0x100000001B3ULL;
+	}
+	return h;
+}
+
+
+class OmniTrak_File_Index {
+
+	public:
+
+		//Returns the sidecar index path for a source file ("x.OmniTrak" -> "x.otkidx").
+		static std::string sidecar_path(const std::string &source)
+		{
+			return std::filesystem::path(source).replace_extension(OMNITRAK_INDEX_EXTENSION).string();
+		}
+
+		//Loads the sidecar index if it still matches the source, bringing it up to date
+		//incrementally after appends or rebuilding it otherwise, and saves any changes.
+		bool open(const std::string &source)
+		{
+			std::string index_path = sidecar_path(source);
+			bool changed = true;
+			if (load(index_path) && stat_source(source)) {
+				if (_source_size == _file_size && _source_mtime == _file_mtime) {
+					changed = false;
+				}
+				else if (_file_size > _source_size ? !update(source) : !build(source)) {
+					return false;                                  // Only a grown file can be an append; same-size rewrites are rebuilt.
+				}
+			}
+			else if (!build(source)) {
+				return false;
+			}
+			return changed ? save(index_path) : true;
+		}
+
+		//Indexes the whole source file from scratch.
+		bool build(const std::string &source)
+		{
+			clear();
+			OmniTrak_File_Map map;
+			if (!map.open(source.c_str())) {
+				return fail(map.error());
+			}
+			if (!stat_source(source)) {
+				return false;
+			}
+			OmniTrak_Block_Reader reader(map.data(), map.size());
+			if (reader.status() == OMNITRAK_READ_BAD_HEADER) {
+				return fail("\"" + source + "\" isn't an *.OmniTrak file");
+			}
+			scan(reader, map.data(), map.size());
+			return true;
+		}
+
+		//Indexes blocks appended since the last build or update, or rebuilds the
+		//index if the already-indexed part of the file has changed.
+		bool update(const std::string &source)
+		{
+			OmniTrak_File_Map map;
+			if (!map.open(source.c_str())) {
+				return fail(map.error());
+			}
+			if (!stat_source(source)) {
+				return false;
+			}
+			if (!is_append_of_indexed(map.data(), map.size())) {
+				return build(source);
+			}
+			std::map<uint16_t, size_t> old_counts;
+			for (const auto &run : _runs) {
+				old_counts[run.first] = run.second.size();
+			}
+			OmniTrak_Block_Reader reader(map.data(), map.size(), _indexed_bytes);
+			scan(reader, map.data(), map.size());
+			for (auto &run : _runs) {                              // Merge each run's new, sorted tail into its old entries.
+				auto mid = run.second.begin() + (std::ptrdiff_t) old_counts[run.first];
+				std::inplace_merge(run.second.begin(), mid, run.second.end());
+			}
+			return true;
+		}
+
+		//Reads an index file without checking it against its source, rejecting it if its
+		//entry counts don't match its size.
+		bool load(const std::string &index_path)
+		{
+			clear();
+			std::error_code ec;
+			uint64_t index_size = std::filesystem::file_size(index_path, ec);
+			FILE *fp = ec ? nullptr : fopen(index_path.c_str(), "rb");
+			if (!fp) {
+				return fail("can't open \"" + index_path + "\"");
+			}
+			char magic[8];
+			uint32_t version = 0, num_runs = 0;
+			uint64_t num_entries = 0;
+			uint8_t status = 0, reserved[7];
+			bool ok = fread(magic, 1, 8, fp) == 8 && memcmp(magic, OMNITRAK_INDEX_MAGIC, 8) == 0
+				&& get(fp, version) && version == OMNITRAK_INDEX_VERSION
+				&& get(fp, num_runs) && get(fp, num_entries)
+				&& get(fp, _source_size) && get(fp, _source_mtime) && get(fp, _indexed_bytes)
+				&& get(fp, _head_hash) && get(fp, _tail_hash)
+				&& get(fp, status) && fread(reserved, 1, 7, fp) == 7
+				&& get_track(fp, _ms) && get_track(fp, _us);
+			std::vector<std::pair<uint16_t, uint64_t>> counts;
+			uint64_t total = 0;
+			for (uint32_t i = 0; ok && i < num_runs; i++) {
+				uint16_t code, pad16;
+				uint32_t pad32;
+				uint64_t count;
+				ok = get(fp, code) && get(fp, pad16) && get(fp, pad32) && get(fp, count)
+					&& count <= num_entries - total;
+				counts.emplace_back(code, count);
+				total += count;
+			}
+			long entries_start = ok ? ftell(fp) : -1;
+			ok = ok && total == num_entries && entries_start >= 0      // The entries must exactly fill the rest of the file.
+				&& num_entries <= index_size / sizeof(OmniTrak_Index_Entry)
+				&& index_size - (uint64_t) entries_start == num_entries * sizeof(OmniTrak_Index_Entry);
+			for (size_t i = 0; ok && i < counts.size(); i++) {
+				std::vector<OmniTrak_Index_Entry> &run = _runs[counts[i].first];
+				run.resize(counts[i].second);
+				ok = fread(run.data(), sizeof(OmniTrak_Index_Entry), run.size(), fp) == run.size();
+			}
+			fclose(fp);
+			if (!ok) {
+				clear();
+				return fail("\"" + index_path + "\" isn't a valid index file");
+			}
+			_stop_status = (OmniTrak_Read_Status) status;
+			return true;
+		}
+
+		//Writes the index file atomically (to a temporary file, then renamed over the old one).
+		bool save(const std::string &index_path) const
+		{
+			std::string tmp_path = index_path + ".tmp";
+			FILE *fp = fopen(tmp_path.c_str(), "wb");
+			if (!fp) {
+				return fail("can't create \"" + tmp_path + "\"");
+			}
+			uint8_t status = (uint8_t) _stop_status, reserved[7] = {0};
+			bool ok = fwrite(OMNITRAK_INDEX_MAGIC, 1, 8, fp) == 8
+				&& put(fp, OMNITRAK_INDEX_VERSION) && put(fp, (uint32_t) _runs.size())
+				&& put(fp, (uint64_t) num_entries())
+				&& put(fp, _source_size) && put(fp, _source_mtime) && put(fp, _indexed_bytes)
+				&& put(fp, _head_hash) && put(fp, _tail_hash)
+				&& put(fp, status) && fwrite(reserved, 1, 7, fp) == 7
+				&& put_track(fp, _ms) && put_track(fp, _us);
+			for (auto it = _runs.begin(); ok && it != _runs.end(); ++it) {
+				ok = put(fp, it->first) && put(fp, (uint16_t) 0) && put(fp, (uint32_t) 0) && put(fp, (uint64_t) it->second.size());
+			}
+			for (auto it = _runs.begin(); ok && it != _runs.end(); ++it) {
+				ok = fwrite(it->second.data(), sizeof(OmniTrak_Index_Entry), it->second.size(), fp) == it->second.size();
+			}
+			ok = (fclose(fp) == 0) && ok;
+			std::error_code ec;
+			if (ok) {
+				std::filesystem::rename(tmp_path, index_path, ec);
+			}
+			if (!ok || ec) {
+				std::filesystem::remove(tmp_path, ec);
+				return fail("can't write \"" + index_path + "\"");
+			}
+			return true;
+		}
+
+		//Every indexed block with the given code, in timestamp order.
+		OmniTrak_Index_Range blocks(uint16_t code) const
+		{
+			auto it = _runs.find(code);
+			if (it == _runs.end() || it->second.empty()) {
+				return {};
+			}
+			return {it->second.data(), it->second.data() + it->second.size()};
+		}
+
+		//Blocks with the given code and timestamp type whose timestamps fall within [t0, t1]
+		//(unwrapped ticks for millis and micros).
+		OmniTrak_Index_Range blocks(uint16_t code, OFBC_Time_Type type, double t0, double t1) const
+		{
+			OmniTrak_Index_Range all = blocks(code);
+			OmniTrak_Index_Entry lo = {((uint64_t) type << 56), t0};
+			OmniTrak_Index_Entry hi = {((uint64_t) type << 56) | 0x00FFFFFFFFFFFFFFULL, t1};
+			return {std::lower_bound(all.first, all.last, lo), std::upper_bound(all.first, all.last, hi)};
+		}
+
+		//Blocks with the given code whose timestamps fall within [t0, t1], using the code's usual timestamp type.
+		OmniTrak_Index_Range blocks(uint16_t code, double t0, double t1) const
+		{
+			const OFBC_Timestamp_Field *field = ofbc_find_timestamp_field(code);
+			OmniTrak_Index_Range all = blocks(code);
+			OFBC_Time_Type type = field ? field->type : (all.empty() ? OFBC_TIME_NONE : all.first->type());
+			return blocks(code, type, t0, t1);
+		}
+
+		std::vector<uint16_t> codes() const
+		{
+			std::vector<uint16_t> out;
+			for (const auto &run : _runs) {
+				out.push_back(run.first);
+			}
+			return out;
+		}
+
+		size_t num_entries() const
+		{
+			size_t n = 0;
+			for (const auto &run : _runs) {
+				n += run.second.size();
+			}
+			return n;
+		}
+
+		uint64_t indexed_bytes() const { return _indexed_bytes; }
+		OmniTrak_Read_Status stop_status() const { return _stop_status; }
+		const std::string &error() const { return _error; }
+
+	private:
+
+		void clear()
+		{
+			_runs.clear();
+			_source_size = 0;
+			_source_mtime = 0;
+			_indexed_bytes = 0;
+			_head_hash = 0;
+			_tail_hash = 0;
+			_stop_status = OMNITRAK_READ_OK;
+			_ms = OmniTrak_Clock_Track();
+			_us = OmniTrak_Clock_Track();
+		}
+
+		bool stat_source(const std::string &source)
+		{
+			std::error_code ec;
+			_file_size = std::filesystem::file_size(source, ec);
+			if (!ec) {
+				_file_mtime = (int64_t) std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+			}
+			if (ec) {
+				return fail("can't stat \"" + source + "\"");
+			}
+			return true;
+		}
+
+		//Indexes blocks from the reader's position to wherever it stops, appending a sorted tail
+		//to each run. "size" is the size of the mapped file the reader is reading; a stat taken
+		//after mapping may already include later appends.
+		void scan(OmniTrak_Block_Reader &reader, const uint8_t *data, uint64_t size)
+		{
+			std::map<uint16_t, size_t> starts;
+			OmniTrak_Block_View blk;
+			while (reader.next(blk)) {
+				if (blk.code == OFBC_MS_TIMER_ROLLOVER) {
+					_ms.marker();
+				}
+				else if (blk.code == OFBC_US_TIMER_ROLLOVER) {
+					_us.marker();
+				}
+				OFBC_Timestamp ts = ofbc_block_timestamp(blk.code, blk.payload, blk.payload_size);
+				if (ts.type == OFBC_TIME_MILLIS) {
+					ts.value = (double) _ms.sample((uint32_t) ts.value, blk.offset);
+				}
+				else if (ts.type == OFBC_TIME_MICROS) {
+					ts.value = (double) _us.sample((uint32_t) ts.value, blk.offset);
+				}
+				std::vector<OmniTrak_Index_Entry> &run = _runs[blk.code];
+				starts.emplace(blk.code, run.size());
+				run.push_back(OmniTrak_Index_Entry::make(blk.offset, ts));
+			}
+			for (const auto &start : starts) {
+				std::vector<OmniTrak_Index_Entry> &run = _runs[start.first];
+				std::stable_sort(run.begin() + (std::ptrdiff_t) start.second, run.end());
+			}
+			_indexed_bytes = reader.position();
+			_stop_status = reader.status();
+			_source_size = size;
+			_source_mtime = _file_mtime;
+			hash_indexed(data, _head_hash, _tail_hash);
+		}
+
+		void hash_indexed(const uint8_t *data, uint64_t &head, uint64_t &tail) const
+		{
+			uint64_t span = std::min(_indexed_bytes, OMNITRAK_INDEX_HASH_SPAN);
+			head = omnitrak_index_hash(data, span);
+			tail = omnitrak_index_hash(data + _indexed_bytes - span, span);
+		}
+
+		//True if the mapped file still holds the indexed bytes, unchanged, with only new data after them.
+		bool is_append_of_indexed(const uint8_t *data, uint64_t size) const
+		{
+			if (size <= _source_size || _indexed_bytes == 0 || _indexed_bytes > size) {
+				return false;
+			}
+			uint64_t head, tail;
+			hash_indexed(data, head, tail);
+			return head == _head_hash && tail == _tail_hash;
+		}
+
+		static bool get_track(FILE *fp, OmniTrak_Clock_Track &track)
+		{
+			OmniTrak_Clock_Track::State state;
+			uint8_t reserved[7];
+			if (!get(fp, state.epoch) || !get(fp, state.last) || !get(fp, state.flags) || fread(reserved, 1, 7, fp) != 7) {
+				return false;
+			}
+			track.resume(state);
+			return true;
+		}
+
+		static bool put_track(FILE *fp, const OmniTrak_Clock_Track &track)
+		{
+			OmniTrak_Clock_Track::State state = track.state();
+			uint8_t reserved[7] = {0};
+			return put(fp, state.epoch) && put(fp, state.last) && put(fp, state.flags) && fwrite(reserved, 1, 7, fp) == 7;
+		}
+
+		template <typename T> static bool get(FILE *fp, T &value)
+		{
+			return fread(&value, sizeof(T), 1, fp) == 1;
+		}
+
+		template <typename T> static bool put(FILE *fp, const T &value)
+		{
+			return fwrite(&value, sizeof(T), 1, fp) == 1;
+		}
+
+		bool fail(const std::string &msg) const
+		{
+			_error = msg;
+			return false;
+		}
+
+		std::map<uint16_t, std::vector<OmniTrak_Index_Entry>> _runs;
+		uint64_t _source_size = 0;                                 // Source size when last indexed.
+		int64_t _source_mtime = 0;                                 // Source modification time when last indexed.
+		uint64_t _indexed_bytes = 0;
+		uint64_t _head_hash = 0;
+		uint64_t _tail_hash = 0;
+		OmniTrak_Read_Status _stop_status = OMNITRAK_READ_OK;
+		OmniTrak_Clock_Track _ms;                                  // Unwraps millis() timestamps; carried over to update().
+		OmniTrak_Clock_Track _us;                                  // Unwraps micros() timestamps.
+		uint64_t _file_size = 0;                                   // Source size as of the latest stat.
+		int64_t _file_mtime = 0;                                   // Source modification time as of the latest stat.
+		mutable std::string _error;
+};
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_INDEX_H_
@@ -0,0 +1,830 @@
+/*
+	OmniTrak_File_Metadata.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Metadata Trailer
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	File metadata recorded after a session is closed (ORIGINAL_FILENAME,
+	RENAMED_FILE, DOWNLOAD_TIME and DOWNLOAD_SYSTEM) is appended to the end
+	of the file as a trailer instead of being inserted after the header,
+	so adding it never rewrites the session data. A trailer is ordinary
+	metadata blocks followed by a METADATA_TRAILER block giving their
+	count, length and CRC-32, plus where the previous trailer ends:
+
+		... session blocks ... | metadata blocks | METADATA_TRAILER | metadata blocks | METADATA_TRAILER |
+		                                                           ^------------------------ previous --'
+
+	Sequential readers see the trailer as more blocks. omnitrak_read_metadata()
+	instead reads the last OFBC_METADATA_TRAILER_SIZE bytes, then the
+	trailer they frame, and follows the chain back through older trailers;
+	metadata that older tools inserted after the header is picked up from
+	one read of the file's first bytes.
+
+	A trailer is written with one pwrite() under an exclusive flock() and
+	then fsync()'d, and the file is cut back to its old length if either
+	fails. A crash in between leaves, at worst, a trailer without a valid
+	METADATA_TRAILER block, which readers ignore. Appending refuses a file
+	that ends inside a torn block, since sequential readers would read the
+	trailer as the rest of that block; omnitrak_repair_tail() cuts the
+	torn block off, and moves metadata blocks that older tools appended
+	after it into a proper trailer, without copying the file.
+
+		OmniTrak_Metadata_Trailer trailer;
+		trailer.download_time(omnitrak_datenum_now());
+		trailer.download_system("LAB-PC", "COM4");
+		if (omnitrak_append_metadata("session.OmniTrak", trailer) != OMNITRAK_METADATA_OK) { ... }
+
+		OmniTrak_File_Metadata meta;
+		omnitrak_read_metadata("session.OmniTrak", meta);
+		... meta.original_filename, meta.renames, meta.download_time ...
+
+	Requires C++17. File functions are POSIX-only.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_METADATA_H_
+#define _VULINTUS_OMNITRAK_FILE_METADATA_H_
+
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <stdio.h>
+	#include <sys/file.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "OmniTrak_File_Clock.h"
+#include "OmniTrak_File_Reader.h"
+
+
+const uint8_t OFBC_METADATA_TRAILER_VERSION = 1;
+const uint32_t OFBC_METADATA_TRAILER_SIZE = 2 + 18;               // METADATA_TRAILER code and payload.
+const uint32_t OFBC_METADATA_TRAILER_MAX_BLOCKS = 255;
+const uint32_t OMNITRAK_METADATA_HEAD_SPAN = 1u << 16;             // Bytes read from the start of a file for metadata inserted after the header.
+const uint32_t OMNITRAK_METADATA_LEGACY_SPAN = 1u << 12;           // Bytes searched at the end of a file for metadata appended after a torn block.
+const uint32_t OMNITRAK_COPY_CHUNK = 8u << 20;                     // Buffer size for copies copy_file_range() can't do.
+
+
+//CRC-32 (IEEE 802.3, reflected 0xEDB88320), chainable: ofbc_crc32(b, nb, ofbc_crc32(a, na)) is the CRC of a then b.
+inline uint32_t ofbc_crc32(const uint8_t *data, size_t n, uint32_t crc = 0)
+{
+	static const struct Table {
+		uint32_t entry[256];
+		Table()
+		{
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++) {
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				entry[i] = c;
+			}
+		}
+	} table;
+	crc = ~crc;
+	for (size_t i = 0; i < n; i++) {
+		crc = table.entry[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+inline bool ofbc_is_metadata_code(uint16_t code)
+{
+	return code == OFBC_ORIGINAL_FILENAME || code == OFBC_RENAMED_FILE
+		|| code == OFBC_DOWNLOAD_TIME || code == OFBC_DOWNLOAD_SYSTEM;
+}
+
+//Current local time as a MATLAB serial date number, like MATLAB's now().
+inline double omnitrak_datenum_now()
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	double offset = 0;
+#if defined(__unix__) || defined(__APPLE__)
+	struct tm local;
+	if (localtime_r(&ts.tv_sec, &local)) {
+		offset = (double) local.tm_gmtoff;
+	}
+#endif
+	return OMNITRAK_DATENUM_UNIX_EPOCH + ((double) ts.tv_sec + ts.tv_nsec * 1e-9 + offset) / 86400.0;
+}
+
+
+//One RENAMED_FILE record.
+struct OmniTrak_File_Rename {
+	double datenum;                                                // When the file was renamed (serial date number).
+	std::string from;                                              // Filename before, without the path.
+	std::string to;                                                // Filename after, without the path.
+};
+
+//Metadata gathered from a file's trailers and from blocks inserted after its header.
+struct OmniTrak_File_Metadata {
+
+	std::string original_filename;                                 // First ORIGINAL_FILENAME recorded.
+	std::vector<OmniTrak_File_Rename> renames;                     // RENAMED_FILE records, oldest first.
+	double download_time = 0;                                      // Latest DOWNLOAD_TIME (serial date number), 0 if none.
+	std::string download_computer;                                 // Latest DOWNLOAD_SYSTEM computer name.
+	std::string download_port;                                     // Latest DOWNLOAD_SYSTEM port name.
+	uint32_t trailers = 0;                                         // METADATA_TRAILER blocks read.
+	uint32_t leading_blocks = 0;                                   // Metadata blocks found right after the file header.
+
+	//Adds one metadata block whose payload size has already been checked.
+	void add_block(uint16_t code, const uint8_t *payload)
+	{
+		const uint8_t *p = payload;
+		switch (code) {
+			case OFBC_ORIGINAL_FILENAME: {
+				std::string name = get_string16(p);
+				if (original_filename.empty()) {
+					original_filename = name;
+				}
+				break;
+			}
+			case OFBC_RENAMED_FILE: {
+				OmniTrak_File_Rename r;
+				memcpy(&r.datenum, p, 8);
+				p += 8;
+				r.from = get_string16(p);
+				r.to = get_string16(p);
+				renames.push_back(r);
+				break;
+			}
+			case OFBC_DOWNLOAD_TIME:
+				memcpy(&download_time, p, 8);
+				break;
+			case OFBC_DOWNLOAD_SYSTEM:
+				download_computer = get_string8(p);
+				download_port = get_string8(p);
+				break;
+		}
+	}
+
+	bool empty() const
+	{
+		return original_filename.empty() && renames.empty() && download_time == 0 && download_computer.empty();
+	}
+
+	private:
+
+		static std::string get_string16(const uint8_t *&p)
+		{
+			uint16_t n;
+			memcpy(&n, p, 2);
+			std::string s((const char *) p + 2, n);
+			p += 2 + n;
+			return s;
+		}
+
+		static std::string get_string8(const uint8_t *&p)
+		{
+			std::string s((const char *) p + 1, p[0]);
+			p += 1 + p[0];
+			return s;
+		}
+};
+
+
+//Walks a run of metadata blocks that must fill [start, end) exactly, optionally adding them to "meta".
+inline bool ofbc_walk_metadata_blocks(const uint8_t *data, uint64_t start, uint64_t end, uint32_t &count,
+	OmniTrak_File_Metadata *meta = nullptr)
+{
+	count = 0;
+	OmniTrak_Block_Reader reader(data, end, start);
+	OmniTrak_Block_View blk;
+	while (reader.next(blk)) {
+		if (!ofbc_is_metadata_code(blk.code)) {
+			return false;
+		}
+		if (meta) {
+			meta->add_block(blk.code, blk.payload);
+		}
+		count++;
+	}
+	return reader.status() == OMNITRAK_READ_END;
+}
+
+
+//Builds a trailer: metadata blocks followed by the METADATA_TRAILER block that frames them.
+class OmniTrak_Metadata_Trailer {
+
+	public:
+
+		bool original_filename(const std::string &name)
+		{
+			if (name.size() > UINT16_MAX || !room()) {
+				return false;
+			}
+			put<uint16_t>(OFBC_ORIGINAL_FILENAME);
+			put_string<uint16_t>(name);
+			_count++;
+			return true;
+		}
+
+		bool renamed_file(double datenum, const std::string &from, const std::string &to)
+		{
+			if (from.size() > UINT16_MAX || to.size() > UINT16_MAX || !room()) {
+				return false;
+			}
+			put<uint16_t>(OFBC_RENAMED_FILE);
+			put<double>(datenum);
+			put_string<uint16_t>(from);
+			put_string<uint16_t>(to);
+			_count++;
+			return true;
+		}
+
+		bool download_time(double datenum)
+		{
+			if (!room()) {
+				return false;
+			}
+			put<uint16_t>(OFBC_DOWNLOAD_TIME);
+			put<double>(datenum);
+			_count++;
+			return true;
+		}
+
+		bool download_system(const std::string &computer, const std::string &port)
+		{
+			if (computer.size() > UINT8_MAX || port.size() > UINT8_MAX || !room()) {
+				return false;
+			}
+			put<uint16_t>(OFBC_DOWNLOAD_SYSTEM);
+			put_string<uint8_t>(computer);
+			put_string<uint8_t>(port);
+			_count++;
+			return true;
+		}
+
+		//Copies an existing metadata block (code and payload) into the trailer.
+		bool add_block(const uint8_t *block, uint64_t size)
+		{
+			if (!room()) {
+				return false;
+			}
+			_blocks.insert(_blocks.end(), block, block + size);
+			_count++;
+			return true;
+		}
+
+		uint32_t blocks() const { return _count; }
+		bool empty() const { return _count == 0; }
+
+		//The trailer's bytes, given the offset just past the previous trailer (0 if none).
+		std::vector<uint8_t> bytes(uint64_t previous) const
+		{
+			std::vector<uint8_t> out(_blocks);
+			uint8_t footer[OFBC_METADATA_TRAILER_SIZE];
+			uint16_t code = OFBC_METADATA_TRAILER;
+			uint32_t length = (uint32_t) _blocks.size();
+			memcpy(footer, &code, 2);
+			footer[2] = OFBC_METADATA_TRAILER_VERSION;
+			footer[3] = (uint8_t) _count;
+			memcpy(footer + 4, &length, 4);
+			memcpy(footer + 8, &previous, 8);
+			uint32_t crc = ofbc_crc32(footer + 2, 14, ofbc_crc32(_blocks.data(), _blocks.size()));
+			memcpy(footer + 16, &crc, 4);
+			out.insert(out.end(), footer, footer + OFBC_METADATA_TRAILER_SIZE);
+			return out;
+		}
+
+	private:
+
+		bool room() const
+		{
+			return _count < OFBC_METADATA_TRAILER_MAX_BLOCKS && _blocks.size() < UINT32_MAX - 2 * (UINT16_MAX + 10);
+		}
+
+		template <typename T> void put(T value)
+		{
+			const uint8_t *p = (const uint8_t *) &value;
+			_blocks.insert(_blocks.end(), p, p + sizeof(T));
+		}
+
+		template <typename N> void put_string(const std::string &s)
+		{
+			put<N>((N) s.size());
+			_blocks.insert(_blocks.end(), s.begin(), s.end());
+		}
+
+		std::vector<uint8_t> _blocks;
+		uint32_t _count = 0;
+};
+
+
+//Checks the METADATA_TRAILER block (code included) that ends a trailer against the trailer's metadata blocks.
+inline bool ofbc_check_trailer(const uint8_t *blocks, uint32_t length, const uint8_t *footer)
+{
+	uint32_t crc, count;
+	memcpy(&crc, footer + 16, 4);
+	return crc == ofbc_crc32(footer + 2, 14, ofbc_crc32(blocks, length))
+		&& ofbc_walk_metadata_blocks(blocks, 0, length, count) && count == footer[3];
+}
+
+
+enum OmniTrak_Metadata_Status : uint8_t {
+	OMNITRAK_METADATA_OK,
+	OMNITRAK_METADATA_NO_TRAILER,                                  // The file doesn't end in a METADATA_TRAILER block.
+	OMNITRAK_METADATA_BAD_TRAILER,                                 // A METADATA_TRAILER block that doesn't match the blocks before it.
+	OMNITRAK_METADATA_CANT_OPEN,                                   // The file couldn't be opened or read.
+	OMNITRAK_METADATA_BAD_HEADER,                                  // The file doesn't start with 0xABCD, FILE_VERSION.
+	OMNITRAK_METADATA_TORN_TAIL,                                   // The file ends inside a block (see omnitrak_repair_tail()).
+	OMNITRAK_METADATA_DAMAGED,                                     // The block stream breaks before the tail, so it can't be repaired there.
+	OMNITRAK_METADATA_WRITE_FAILED,                                // The trailer couldn't be written and synced.
+	OMNITRAK_METADATA_TOO_LONG,                                    // A filename or system name too long for its block.
+	OMNITRAK_METADATA_RENAME_FAILED,                               // The trailer was appended but the file couldn't be renamed.
+};
+
+inline const char *omnitrak_metadata_status_string(OmniTrak_Metadata_Status status)
+{
+	switch (status) {
+		case OMNITRAK_METADATA_OK:				return "OK";
+		case OMNITRAK_METADATA_NO_TRAILER:		return "no metadata trailer";
+		case OMNITRAK_METADATA_BAD_TRAILER:		return "metadata trailer fails its checksum";
+		case OMNITRAK_METADATA_CANT_OPEN:		return "can't open or read the file";
+		case OMNITRAK_METADATA_BAD_HEADER:		return "missing 0xABCD file header";
+		case OMNITRAK_METADATA_TORN_TAIL:		return "file ends in a torn block";
+		case OMNITRAK_METADATA_DAMAGED:			return "block stream damaged before the end of the file";
+		case OMNITRAK_METADATA_WRITE_FAILED:	return "can't write and sync the metadata trailer";
+		case OMNITRAK_METADATA_TOO_LONG:		return "name too long for its block";
+		case OMNITRAK_METADATA_RENAME_FAILED:	return "metadata appended, but the file couldn't be renamed";
+	}
+	return "unknown";
+}
+
+
+#if defined(__unix__) || defined(__APPLE__)
+
+inline bool omnitrak_pread_all(int fd, void *buf, uint64_t n, uint64_t offset)
+{
+	uint8_t *p = (uint8_t *) buf;
+	while (n > 0) {
+		ssize_t got = pread(fd, p, (size_t) std::min<uint64_t>(n, 1u << 30), (off_t) offset);
+		if (got <= 0) {
+			if (got < 0 && errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		p += got;
+		offset += (uint64_t) got;
+		n -= (uint64_t) got;
+	}
+	return true;
+}
+
+inline bool omnitrak_pwrite_all(int fd, const void *buf, uint64_t n, uint64_t offset)
+{
+	const uint8_t *p = (const uint8_t *) buf;
+	while (n > 0) {
+		ssize_t written = pwrite(fd, p, (size_t) std::min<uint64_t>(n, 1u << 30), (off_t) offset);
+		if (written <= 0) {
+			if (written < 0 && errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		p += written;
+		offset += (uint64_t) written;
+		n -= (uint64_t) written;
+	}
+	return true;
+}
+
+//Copies n bytes between files in the kernel where possible (copy_file_range() shares extents on
+//filesystems that support it), falling back to OMNITRAK_COPY_CHUNK-sized reads and writes.
+inline bool omnitrak_copy_range(int in_fd, uint64_t in_offset, int out_fd, uint64_t out_offset, uint64_t n)
+{
+#if defined(__linux__)
+	while (n > 0) {
+		loff_t in_pos = (loff_t) in_offset, out_pos = (loff_t) out_offset;
+		ssize_t copied = copy_file_range(in_fd, &in_pos, out_fd, &out_pos, (size_t) std::min<uint64_t>(n, 1u << 30), 0);
+		if (copied <= 0) {
+			if (copied < 0 && errno == EINTR) {
+				continue;
+			}
+			break;                                                 // Unsupported here (EXDEV, ENOSYS, ...): copy the rest by hand.
+		}
+		in_offset += (uint64_t) copied;
+		out_offset += (uint64_t) copied;
+		n -= (uint64_t) copied;
+	}
+#endif
+	std::vector<uint8_t> buf(n > 0 ? (size_t) std::min<uint64_t>(n, OMNITRAK_COPY_CHUNK) : 0);
+	while (n > 0) {
+		uint64_t chunk = std::min<uint64_t>(n, buf.size());
+		if (!omnitrak_pread_all(in_fd, buf.data(), chunk, in_offset) || !omnitrak_pwrite_all(out_fd, buf.data(), chunk, out_offset)) {
+			return false;
+		}
+		in_offset += chunk;
+		out_offset += chunk;
+		n -= chunk;
+	}
+	return true;
+}
+
+
+//Where a trailer sits in a file.
+struct OmniTrak_Trailer_Span {
+	uint64_t start;                                                // Offset of its first metadata block.
+	uint64_t end;                                                  // Offset just past its METADATA_TRAILER block.
+	uint64_t previous;                                             // "end" of the trailer before it, 0 if none.
+};
+
+//Reads and checks the trailer ending at "end", returning its metadata blocks.
+inline OmniTrak_Metadata_Status omnitrak_read_trailer(int fd, uint64_t end, OmniTrak_Trailer_Span &span, std::vector<uint8_t> &blocks)
+{
+	uint8_t footer[OFBC_METADATA_TRAILER_SIZE];
+	if (end < OFBC_FILE_HEADER_SIZE + OFBC_METADATA_TRAILER_SIZE) {
+		return OMNITRAK_METADATA_NO_TRAILER;
+	}
+	if (!omnitrak_pread_all(fd, footer, OFBC_METADATA_TRAILER_SIZE, end - OFBC_METADATA_TRAILER_SIZE)) {
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+	uint16_t code;
+	memcpy(&code, footer, 2);
+	if (code != OFBC_METADATA_TRAILER || footer[2] != OFBC_METADATA_TRAILER_VERSION) {
+		return OMNITRAK_METADATA_NO_TRAILER;
+	}
+	uint32_t length;
+	memcpy(&length, footer + 4, 4);
+	memcpy(&span.previous, footer + 8, 8);
+	uint64_t footer_start = end - OFBC_METADATA_TRAILER_SIZE;
+	if (length > footer_start - OFBC_FILE_HEADER_SIZE) {
+		return OMNITRAK_METADATA_BAD_TRAILER;
+	}
+	span.start = footer_start - length;
+	span.end = end;
+	if (span.previous != 0 && (span.previous > span.start || span.previous < OFBC_FILE_HEADER_SIZE + OFBC_METADATA_TRAILER_SIZE)) {
+		return OMNITRAK_METADATA_BAD_TRAILER;
+	}
+	blocks.resize(length);
+	if (!omnitrak_pread_all(fd, blocks.data(), length, span.start)) {
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+	return ofbc_check_trailer(blocks.data(), length, footer) ? OMNITRAK_METADATA_OK : OMNITRAK_METADATA_BAD_TRAILER;
+}
+
+//Reads a file's metadata: its trailers, newest first from the end of the file, then any metadata
+//blocks inserted right after the header. Returns OK if the file ends in a trailer, NO_TRAILER if it
+//doesn't (meta still holds any leading metadata), or an error.
+inline OmniTrak_Metadata_Status omnitrak_read_metadata(const char *path, OmniTrak_File_Metadata &meta)
+{
+	meta = OmniTrak_File_Metadata();
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+
+	//Follow the trailer chain back from the end of the file.
+	OmniTrak_Metadata_Status status = OMNITRAK_METADATA_NO_TRAILER;
+	std::vector<std::vector<uint8_t>> trailers;
+	uint64_t end = (uint64_t) st.st_size, first = end;
+	for (;;) {
+		OmniTrak_Trailer_Span span;
+		std::vector<uint8_t> blocks;
+		OmniTrak_Metadata_Status s = omnitrak_read_trailer(fd, end, span, blocks);
+		if (s != OMNITRAK_METADATA_OK) {
+			if (trailers.empty() || s != OMNITRAK_METADATA_NO_TRAILER) {
+				status = trailers.empty() ? s : OMNITRAK_METADATA_BAD_TRAILER;
+			}
+			break;
+		}
+		status = OMNITRAK_METADATA_OK;
+		trailers.push_back(std::move(blocks));
+		first = span.start;
+		if (span.previous == 0) {
+			break;
+		}
+		end = span.previous;
+	}
+	if (status == OMNITRAK_METADATA_CANT_OPEN) {
+		::close(fd);
+		return status;
+	}
+
+	//Metadata inserted after the header by older tools comes first.
+	std::vector<uint8_t> head((size_t) std::min<uint64_t>(first, OMNITRAK_METADATA_HEAD_SPAN));
+	bool read = omnitrak_pread_all(fd, head.data(), head.size(), 0);
+	::close(fd);
+	if (!read) {
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+	OmniTrak_Block_Reader reader(head.data(), head.size());
+	if (reader.status() == OMNITRAK_READ_BAD_HEADER) {
+		return OMNITRAK_METADATA_BAD_HEADER;
+	}
+	OmniTrak_Block_View blk;
+	while (reader.next(blk) && ofbc_is_metadata_code(blk.code)) {
+		meta.add_block(blk.code, blk.payload);
+		meta.leading_blocks++;
+	}
+	for (size_t i = trailers.size(); i-- > 0;) {
+		uint32_t count;
+		ofbc_walk_metadata_blocks(trailers[i].data(), 0, trailers[i].size(), count, &meta);
+		meta.trailers++;
+	}
+	std::stable_sort(meta.renames.begin(), meta.renames.end(),
+		[](const OmniTrak_File_Rename &a, const OmniTrak_File_Rename &b) { return a.datenum < b.datenum; });
+	return status;
+}
+
+
+//Writes a trailer at "offset", cuts the file off just past it, and syncs. On failure, "restore"
+//(the bytes that were at "offset") is put back.
+inline bool omnitrak_write_trailer(int fd, uint64_t offset, const std::vector<uint8_t> &trailer, const std::vector<uint8_t> &restore)
+{
+	uint64_t end = offset + trailer.size();
+	if (omnitrak_pwrite_all(fd, trailer.data(), trailer.size(), offset) && ftruncate(fd, (off_t) end) == 0 && fsync(fd) == 0) {
+		return true;
+	}
+	if (omnitrak_pwrite_all(fd, restore.data(), restore.size(), offset) && ftruncate(fd, (off_t) (offset + restore.size())) == 0) {
+		fsync(fd);
+	}
+	return false;
+}
+
+//The offset just past the trailer that ends at "end", if one does, for chaining the next trailer to it.
+inline uint64_t omnitrak_previous_trailer(int fd, uint64_t end)
+{
+	OmniTrak_Trailer_Span span;
+	std::vector<uint8_t> blocks;
+	return (omnitrak_read_trailer(fd, end, span, blocks) == OMNITRAK_METADATA_OK) ? end : 0;
+}
+
+//Appends a trailer to a file. A file that already ends in a trailer is checked with one read; otherwise
+//its blocks are walked once to make sure it doesn't end in a torn block.
+inline OmniTrak_Metadata_Status omnitrak_append_metadata(const char *path, const OmniTrak_Metadata_Trailer &trailer)
+{
+	int fd = ::open(path, O_RDWR);
+	if (fd < 0) {
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+	struct stat st;
+	if (flock(fd, LOCK_EX) != 0 || fstat(fd, &st) != 0) {
+		::close(fd);
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+	uint64_t size = (uint64_t) st.st_size;
+	uint64_t previous = omnitrak_previous_trailer(fd, size);
+	if (previous == 0) {
+		OmniTrak_File_Map map;
+		if (!map.open(path)) {
+			::close(fd);
+			return OMNITRAK_METADATA_CANT_OPEN;
+		}
+		OmniTrak_Block_Reader reader(map.data(), std::min<uint64_t>(map.size(), size));
+		OmniTrak_Block_View blk;
+		while (reader.next(blk)) {}
+		if (reader.status() != OMNITRAK_READ_END) {
+			OmniTrak_Read_Status s = reader.status();
+			if (s == OMNITRAK_READ_BAD_HEADER || s == OMNITRAK_READ_TRUNCATED || s == OMNITRAK_READ_MARKED_INCOMPLETE) {
+				::close(fd);
+				return (s == OMNITRAK_READ_BAD_HEADER) ? OMNITRAK_METADATA_BAD_HEADER : OMNITRAK_METADATA_TORN_TAIL;
+			}
+		}
+	}
+	bool ok = omnitrak_write_trailer(fd, size, trailer.bytes(previous), {});
+	::close(fd);                                                   // Also releases the lock.
+	return ok ? OMNITRAK_METADATA_OK : OMNITRAK_METADATA_WRITE_FAILED;
+}
+
+
+//Checks that a metadata block's dates fall between 1970 and 2170 and its names are printable text,
+//to tell real blocks from session bytes that happen to parse as them.
+inline bool ofbc_plausible_metadata(uint16_t code, const uint8_t *p)
+{
+	auto text = [](const uint8_t *s, uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			if (s[i] < 0x20 || s[i] > 0x7E) return false;
+		}
+		return true;
+	};
+	auto date = [](const uint8_t *s) {
+		double d;
+		memcpy(&d, s, 8);
+		return d > OMNITRAK_DATENUM_UNIX_EPOCH && d < OMNITRAK_DATENUM_UNIX_EPOCH + 73050;
+	};
+	uint16_t n, m;
+	switch (code) {
+		case OFBC_ORIGINAL_FILENAME:
+			memcpy(&n, p, 2);
+			return n > 0 && text(p + 2, n);
+		case OFBC_RENAMED_FILE:
+			memcpy(&n, p + 8, 2);
+			memcpy(&m, p + 10 + n, 2);
+			return date(p) && text(p + 10, n) && m > 0 && text(p + 12 + n, m);
+		case OFBC_DOWNLOAD_TIME:
+			return date(p);
+		case OFBC_DOWNLOAD_SYSTEM:
+			return text(p + 1, p[0]) && text(p + 2 + p[0], p[1 + p[0]]);
+	}
+	return false;
+}
+
+//Looks for metadata blocks that fill the end of a file exactly, as left by older tools that appended
+//them after a torn block. Returns the offset of the first, or 0 if there are none.
+inline uint64_t ofbc_find_legacy_metadata(const uint8_t *data, uint64_t size)
+{
+	uint64_t from = OFBC_FILE_HEADER_SIZE;
+	if (size > OFBC_FILE_HEADER_SIZE + OMNITRAK_METADATA_LEGACY_SPAN) {
+		from = size - OMNITRAK_METADATA_LEGACY_SPAN;
+	}
+	for (uint64_t start = from; start + 2 <= size; start++) {
+		uint64_t pos = start;
+		while (pos + 2 <= size) {
+			uint16_t code = (uint16_t) (data[pos] | (data[pos + 1] << 8));
+			const uint8_t *p = data + pos + 2;
+			uint64_t avail = size - pos - 2;
+			if (!ofbc_is_metadata_code(code)) {
+				break;
+			}
+			OFBC_Size_Result res = ofbc_payload_size(code, p, avail);
+			if (res.status != OFBC_SIZE_OK || res.size > avail || !ofbc_plausible_metadata(code, p)) {
+				break;
+			}
+			pos += 2 + res.size;
+		}
+		if (pos == size && pos > start) {
+			return start;
+		}
+	}
+	return 0;
+}
+
+
+//What omnitrak_repair_tail() found and did.
+struct OmniTrak_Tail_Repair {
+	uint64_t size = 0;                                             // File size before the repair.
+	uint64_t kept = 0;                                             // Bytes of the block stream kept.
+	OmniTrak_Read_Status stream = OMNITRAK_READ_END;               // Where the block stream up to the tail stopped.
+	uint16_t torn_code = 0;                                        // Code of the torn block dropped (if torn_bytes > 0).
+	uint64_t torn_bytes = 0;                                       // Bytes of the torn block dropped.
+	uint32_t legacy_blocks = 0;                                    // Metadata blocks found after the block stream, moved into a trailer.
+
+	bool changed() const { return kept != size; }
+};
+
+//Makes a file safe to append a trailer to: drops a torn block at the end of the block stream, and moves
+//metadata blocks that older tools appended after it into a trailer. The file is cut short in place;
+//nothing before the tail is copied. With "output", the file is left alone and the repaired copy is
+//written there instead, copied with omnitrak_copy_range().
+inline OmniTrak_Metadata_Status omnitrak_repair_tail(const char *path, OmniTrak_Tail_Repair &repair, const char *output = nullptr)
+{
+	repair = OmniTrak_Tail_Repair();
+	int fd = ::open(path, output ? O_RDONLY : O_RDWR);
+	if (fd < 0) {
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+	OmniTrak_File_Map map;
+	struct stat st;
+	if (flock(fd, output ? LOCK_SH : LOCK_EX) != 0 || fstat(fd, &st) != 0 || !map.open(path)) {
+		::close(fd);
+		return OMNITRAK_METADATA_CANT_OPEN;
+	}
+	uint64_t size = std::min<uint64_t>((uint64_t) st.st_size, map.size());
+	repair.size = repair.kept = size;
+	OmniTrak_Trailer_Span span;
+	std::vector<uint8_t> blocks;
+	OmniTrak_Metadata_Status status = OMNITRAK_METADATA_OK;
+	OmniTrak_Metadata_Trailer trailer;
+	if (omnitrak_read_trailer(fd, size, span, blocks) != OMNITRAK_METADATA_OK) {
+
+		//Walk the block stream up to any metadata appended at the end. If the whole file walks
+		//cleanly, such blocks only count if they start on a block boundary.
+		uint64_t legacy = ofbc_find_legacy_metadata(map.data(), size);
+		OmniTrak_Block_Reader reader(map.data(), size);
+		OmniTrak_Block_View blk;
+		bool boundary = false;
+		while (reader.next(blk)) {
+			boundary = boundary || blk.offset == legacy;
+		}
+		if (reader.status() == OMNITRAK_READ_END && !boundary) {
+			legacy = 0;
+		}
+		if (legacy) {
+			reader = OmniTrak_Block_Reader(map.data(), legacy);
+			while (reader.next(blk)) {}
+		}
+		repair.stream = reader.status();
+		switch (repair.stream) {
+			case OMNITRAK_READ_END:
+				break;
+			case OMNITRAK_READ_TRUNCATED:
+			case OMNITRAK_READ_MARKED_INCOMPLETE: {
+				uint64_t torn = reader.position();
+				repair.torn_bytes = (legacy ? legacy : size) - torn;
+				if (repair.torn_bytes >= 2) {
+					memcpy(&repair.torn_code, map.data() + torn, 2);
+				}
+				break;
+			}
+			case OMNITRAK_READ_BAD_HEADER:
+				status = OMNITRAK_METADATA_BAD_HEADER;
+				break;
+			default:
+				status = OMNITRAK_METADATA_DAMAGED;
+				break;
+		}
+		if (status == OMNITRAK_METADATA_OK) {
+			repair.kept = reader.position();
+			if (legacy) {
+				OmniTrak_Block_Reader tail(map.data(), size, legacy);
+				while (tail.next(blk)) {
+					if (!trailer.add_block(map.data() + blk.offset, 2 + blk.payload_size)) {
+						status = OMNITRAK_METADATA_TOO_LONG;
+						break;
+					}
+					repair.legacy_blocks++;
+				}
+			}
+		}
+	}
+
+	if (status == OMNITRAK_METADATA_OK && output) {
+		int out = ::open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		bool ok = out >= 0 && omnitrak_copy_range(fd, 0, out, 0, repair.kept)
+			&& (trailer.empty() ? ftruncate(out, (off_t) repair.kept) == 0 && fsync(out) == 0
+				: omnitrak_write_trailer(out, repair.kept, trailer.bytes(omnitrak_previous_trailer(fd, repair.kept)), {}));
+		if (out >= 0) {
+			::close(out);
+		}
+		status = ok ? OMNITRAK_METADATA_OK : OMNITRAK_METADATA_WRITE_FAILED;
+	}
+	else if (status == OMNITRAK_METADATA_OK && repair.changed()) {
+		std::vector<uint8_t> restore(map.data() + repair.kept, map.data() + size);
+		bool ok = trailer.empty()
+			? ftruncate(fd, (off_t) repair.kept) == 0 && fsync(fd) == 0
+			: omnitrak_write_trailer(fd, repair.kept, trailer.bytes(omnitrak_previous_trailer(fd, repair.kept)), restore);
+		status = ok ? OMNITRAK_METADATA_OK : OMNITRAK_METADATA_WRITE_FAILED;
+	}
+	::close(fd);
+	return status;
+}
+
+
+//Flushes a directory entry change (a rename) to disk.
+inline bool omnitrak_sync_directory(const std::string &path)
+{
+	size_t slash = path.find_last_of('/');
+	std::string dir = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+	int fd = ::open(dir.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	bool ok = fsync(fd) == 0;
+	::close(fd);
+	return ok;
+}
+
+inline std::string omnitrak_base_filename(const std::string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+//Renames a file, first appending a RENAMED_FILE record (and ORIGINAL_FILENAME, if the file has no
+//earlier name on record) when the filename itself changes. A move that keeps the name appends nothing.
+inline OmniTrak_Metadata_Status omnitrak_rename_file(const char *from, const char *to, double datenum)
+{
+	std::string old_name = omnitrak_base_filename(from), new_name = omnitrak_base_filename(to);
+	if (old_name != new_name) {
+		OmniTrak_File_Metadata meta;
+		OmniTrak_Metadata_Status status = omnitrak_read_metadata(from, meta);
+		if (status != OMNITRAK_METADATA_OK && status != OMNITRAK_METADATA_NO_TRAILER && status != OMNITRAK_METADATA_BAD_TRAILER) {
+			return status;
+		}
+		OmniTrak_Metadata_Trailer trailer;
+		if ((meta.original_filename.empty() && meta.renames.empty() && !trailer.original_filename(old_name))
+				|| !trailer.renamed_file(datenum, old_name, new_name)) {
+			return OMNITRAK_METADATA_TOO_LONG;
+		}
+		if ((status = omnitrak_append_metadata(from, trailer)) != OMNITRAK_METADATA_OK) {
+			return status;
+		}
+	}
+	if (::rename(from, to) != 0 || !omnitrak_sync_directory(to)) {
+		return OMNITRAK_METADATA_RENAME_FAILED;
+	}
+	return OMNITRAK_METADATA_OK;
+}
+
+#endif
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_METADATA_H_
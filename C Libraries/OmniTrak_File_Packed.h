@@ -0,0 +1,424 @@
+/*
+	OmniTrak_File_Packed.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Packed Sample Batches
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	High-rate streams (CAPSENSE_VALUE, POKE_BITMASK, AMBULATION_XY_THETA,
+	ALSPT19_LIGHT) repeat a full timestamp and full-width values in every
+	block. Their *_PACKED block codes hold a batch of up to 255 samples
+	instead: the first timestamp and timestamp delta, then each later
+	timestamp as a zigzag-encoded delta-of-delta, and each value channel as
+	a first value followed by zigzag-encoded deltas. Every field of a kind
+	is bit-packed at one width per batch (the narrowest that fits the
+	batch), so a steady sampling clock costs 0 bits per timestamp and a
+	constant channel costs nothing at all.
+
+	Packed batch payload (little-endian):
+		uint8   version (1)
+		uint8   ID (sensor index or ID, as in the unpacked block; else 0)
+		uint8   channels, C
+		uint8   samples, N (1 to 255)
+		float64 serial date number of the first sample (0 if the unpacked block has none)
+		uint32  first timestamp
+		int32   first timestamp delta (0 if N == 1)
+		uint8   timestamp field width, in bits (0 to 32)
+		C x uint8  value field widths, in bits (0 to 32)
+		C x int32  first values
+		N-2 timestamp fields, then C x (N-1) value fields, LSB-first, padded to a byte.
+
+	OmniTrak_Packed_Encoder runs on a device: it keeps just the batch being
+	built (MAX_SAMPLES x (C + 1) x 4 bytes) and streams the packed block
+	straight into an OmniTrak_File_Writer. omnitrak_decode_packed() is the
+	host decoder; the zigzag and prefix-sum steps use SSE2 where available.
+
+		OmniTrak_Packed_Encoder<OFBC_CAPSENSE_VALUE_PACKED> capsense(sensor);
+		int32_t values[3] = {num_sensors, bitmask, reading};
+		if (!capsense.add(writer, micros(), values, datenum)) { ... }  // Writes a full batch first.
+		...
+		capsense.write(writer);                                    // The last, partial batch.
+
+		OmniTrak_Packed_Batch batch;
+		if (omnitrak_parse_packed(blk.code, blk.payload, blk.payload_size, batch)) {
+			omnitrak_decode_packed(batch, times, values);          // values[channel * batch.samples + i]
+		}
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_PACKED_H_
+#define _VULINTUS_OMNITRAK_FILE_PACKED_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "OmniTrak_File_Block_Sizes.h"
+#include "OmniTrak_File_Timestamps.h"
+
+#if !defined(OFBC_PACKED_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+	#define OFBC_PACKED_SIMD 1
+	#include <emmintrin.h>
+#else
+	#define OFBC_PACKED_SIMD 0
+#endif
+
+const uint32_t OFBC_PACKED_HEADER_SIZE = 21;                       // Payload bytes before the value widths.
+const uint32_t OFBC_PACKED_MAX_SAMPLES = 255;
+
+
+//Packed block codes, the unpacked blocks they replace, and their value channels.
+struct OFBC_Packed_Stream {
+	uint16_t code;                                                 // *_PACKED block code.
+	uint16_t source;                                               // Block code of a single sample.
+	uint8_t channels;                                              // Value channels per sample.
+	OFBC_Time_Type time;                                           // Timestamp clock (MILLIS or MICROS).
+};
+
+constexpr OFBC_Packed_Stream OFBC_PACKED_STREAMS[] = {
+	{OFBC_AMBULATION_XY_THETA_PACKED,	OFBC_AMBULATION_XY_THETA,	3,	OFBC_TIME_MICROS},    // x, y, theta as float32 bit patterns.
+	{OFBC_ALSPT19_LIGHT_PACKED,			OFBC_ALSPT19_LIGHT,			1,	OFBC_TIME_MILLIS},    // ADC value.
+	{OFBC_POKE_BITMASK_PACKED,			OFBC_POKE_BITMASK,			2,	OFBC_TIME_MICROS},    // Sensors, bitmask.
+	{OFBC_CAPSENSE_VALUE_PACKED,		OFBC_CAPSENSE_VALUE,		3,	OFBC_TIME_MICROS},    // Sensors, bitmask, value.
+};
+
+//Returns the packed stream entry for a *_PACKED block code, or nullptr.
+constexpr const OFBC_Packed_Stream *ofbc_find_packed_stream(uint16_t code)
+{
+	for (const OFBC_Packed_Stream &stream : OFBC_PACKED_STREAMS) {
+		if (stream.code == code) {
+			return &stream;
+		}
+	}
+	return nullptr;
+}
+
+
+//Zigzag encoding maps small signed deltas to small unsigned fields: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+inline uint32_t ofbc_zigzag(int32_t value)
+{
+	return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+inline int32_t ofbc_unzigzag(uint32_t field)
+{
+	return (int32_t) ((field >> 1) ^ (0u - (field & 1)));
+}
+
+//Bits needed to hold "value" (0 for 0).
+inline uint8_t ofbc_bit_width(uint32_t value)
+{
+	uint8_t bits = 0;
+	while (value) {
+		bits++;
+		value >>= 1;
+	}
+	return bits;
+}
+
+//Float32 channels (AMBULATION_XY_THETA) are packed as their bit patterns, so they round-trip exactly.
+inline int32_t ofbc_float_bits(float value)
+{
+	int32_t bits;
+	memcpy(&bits, &value, 4);
+	return bits;
+}
+
+inline float ofbc_bits_float(int32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, 4);
+	return value;
+}
+
+
+//Builds packed batches on a device. "MAX_SAMPLES" sets the batch length, and with it the RAM used.
+template <uint16_t CODE, uint8_t MAX_SAMPLES = 64>
+class OmniTrak_Packed_Encoder {
+
+	static_assert(ofbc_find_packed_stream(CODE) != nullptr, "OmniTrak_Packed_Encoder<CODE>: not a *_PACKED block code");
+	static_assert(MAX_SAMPLES >= 2, "OmniTrak_Packed_Encoder: batches need at least 2 samples");
+
+	public:
+
+		static constexpr uint8_t CHANNELS = ofbc_find_packed_stream(CODE)->channels;
+
+		explicit OmniTrak_Packed_Encoder(uint8_t id = 0) : _id(id) {}
+
+		//Adds a sample, returning false (and not taking it) if the batch is already full and
+		//has to be written first.
+		bool add(uint32_t timestamp, const int32_t (&values)[CHANNELS], double datenum = 0)
+		{
+			if (full()) {
+				return false;
+			}
+			if (_count == 0) {
+				_datenum = datenum;
+			}
+			_times[_count] = timestamp;
+			for (uint8_t c = 0; c < CHANNELS; c++) {
+				_values[c][_count] = values[c];
+			}
+			_count++;
+			return true;
+		}
+
+		//Adds a sample, first writing the batch if it's full. Returns false, without taking
+		//the sample, only if that write fails.
+		template <typename Writer> bool add(Writer &writer, uint32_t timestamp, const int32_t (&values)[CHANNELS], double datenum = 0)
+		{
+			if (full() && !write(writer)) {
+				return false;
+			}
+			return add(timestamp, values, datenum);
+		}
+
+		//Writes the batch as one block through an OmniTrak_File_Writer (or anything with
+		//begin_block() and put()) and starts a new batch. Writes nothing if the batch is empty.
+		template <typename Writer> bool write(Writer &writer)
+		{
+			if (_count == 0) {
+				return true;
+			}
+			uint32_t time_or = 0;
+			uint32_t delta = _times[1 % _count] - _times[0];
+			for (uint8_t i = 2; i < _count; i++) {                 // Delta-of-delta wraps like uint32 (sparse micros streams).
+				uint32_t next = _times[i] - _times[i - 1];
+				time_or |= ofbc_zigzag((int32_t) (next - delta));
+				delta = next;
+			}
+			uint8_t time_width = ofbc_bit_width(time_or);
+			uint8_t widths[CHANNELS];
+			uint64_t bits = (_count > 2) ? (uint64_t) (_count - 2) * time_width : 0;
+			for (uint8_t c = 0; c < CHANNELS; c++) {
+				uint32_t value_or = 0;
+				for (uint8_t i = 1; i < _count; i++) {
+					value_or |= ofbc_zigzag((int32_t) ((uint32_t) _values[c][i] - (uint32_t) _values[c][i - 1]));
+				}
+				widths[c] = ofbc_bit_width(value_or);
+				bits += (uint64_t) (_count - 1) * widths[c];
+			}
+
+			uint32_t size = OFBC_PACKED_HEADER_SIZE + 5 * CHANNELS + (uint32_t) ((bits + 7) / 8);
+			if (!writer.begin_block(CODE, size)) {
+				return false;
+			}
+			writer.put((uint8_t) 1);
+			writer.put(_id);
+			writer.put(CHANNELS);
+			writer.put(_count);
+			writer.put(_datenum);
+			writer.put(_times[0]);
+			writer.put((int32_t) (_count > 1 ? _times[1] - _times[0] : 0));
+			writer.put(time_width);
+			for (uint8_t c = 0; c < CHANNELS; c++) {
+				writer.put(widths[c]);
+			}
+			for (uint8_t c = 0; c < CHANNELS; c++) {
+				writer.put(_values[c][0]);
+			}
+
+			_acc = 0;
+			_acc_bits = 0;
+			delta = _times[1 % _count] - _times[0];
+			for (uint8_t i = 2; i < _count; i++) {
+				uint32_t next = _times[i] - _times[i - 1];
+				pack(writer, ofbc_zigzag((int32_t) (next - delta)), time_width);
+				delta = next;
+			}
+			for (uint8_t c = 0; c < CHANNELS; c++) {
+				for (uint8_t i = 1; i < _count; i++) {
+					pack(writer, ofbc_zigzag((int32_t) ((uint32_t) _values[c][i] - (uint32_t) _values[c][i - 1])), widths[c]);
+				}
+			}
+			while (_acc_bits > 0) {                                // Flush the last partial bytes.
+				writer.put((uint8_t) _acc);
+				_acc >>= 8;
+				_acc_bits = (_acc_bits > 8) ? _acc_bits - 8 : 0;
+			}
+			_count = 0;
+			return true;
+		}
+
+		uint8_t count() const { return _count; }                  // Samples waiting in the current batch.
+		bool full() const { return _count == MAX_SAMPLES; }
+
+	private:
+
+		//Appends a "width"-bit field, passing whole 32-bit words on to the writer.
+		template <typename Writer> void pack(Writer &writer, uint32_t field, uint8_t width)
+		{
+			if (width == 0) {
+				return;
+			}
+			_acc |= (uint64_t) field << _acc_bits;
+			_acc_bits += width;
+			if (_acc_bits >= 32) {
+				writer.put((uint32_t) _acc);
+				_acc >>= 32;
+				_acc_bits -= 32;
+			}
+		}
+
+		uint32_t _times[MAX_SAMPLES];
+		int32_t _values[CHANNELS][MAX_SAMPLES];
+		double _datenum = 0;
+		uint64_t _acc = 0;                                         // Bit-packing accumulator.
+		uint8_t _acc_bits = 0;
+		uint8_t _count = 0;
+		uint8_t _id;
+};
+
+
+//Header of a packed batch, read from its block.
+struct OmniTrak_Packed_Batch {
+	uint16_t code;
+	uint8_t id;
+	uint8_t channels;
+	uint8_t samples;
+	double datenum;                                                // Serial date number of the first sample.
+	uint32_t first_time;
+	int32_t first_delta;
+	uint8_t time_width;
+	const uint8_t *widths;                                         // "channels" value field widths.
+	const uint8_t *first_values;                                   // "channels" int32 first values.
+	const uint8_t *fields;                                         // Bit-packed fields.
+	const uint8_t *end;                                            // End of the payload.
+};
+
+//Reads the header of a *_PACKED block, returning false if the block isn't a valid packed batch
+//(including any field wider than 32 bits, or fields that run past the payload).
+inline bool omnitrak_parse_packed(uint16_t code, const uint8_t *payload, uint64_t payload_size, OmniTrak_Packed_Batch &batch)
+{
+	const OFBC_Packed_Stream *stream = ofbc_find_packed_stream(code);
+	if (!stream || payload_size < OFBC_PACKED_HEADER_SIZE || payload[0] != 1) {
+		return false;
+	}
+	batch.code = code;
+	batch.id = payload[1];
+	batch.channels = payload[2];
+	batch.samples = payload[3];
+	memcpy(&batch.datenum, payload + 4, 8);
+	memcpy(&batch.first_time, payload + 12, 4);
+	memcpy(&batch.first_delta, payload + 16, 4);
+	batch.time_width = payload[20];
+	batch.widths = payload + OFBC_PACKED_HEADER_SIZE;
+	batch.first_values = batch.widths + batch.channels;
+	batch.fields = batch.first_values + 4 * batch.channels;
+	batch.end = payload + payload_size;
+	if (batch.channels != stream->channels || batch.samples == 0 || batch.time_width > 32
+			|| payload_size < OFBC_PACKED_HEADER_SIZE + 5 * (uint64_t) batch.channels) {
+		return false;
+	}
+	uint64_t bits = (uint64_t) (batch.samples > 2 ? batch.samples - 2 : 0) * batch.time_width;
+	for (uint8_t c = 0; c < batch.channels; c++) {
+		if (batch.widths[c] > 32) {
+			return false;
+		}
+		bits += (uint64_t) (batch.samples - 1) * batch.widths[c];
+	}
+	return (bits + 7) / 8 <= (uint64_t) (batch.end - batch.fields);   // The payload may come from anywhere, not just a sized block.
+}
+
+
+//Unpacks "n" "width"-bit fields starting "bit" bits into "src", reading nothing at or past "end".
+inline void ofbc_unpack_fields(const uint8_t *src, const uint8_t *end, uint64_t bit, uint8_t width, size_t n, uint32_t *out)
+{
+	if (width == 0) {
+		memset(out, 0, n * sizeof(uint32_t));
+		return;
+	}
+	uint64_t mask = (width == 32) ? 0xFFFFFFFFull : ((1ull << width) - 1);
+	size_t i = 0;
+	for (; i < n; i++, bit += width) {                             // Unaligned 64-bit loads while 8 bytes remain.
+		const uint8_t *p = src + (bit >> 3);
+		if (p + 8 > end) {
+			break;
+		}
+		uint64_t word;
+		memcpy(&word, p, 8);
+		out[i] = (uint32_t) ((word >> (bit & 7)) & mask);
+	}
+	for (; i < n; i++, bit += width) {                             // The last few fields, byte by byte.
+		const uint8_t *p = src + (bit >> 3);
+		uint64_t word = 0;
+		for (size_t b = 0; b < 8 && p + b < end; b++) {
+			word |= (uint64_t) p[b] << (8 * b);
+		}
+		out[i] = (uint32_t) ((word >> (bit & 7)) & mask);
+	}
+}
+
+//Sets out[i] = start + the sum of the unzigzagged fields 0..i, wrapping like uint32.
+inline void ofbc_unzigzag_prefix_sum(const uint32_t *fields, size_t n, int32_t start, int32_t *out)
+{
+	size_t i = 0;
+	uint32_t sum = (uint32_t) start;
+#if OFBC_PACKED_SIMD
+	__m128i carry = _mm_set1_epi32((int32_t) sum);
+	const __m128i one = _mm_set1_epi32(1);
+	for (; i + 4 <= n; i += 4) {
+		__m128i z = _mm_loadu_si128((const __m128i *) (fields + i));
+		__m128i x = _mm_xor_si128(_mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, one)));
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 4));                // In-register prefix sum.
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi32(x, carry);
+		_mm_storeu_si128((__m128i *) (out + i), x);
+		carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+	sum = (uint32_t) _mm_cvtsi128_si32(carry);
+#endif
+	for (; i < n; i++) {
+		sum += (uint32_t) ofbc_unzigzag(fields[i]);
+		out[i] = (int32_t) sum;
+	}
+}
+
+//Decodes a packed batch into batch.samples timestamps and batch.channels x batch.samples
+//values, channel by channel (values[c * batch.samples + i]). Returns the number of samples.
+inline size_t omnitrak_decode_packed(const OmniTrak_Packed_Batch &batch, uint32_t *times, int32_t *values)
+{
+	size_t n = batch.samples;
+	uint32_t fields[OFBC_PACKED_MAX_SAMPLES];
+	int32_t deltas[OFBC_PACKED_MAX_SAMPLES];
+	uint64_t bit = 0;
+
+	times[0] = batch.first_time;
+	if (n > 1) {
+		deltas[0] = batch.first_delta;
+		if (n > 2) {
+			ofbc_unpack_fields(batch.fields, batch.end, bit, batch.time_width, n - 2, fields);
+			ofbc_unzigzag_prefix_sum(fields, n - 2, batch.first_delta, deltas + 1);
+			bit += (uint64_t) (n - 2) * batch.time_width;
+		}
+		uint32_t t = batch.first_time;
+		for (size_t i = 1; i < n; i++) {                           // Timestamps are the prefix sum of the deltas.
+			t += (uint32_t) deltas[i - 1];
+			times[i] = t;
+		}
+	}
+	for (uint8_t c = 0; c < batch.channels; c++) {
+		int32_t *column = values + c * n;
+		memcpy(&column[0], batch.first_values + 4 * c, 4);
+		if (n > 1) {
+			ofbc_unpack_fields(batch.fields, batch.end, bit, batch.widths[c], n - 1, fields);
+			ofbc_unzigzag_prefix_sum(fields, n - 1, column[0], column + 1);
+			bit += (uint64_t) (n - 1) * batch.widths[c];
+		}
+	}
+	return n;
+}
+
+//Serial date number of a decoded timestamp, from the batch's first sample (POKE_BITMASK and CAPSENSE_VALUE batches).
+inline double omnitrak_packed_datenum(const OmniTrak_Packed_Batch &batch, uint32_t time)
+{
+	const OFBC_Packed_Stream *stream = ofbc_find_packed_stream(batch.code);
+	double ticks_per_day = (stream && stream->time == OFBC_TIME_MILLIS) ? 86400e3 : 86400e6;
+	return batch.datenum + (double) (uint32_t) (time - batch.first_time) / ticks_per_day;
+}
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_PACKED_H_
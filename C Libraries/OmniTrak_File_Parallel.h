@@ -0,0 +1,323 @@
+/*
+	OmniTrak_File_Parallel.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Parallel Parser With Resync
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Parses one large *.OmniTrak file on every core. Blocks have no length
+	field, so a block boundary can normally only be found by walking every
+	block from the file header. Here the file is split into chunks, and each
+	chunk after the first guesses its first boundary with a validity model:
+	an offset is a plausible boundary if a chain of OMNITRAK_SYNC_CHAIN
+	blocks starting there all have tabled codes and payloads that size
+	correctly (see OmniTrak_File_Block_Sizes.h). The chunks are walked in
+	parallel, then stitched left to right against the true chain: when a
+	chunk's guessed start isn't where the previous chunk actually ended, it
+	is re-walked from the true position until the two walks meet at a
+	common boundary (after which they're identical), so the result is
+	always exactly what a single sequential walk would have produced.
+
+	The same model lets the walk survive damage. Where MATLAB's
+	OmniTrakFileRead gives up at the first unrecognized block, the walk
+	records a gap from the bad block to the next plausible boundary and
+	carries on, so one corrupt sector doesn't lose the rest of a session.
+
+		OmniTrak_File_Map map;
+		map.open("session.OmniTrak");
+		OmniTrak_Thread_Pool pool;
+		OmniTrak_Parallel_Parser parser;
+		parser.scan(map.data(), map.size(), pool);                 // Finds every block boundary.
+		parser.decode(pool, [&](size_t chunk, const OmniTrak_Block_View &blk) { ... });   // Chunks run in parallel.
+		for (const OmniTrak_Parse_Gap &gap : parser.gaps()) { ... }
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_PARALLEL_H_
+#define _VULINTUS_OMNITRAK_FILE_PARALLEL_H_
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "OmniTrak_File_Reader.h"
+#include "OmniTrak_Thread_Pool.h"
+
+const int OMNITRAK_SYNC_CHAIN = 4;                                 // Consecutive valid blocks needed to accept a guessed boundary.
+const uint64_t OMNITRAK_CHUNK_SIZE = 64ull << 20;                  // Default bytes per parallel chunk.
+const uint32_t OMNITRAK_SYNC_SAMPLE = 256;                         // Blocks between the boundaries each chunk keeps for stitching.
+
+
+//A stretch of the file that couldn't be read as blocks.
+struct OmniTrak_Parse_Gap {
+	uint64_t start;                                                // Offset of the unreadable block.
+	uint64_t end;                                                  // Next plausible boundary, or the end of the file.
+	uint16_t code;                                                 // Block code at "start" (0 if cut off).
+	OmniTrak_Read_Status status;                                   // Why the block at "start" couldn't be read.
+};
+
+//One step of a resyncing walk: a block, or a gap.
+struct OmniTrak_Walk_Step {
+	bool is_block;
+	OmniTrak_Block_View block;
+	OmniTrak_Parse_Gap gap;
+	uint64_t next;                                                 // Where the walk continues.
+};
+
+
+//Sizes the block at "pos", returning OMNITRAK_READ_OK and its payload size, or why it can't be read.
+inline OmniTrak_Read_Status omnitrak_size_block(const uint8_t *data, uint64_t size, uint64_t pos, uint64_t &payload_size)
+{
+	if (size - pos < 2) {
+		return OMNITRAK_READ_TRUNCATED;
+	}
+	uint16_t code;
+	memcpy(&code, data + pos, 2);
+	uint64_t avail = size - pos - 2;
+	OFBC_Size_Result res = ofbc_payload_size(code, data + pos + 2, avail);
+	switch (res.status) {
+		case OFBC_SIZE_OK:					break;
+		case OFBC_SIZE_NEED_MORE:			return OMNITRAK_READ_TRUNCATED;
+		case OFBC_SIZE_UNKNOWN_CODE:		return OMNITRAK_READ_UNKNOWN_CODE;
+		case OFBC_SIZE_UNDEFINED_LAYOUT:	return OMNITRAK_READ_UNDEFINED_LAYOUT;
+		case OFBC_SIZE_BAD_VERSION:			return OMNITRAK_READ_BAD_VERSION;
+		case OFBC_SIZE_INVALID:				return OMNITRAK_READ_INVALID_BLOCK;
+	}
+	if (res.size > avail) {
+		return OMNITRAK_READ_TRUNCATED;
+	}
+	payload_size = res.size;
+	return OMNITRAK_READ_OK;
+}
+
+//Validity model: true if OMNITRAK_SYNC_CHAIN blocks in a row read cleanly from "pos"
+//(or fewer, if they end exactly at the end of the file).
+inline bool omnitrak_plausible_boundary(const uint8_t *data, uint64_t size, uint64_t pos)
+{
+	for (int i = 0; i < OMNITRAK_SYNC_CHAIN; i++) {
+		if (pos == size) {
+			return i > 0;
+		}
+		uint64_t payload_size;
+		if (omnitrak_size_block(data, size, pos, payload_size) != OMNITRAK_READ_OK) {
+			return false;
+		}
+		pos += 2 + payload_size;
+	}
+	return true;
+}
+
+//Returns the first plausible block boundary at or after "pos", or "size" if there is none.
+inline uint64_t omnitrak_find_sync(const uint8_t *data, uint64_t size, uint64_t pos)
+{
+	for (; pos < size; pos++) {
+		if (omnitrak_plausible_boundary(data, size, pos)) {
+			return pos;
+		}
+	}
+	return size;
+}
+
+//Takes one step of a resyncing walk from the block boundary "pos" (which must be before "size").
+inline void omnitrak_walk_step(const uint8_t *data, uint64_t size, uint64_t pos, OmniTrak_Walk_Step &step)
+{
+	uint64_t payload_size = 0;
+	OmniTrak_Read_Status status = omnitrak_size_block(data, size, pos, payload_size);
+	if (status == OMNITRAK_READ_OK) {
+		step.is_block = true;
+		memcpy(&step.block.code, data + pos, 2);
+		step.block.offset = pos;
+		step.block.payload = data + pos + 2;
+		step.block.payload_size = payload_size;
+		step.next = pos + 2 + payload_size;
+		return;
+	}
+	step.is_block = false;
+	step.gap.start = pos;
+	step.gap.end = omnitrak_find_sync(data, size, pos + 1);
+	step.gap.code = 0;
+	if (size - pos >= 2) {
+		memcpy(&step.gap.code, data + pos, 2);
+	}
+	step.gap.status = status;
+	step.next = step.gap.end;
+}
+
+
+//Walked results for one chunk of the file.
+struct OmniTrak_Parse_Chunk {
+
+	struct Sample {
+		uint64_t offset;                                           // A block boundary on this chunk's walk.
+		uint64_t blocks;                                           // Blocks walked before reaching it.
+	};
+
+	uint64_t begin = 0;                                            // Nominal byte range assigned to the chunk.
+	uint64_t end = 0;
+	uint64_t start = 0;                                            // First boundary (guessed, until stitched).
+	uint64_t stop = 0;                                             // First boundary at or past "end".
+	uint64_t blocks = 0;
+	std::vector<Sample> samples;                                   // Every OMNITRAK_SYNC_SAMPLE-th boundary, for stitching.
+	std::vector<OmniTrak_Parse_Gap> gaps;
+	bool respeculated = false;                                     // The guessed start was wrong and the chunk was re-walked.
+};
+
+
+class OmniTrak_Parallel_Parser {
+
+	public:
+
+		//Finds every block boundary of an in-memory (typically memory-mapped) file. Returns
+		//false only if the file header is missing; damaged blocks are reported by gaps().
+		bool scan(const uint8_t *data, uint64_t size, OmniTrak_Thread_Pool &pool, uint64_t chunk_size = OMNITRAK_CHUNK_SIZE)
+		{
+			_data = data;
+			_size = size;
+			_chunks.clear();
+			_gaps.clear();
+			_blocks = 0;
+			_respeculated_bytes = 0;
+			OmniTrak_Block_Reader header(data, size);
+			if (header.status() == OMNITRAK_READ_BAD_HEADER) {
+				return false;
+			}
+			_version = header.file_version();
+
+			if (chunk_size < 4096) {
+				chunk_size = 4096;
+			}
+			for (uint64_t begin = OFBC_FILE_HEADER_SIZE; begin < size; begin += chunk_size) {
+				OmniTrak_Parse_Chunk chunk;
+				chunk.begin = begin;
+				chunk.end = std::min(size, begin + chunk_size);
+				_chunks.push_back(chunk);
+			}
+			for (size_t i = 0; i < _chunks.size(); i++) {
+				pool.submit([this, i]() {
+					OmniTrak_Parse_Chunk &chunk = _chunks[i];
+					chunk.start = (i == 0) ? chunk.begin : omnitrak_find_sync(_data, _size, chunk.begin);
+					walk(chunk, chunk.start);
+				});
+			}
+			pool.wait();
+
+			uint64_t pos = OFBC_FILE_HEADER_SIZE;                  // Where the true chain reaches each chunk.
+			for (OmniTrak_Parse_Chunk &chunk : _chunks) {
+				stitch(chunk, pos);
+				pos = chunk.stop;
+				_blocks += chunk.blocks;
+				_gaps.insert(_gaps.end(), chunk.gaps.begin(), chunk.gaps.end());
+			}
+			return true;
+		}
+
+		//Calls visit(size_t chunk, const OmniTrak_Block_View &blk) for every block found by
+		//scan(), in file order within each chunk, with the chunks running in parallel.
+		template <typename Visitor> void decode(OmniTrak_Thread_Pool &pool, Visitor &&visit)
+		{
+			for (size_t i = 0; i < _chunks.size(); i++) {
+				pool.submit([this, i, &visit]() {
+					const OmniTrak_Parse_Chunk &chunk = _chunks[i];
+					OmniTrak_Walk_Step step;
+					for (uint64_t pos = chunk.start; pos < chunk.stop; pos = step.next) {
+						omnitrak_walk_step(_data, _size, pos, step);
+						if (step.is_block) {
+							visit(i, step.block);
+						}
+					}
+				});
+			}
+			pool.wait();
+		}
+
+		const std::vector<OmniTrak_Parse_Chunk> &chunks() const { return _chunks; }
+		const std::vector<OmniTrak_Parse_Gap> &gaps() const { return _gaps; }
+		uint64_t blocks() const { return _blocks; }
+		uint64_t respeculated_bytes() const { return _respeculated_bytes; }  // Bytes walked again because a guess was wrong.
+		uint16_t file_version() const { return _version; }
+
+	private:
+
+		//Walks a chunk from "pos" until reaching a boundary at or past its nominal end.
+		void walk(OmniTrak_Parse_Chunk &chunk, uint64_t pos)
+		{
+			OmniTrak_Walk_Step step;
+			while (pos < chunk.end) {
+				if (chunk.blocks % OMNITRAK_SYNC_SAMPLE == 0) {
+					chunk.samples.push_back({pos, chunk.blocks});
+				}
+				omnitrak_walk_step(_data, _size, pos, step);
+				if (step.is_block) {
+					chunk.blocks++;
+				}
+				else {
+					chunk.gaps.push_back(step.gap);
+				}
+				pos = step.next;
+			}
+			chunk.stop = std::max(pos, chunk.start);
+		}
+
+		//Checks a chunk's guessed start against the true chain position "pos", re-walking
+		//from "pos" until the two walks meet if the guess was wrong.
+		void stitch(OmniTrak_Parse_Chunk &chunk, uint64_t pos)
+		{
+			if (pos == chunk.start) {
+				return;
+			}
+			if (pos >= chunk.end) {                                // A block or gap from an earlier chunk covers this one.
+				chunk.start = chunk.stop = pos;
+				chunk.blocks = 0;
+				chunk.samples.clear();
+				chunk.gaps.clear();
+				return;
+			}
+			chunk.respeculated = true;
+			uint64_t from = pos;
+			uint64_t blocks = 0;
+			std::vector<OmniTrak_Parse_Gap> gaps;
+			OmniTrak_Walk_Step step;
+			while (pos < chunk.end) {
+				auto hit = std::lower_bound(chunk.samples.begin(), chunk.samples.end(), pos,
+					[](const OmniTrak_Parse_Chunk::Sample &s, uint64_t p) { return s.offset < p; });
+				if (hit != chunk.samples.end() && hit->offset == pos) {
+					chunk.blocks = blocks + (chunk.blocks - hit->blocks);  // Converged: keep the rest of the guessed walk.
+					chunk.gaps.erase(chunk.gaps.begin(), std::lower_bound(chunk.gaps.begin(), chunk.gaps.end(), pos,
+						[](const OmniTrak_Parse_Gap &g, uint64_t p) { return g.start < p; }));
+					chunk.gaps.insert(chunk.gaps.begin(), gaps.begin(), gaps.end());
+					chunk.start = from;
+					_respeculated_bytes += pos - from;
+					return;
+				}
+				omnitrak_walk_step(_data, _size, pos, step);
+				if (step.is_block) {
+					blocks++;
+				}
+				else {
+					gaps.push_back(step.gap);
+				}
+				pos = step.next;
+			}
+			chunk.blocks = blocks;
+			chunk.gaps = gaps;
+			chunk.start = from;
+			chunk.stop = pos;
+			_respeculated_bytes += pos - from;
+		}
+
+		const uint8_t *_data = nullptr;
+		uint64_t _size = 0;
+		uint16_t _version = 0;
+		std::vector<OmniTrak_Parse_Chunk> _chunks;
+		std::vector<OmniTrak_Parse_Gap> _gaps;
+		uint64_t _blocks = 0;
+		uint64_t _respeculated_bytes = 0;
+};
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_PARALLEL_H_
@@ -0,0 +1,383 @@
+/*
+	OmniTrak_File_Reader.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Zero-Copy Block Reader
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Memory-maps an *.OmniTrak file and walks its blocks as lightweight views
+	(block code, file offset, payload pointer and size) without copying or
+	allocating per block. Payload sizes come from the OFBC_BLOCK_LAYOUTS table
+	in OmniTrak_File_Block_Sizes.h, so unwanted blocks are skipped without
+	being decoded.
+
+		OmniTrak_File_Map map;
+		if (!map.open("session.OmniTrak")) { ... map.error() ... }
+		OmniTrak_Block_Reader reader(map.data(), map.size());
+		for (const OmniTrak_Block_View &blk : reader) {
+			if (blk.code == OFBC_MLX90640_PIXELS_TO) { ... blk.get<uint32_t>(1) ... }
+		}
+		if (reader.status() != OMNITRAK_READ_END) { ... reader.status_string() ... }
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_READER_H_
+#define _VULINTUS_OMNITRAK_FILE_READER_H_
+
+#include <bitset>
+#include <initializer_list>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "OmniTrak_File_Block_Sizes.h"
+
+
+//Read-only memory mapping of a whole file.
+class OmniTrak_File_Map {
+
+	public:
+
+		OmniTrak_File_Map() = default;
+		OmniTrak_File_Map(const OmniTrak_File_Map &) = delete;
+		OmniTrak_File_Map &operator=(const OmniTrak_File_Map &) = delete;
+
+		OmniTrak_File_Map(OmniTrak_File_Map &&other) noexcept
+		{
+			*this = static_cast<OmniTrak_File_Map &&>(other);
+		}
+
+		OmniTrak_File_Map &operator=(OmniTrak_File_Map &&other) noexcept
+		{
+			if (this != &other) {
+				close();
+				_data = other._data;
+				_size = other._size;
+				_error = other._error;
+				other._data = nullptr;
+				other._size = 0;
+			}
+			return *this;
+		}
+
+		~OmniTrak_File_Map()
+		{
+			close();
+		}
+
+		//Maps the file, returning false and setting error() on failure.
+		bool open(const char *path)
+		{
+			close();
+			_error.clear();
+#if defined(_WIN32)
+			HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (file == INVALID_HANDLE_VALUE) {
+				return fail("can't open", path);
+			}
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file, &size)) {
+				CloseHandle(file);
+				return fail("can't get the size of", path);
+			}
+			_size = (uint64_t) size.QuadPart;
+			if (_size > 0) {
+				HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (mapping != NULL) {
+					_data = (const uint8_t *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					CloseHandle(mapping);
+				}
+			}
+			CloseHandle(file);
+#else
+			int fd = ::open(path, O_RDONLY);
+			if (fd < 0) {
+				return fail("can't open", path);
+			}
+			struct stat st;
+			if (fstat(fd, &st) != 0) {
+				::close(fd);
+				return fail("can't get the size of", path);
+			}
+			_size = (uint64_t) st.st_size;
+			if (_size > 0) {
+				void *p = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+				if (p != MAP_FAILED) {
+					_data = (const uint8_t *) p;
+					madvise(p, _size, MADV_SEQUENTIAL);
+				}
+			}
+			::close(fd);
+#endif
+			if (_size > 0 && _data == nullptr) {
+				_size = 0;
+				return fail("can't memory-map", path);
+			}
+			return true;
+		}
+
+		void close()
+		{
+			if (_data != nullptr) {
+#if defined(_WIN32)
+				UnmapViewOfFile(_data);
+#else
+				munmap((void *) _data, _size);
+#endif
+			}
+			_data = nullptr;
+			_size = 0;
+		}
+
+		const uint8_t *data() const { return _data; }
+		uint64_t size() const { return _size; }
+		const std::string &error() const { return _error; }
+
+	private:
+
+		bool fail(const char *what, const char *path)
+		{
+			_error = std::string(what) + " \"" + path + "\"";
+			return false;
+		}
+
+		const uint8_t *_data = nullptr;
+		uint64_t _size = 0;
+		std::string _error;
+};
+
+
+//A single block inside a mapped file. Valid only while the mapping is.
+struct OmniTrak_Block_View {
+
+	uint16_t code;                                                 // OFBC block code.
+	uint64_t offset;                                               // File offset of the block code.
+	const uint8_t *payload;                                        // First payload byte (just past the code).
+	uint64_t payload_size;                                         // Payload bytes, excluding the 2-byte code.
+
+	//Reads a little-endian value at a payload offset (unaligned-safe).
+	template <typename T> T get(uint64_t at) const
+	{
+		T value;
+		memcpy(&value, payload + at, sizeof(T));
+		return value;
+	}
+
+	uint64_t end_offset() const { return offset + 2 + payload_size; }
+	const char *name() const { return ofbc_block_name(code); }
+};
+
+
+//Set of block codes, for skipping everything but the blocks of interest.
+class OmniTrak_Code_Set {
+
+	public:
+
+		OmniTrak_Code_Set() = default;
+		OmniTrak_Code_Set(std::initializer_list<uint16_t> codes)
+		{
+			for (uint16_t code : codes) {
+				_bits.set(code);
+			}
+		}
+
+		void add(uint16_t code) { _bits.set(code); }
+		void remove(uint16_t code) { _bits.reset(code); }
+		bool contains(uint16_t code) const { return _bits.test(code); }
+
+	private:
+
+		std::bitset<65536> _bits;
+};
+
+
+enum OmniTrak_Read_Status : uint8_t {
+	OMNITRAK_READ_OK,                                              // Positioned on a block; more may follow.
+	OMNITRAK_READ_END,                                             // Cleanly reached the end of the file.
+	OMNITRAK_READ_BAD_HEADER,                                      // The file doesn't start with 0xABCD, FILE_VERSION.
+	OMNITRAK_READ_TRUNCATED,                                       // The last block runs past the end of the file.
+	OMNITRAK_READ_UNKNOWN_CODE,                                    // A block code that isn't in the layout table.
+	OMNITRAK_READ_UNDEFINED_LAYOUT,                                // A known block code whose payload size can't be found.
+	OMNITRAK_READ_BAD_VERSION,                                     // A versioned block with an unrecognized version.
+	OMNITRAK_READ_INVALID_BLOCK,                                   // A payload whose contents are impossible.
+	OMNITRAK_READ_MARKED_INCOMPLETE,                               // The file ends inside a block announced by an INCOMPLETE_BLOCK marker.
+};
+
+inline const char *omnitrak_read_status_string(OmniTrak_Read_Status status)
+{
+	switch (status) {
+		case OMNITRAK_READ_OK:					return "OK";
+		case OMNITRAK_READ_END:					return "end of file";
+		case OMNITRAK_READ_BAD_HEADER:			return "missing 0xABCD file header";
+		case OMNITRAK_READ_TRUNCATED:			return "truncated block";
+		case OMNITRAK_READ_UNKNOWN_CODE:		return "unrecognized block code";
+		case OMNITRAK_READ_UNDEFINED_LAYOUT:	return "block layout not defined";
+		case OMNITRAK_READ_BAD_VERSION:			return "unrecognized block version";
+		case OMNITRAK_READ_INVALID_BLOCK:		return "invalid block contents";
+		case OMNITRAK_READ_MARKED_INCOMPLETE:	return "ends in a block marked incomplete";
+	}
+	return "unknown";
+}
+
+
+//Sequential block walker over an in-memory (typically memory-mapped) file.
+class OmniTrak_Block_Reader {
+
+	public:
+
+		OmniTrak_Block_Reader(const uint8_t *data, uint64_t size)
+			: _data(data), _size(size)
+		{
+			if (size < OFBC_FILE_HEADER_SIZE
+					|| load_u16(0) != OFBC_OMNITRAK_FILE_VERIFY
+					|| load_u16(2) != OFBC_FILE_VERSION) {
+				_status = OMNITRAK_READ_BAD_HEADER;
+				return;
+			}
+			_version = load_u16(4);
+			_pos = OFBC_FILE_HEADER_SIZE;
+		}
+
+		//Starts walking from a known block boundary rather than the file header.
+		OmniTrak_Block_Reader(const uint8_t *data, uint64_t size, uint64_t start)
+			: _data(data), _size(size), _pos(start) {}
+
+		//Advances to the next block, returning false at the end of the file or on an error.
+		bool next(OmniTrak_Block_View &blk)
+		{
+			if (_status != OMNITRAK_READ_OK) {
+				return false;
+			}
+			if (_pos == _size) {
+				_status = OMNITRAK_READ_END;
+				return false;
+			}
+			if (_size - _pos < 2) {
+				_status = truncated_status();
+				return false;
+			}
+			uint16_t code = load_u16(_pos);
+			const uint8_t *payload = _data + _pos + 2;
+			uint64_t avail = _size - _pos - 2;
+			OFBC_Size_Result res = ofbc_payload_size(code, payload, avail);
+			switch (res.status) {
+				case OFBC_SIZE_OK:
+					if (res.size > avail) {
+						_status = truncated_status();
+						return false;
+					}
+					break;
+				case OFBC_SIZE_NEED_MORE:			_status = truncated_status(); return false;
+				case OFBC_SIZE_UNKNOWN_CODE:		_status = OMNITRAK_READ_UNKNOWN_CODE; return false;
+				case OFBC_SIZE_UNDEFINED_LAYOUT:	_status = OMNITRAK_READ_UNDEFINED_LAYOUT; return false;
+				case OFBC_SIZE_BAD_VERSION:			_status = OMNITRAK_READ_BAD_VERSION; return false;
+				case OFBC_SIZE_INVALID:				_status = OMNITRAK_READ_INVALID_BLOCK; return false;
+			}
+			blk.code = code;
+			blk.offset = _pos;
+			blk.payload = payload;
+			blk.payload_size = res.size;
+			_pos += 2 + res.size;
+			if (code == OFBC_INCOMPLETE_BLOCK) {                   // Only the block right after the marker can be the one it announces.
+				_incomplete_start = (blk.get<uint32_t>(2) == (uint32_t) _pos) ? _pos : UINT64_MAX;
+			}
+			return true;
+		}
+
+		//Advances to the next block whose code is in "wanted", skipping the rest undecoded.
+		bool next(OmniTrak_Block_View &blk, const OmniTrak_Code_Set &wanted)
+		{
+			while (next(blk)) {
+				if (wanted.contains(blk.code)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		OmniTrak_Read_Status status() const { return _status; }
+		const char *status_string() const { return omnitrak_read_status_string(_status); }
+		uint64_t position() const { return _pos; }                 // Offset of the next (or offending) block.
+		uint16_t file_version() const { return _version; }
+		const uint8_t *data() const { return _data; }
+		uint64_t size() const { return _size; }
+
+		//Input iterator for range-based for loops.
+		class iterator {
+
+			public:
+
+				iterator() = default;
+				explicit iterator(OmniTrak_Block_Reader *reader) : _reader(reader) { ++(*this); }
+
+				const OmniTrak_Block_View &operator*() const { return _blk; }
+				const OmniTrak_Block_View *operator->() const { return &_blk; }
+
+				iterator &operator++()
+				{
+					if (_reader && !_reader->next(_blk)) {
+						_reader = nullptr;
+					}
+					return *this;
+				}
+
+				bool operator==(const iterator &other) const { return _reader == other._reader; }
+				bool operator!=(const iterator &other) const { return _reader != other._reader; }
+
+			private:
+
+				OmniTrak_Block_Reader *_reader = nullptr;
+				OmniTrak_Block_View _blk {};
+		};
+
+		iterator begin() { return iterator(this); }
+		iterator end() { return iterator(); }
+
+	private:
+
+		//A block cut off by the end of the file is expected if an INCOMPLETE_BLOCK marker announced
+		//it, or if it's the marker itself (a buffered writer can split either across two writes).
+		OmniTrak_Read_Status truncated_status() const
+		{
+			if (_pos == _incomplete_start) {
+				return OMNITRAK_READ_MARKED_INCOMPLETE;
+			}
+			uint64_t avail = _size - _pos;
+			bool marker = avail >= 1 && _data[_pos] == (OFBC_INCOMPLETE_BLOCK & 0xFF)
+				&& (avail == 1 || _data[_pos + 1] == (OFBC_INCOMPLETE_BLOCK >> 8));
+			return marker ? OMNITRAK_READ_MARKED_INCOMPLETE : OMNITRAK_READ_TRUNCATED;
+		}
+
+		uint16_t load_u16(uint64_t at) const
+		{
+			uint16_t value;
+			memcpy(&value, _data + at, sizeof(value));
+			return value;
+		}
+
+		const uint8_t *_data;
+		uint64_t _size;
+		uint64_t _pos = 0;
+		uint16_t _version = 0;
+		OmniTrak_Read_Status _status = OMNITRAK_READ_OK;
+		uint64_t _incomplete_start = UINT64_MAX;                   // Offset of the block announced by the last INCOMPLETE_BLOCK marker.
+};
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_READER_H_
@@ -0,0 +1,422 @@
+/*
+	OmniTrak_File_Synth.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Synthetic Session Generator
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Writes realistic synthetic *.OmniTrak sessions, of any size, through an
+	OmniTrak_File_Writer, for benchmarking and for regression fixtures. A
+	simulated device runs the block streams of OMNITRAK_SYNTH_STREAMS, each
+	at its own rate, against drifting millis() and micros() clocks (with
+	rollover markers) and a serial date clock:
+
+		clock			CLOCK_SYNC, plus file start/stop, time zone, and rollover blocks
+		thermal			AMG8833_PIXELS_FL and HTPA32X32_PIXELS_INT_K frames of a moving warm blob
+		environment		BME280 temperature, pressure, and humidity
+		operant			POKE_BITMASK and CAPSENSE_VALUE
+		scope			two-channel SCOPE_TRACE recordings
+
+	Each family's rates are scaled by a weight (see set_mix()); a weight of
+	0 leaves the family out. Every generated block has a working reader in
+	OmniTrakFileRead.m, so the same files can be read back in MATLAB.
+
+	The output is deterministic for a given configuration and seed. Damage
+	(overwritten bytes, or a truncated tail) is chosen separately, by
+	omnitrak_synth_damage(), so a clean and a damaged copy of the same file
+	can be compared.
+
+		OmniTrak_Synth_Config config;
+		config.target_bytes = omnitrak_synth_parse_size("2G");
+		config.set_mix("thermal=2,scope=0");
+		OmniTrak_Synthesizer synth(config);
+		synth.write(writer);                                       // Any OmniTrak_File_Writer.
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_SYNTH_H_
+#define _VULINTUS_OMNITRAK_FILE_SYNTH_H_
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "OmniTrak_File_Block_Codes.h"
+#include "OmniTrak_File_Block_Sizes.h"
+
+enum OmniTrak_Synth_Family : uint8_t {
+	OMNITRAK_SYNTH_CLOCK,
+	OMNITRAK_SYNTH_THERMAL,
+	OMNITRAK_SYNTH_ENVIRONMENT,
+	OMNITRAK_SYNTH_OPERANT,
+	OMNITRAK_SYNTH_SCOPE,
+	OMNITRAK_SYNTH_FAMILIES,
+	OMNITRAK_SYNTH_OTHER = OMNITRAK_SYNTH_FAMILIES,                // Block codes the generator doesn't write.
+};
+
+const char *const OMNITRAK_SYNTH_FAMILY_NAMES[] = {"clock", "thermal", "environment", "operant", "scope", "other"};
+
+struct OmniTrak_Synth_Stream {
+	uint16_t code;
+	OmniTrak_Synth_Family family;
+	double rate;                                                   // Blocks per simulated second, at a weight of 1.
+};
+
+const OmniTrak_Synth_Stream OMNITRAK_SYNTH_STREAMS[] = {
+	{OFBC_CLOCK_SYNC,					OMNITRAK_SYNTH_CLOCK,		1.0},
+	{OFBC_AMG8833_PIXELS_FL,			OMNITRAK_SYNTH_THERMAL,		10.0},
+	{OFBC_HTPA32X32_PIXELS_INT_K,		OMNITRAK_SYNTH_THERMAL,		8.0},
+	{OFBC_BME280_TEMP_FL,				OMNITRAK_SYNTH_ENVIRONMENT,	1.0},
+	{OFBC_BME280_PRES_FL,				OMNITRAK_SYNTH_ENVIRONMENT,	1.0},
+	{OFBC_BME280_HUM_FL,				OMNITRAK_SYNTH_ENVIRONMENT,	1.0},
+	{OFBC_POKE_BITMASK,					OMNITRAK_SYNTH_OPERANT,		0.5},   // Irregular, Poisson-timed.
+	{OFBC_CAPSENSE_VALUE,				OMNITRAK_SYNTH_OPERANT,		20.0},
+	{OFBC_SCOPE_TRACE,					OMNITRAK_SYNTH_SCOPE,		0.05},
+};
+
+const size_t OMNITRAK_SYNTH_NUM_STREAMS = sizeof(OMNITRAK_SYNTH_STREAMS) / sizeof(OMNITRAK_SYNTH_STREAMS[0]);
+const uint32_t OMNITRAK_SYNTH_SCOPE_SAMPLES = 2000;                // Samples per SCOPE_TRACE signal.
+const uint8_t OMNITRAK_SYNTH_SENSORS = 3;                          // Nosepoke / capacitive sensors.
+
+//Which family a block code belongs to, for grouping any file's blocks the way the generator does.
+inline OmniTrak_Synth_Family omnitrak_synth_family(uint16_t code)
+{
+	for (const OmniTrak_Synth_Stream &s : OMNITRAK_SYNTH_STREAMS) {
+		if (s.code == code) {
+			return s.family;
+		}
+	}
+	switch (code) {
+		case OFBC_CLOCK_FILE_START:
+		case OFBC_CLOCK_FILE_STOP:
+		case OFBC_MS_FILE_START:
+		case OFBC_MS_FILE_STOP:
+		case OFBC_TIME_ZONE_OFFSET:
+		case OFBC_MS_TIMER_ROLLOVER:
+		case OFBC_US_TIMER_ROLLOVER:	return OMNITRAK_SYNTH_CLOCK;
+	}
+	return OMNITRAK_SYNTH_OTHER;
+}
+
+//Parses a byte count with an optional K, M, G, or T suffix (powers of 1024). Returns 0 if invalid.
+inline uint64_t omnitrak_synth_parse_size(const char *str)
+{
+	char *end;
+	double value = strtod(str, &end);
+	double scale = 1;
+	switch (*end) {
+		case 'k': case 'K':	scale = 1024.0; end++; break;
+		case 'm': case 'M':	scale = 1024.0 * 1024; end++; break;
+		case 'g': case 'G':	scale = 1024.0 * 1024 * 1024; end++; break;
+		case 't': case 'T':	scale = 1024.0 * 1024 * 1024 * 1024; end++; break;
+	}
+	if (end == str || *end != '\0' || !(value > 0)) {
+		return 0;
+	}
+	return (uint64_t) (value * scale);
+}
+
+
+//Small, fast PRNG (splitmix64), so that generating a file costs much less than writing it.
+struct OmniTrak_Synth_Random {
+
+	uint64_t state;
+
+	explicit OmniTrak_Synth_Random(uint64_t seed) : state(seed) {}
+
+	uint64_t next()
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }   // [0, 1)
+	double noise() { return uniform() + uniform() - 1.0; }      // Triangular, [-1, 1).
+};
+
+
+struct OmniTrak_Synth_Config {
+
+	uint64_t target_bytes = 64ull << 20;                           // The file ends with the first block past this size.
+	double weights[OMNITRAK_SYNTH_FAMILIES] = {1, 1, 1, 1, 1};
+	uint64_t seed = 1;
+	double start_datenum = 739000.375;                             // Local serial date of the first block.
+	double time_zone = -5.0 / 24;                                  // Local - UTC, in days.
+	double clock_drift = 30e-6;                                    // Device crystal error, as a fraction.
+
+	//Sets family weights from a list like "thermal=2,scope=0". Families left out keep
+	//their weights. Returns false on an unknown family or a bad number.
+	bool set_mix(const char *mix)
+	{
+		while (*mix) {
+			const char *eq = strchr(mix, '=');
+			if (!eq) {
+				return false;
+			}
+			int family = -1;
+			for (int f = 0; f < OMNITRAK_SYNTH_FAMILIES; f++) {
+				if (strlen(OMNITRAK_SYNTH_FAMILY_NAMES[f]) == (size_t) (eq - mix) && !strncmp(mix, OMNITRAK_SYNTH_FAMILY_NAMES[f], eq - mix)) {
+					family = f;
+				}
+			}
+			char *end;
+			double weight = strtod(eq + 1, &end);
+			if (family < 0 || end == eq + 1 || weight < 0 || (*end != ',' && *end != '\0')) {
+				return false;
+			}
+			weights[family] = weight;
+			mix = (*end == ',') ? end + 1 : end;
+		}
+		return true;
+	}
+};
+
+
+class OmniTrak_Synthesizer {
+
+	public:
+
+		explicit OmniTrak_Synthesizer(const OmniTrak_Synth_Config &config) : _config(config), _rng(config.seed)
+		{
+			for (size_t s = 0; s < OMNITRAK_SYNTH_NUM_STREAMS; s++) {
+				double rate = OMNITRAK_SYNTH_STREAMS[s].rate * config.weights[OMNITRAK_SYNTH_STREAMS[s].family];
+				_period[s] = (rate > 0) ? 1.0 / rate : INFINITY;
+				_next[s] = (rate > 0) ? _period[s] * _rng.uniform() : INFINITY;
+			}
+			for (int i = 0; i < 64; i++) {                         // Room-temperature backgrounds with a gradient.
+				_amg_base[i] = 22.0f + 0.15f * (float) (i / 8) + 0.05f * (float) (i % 8);
+			}
+			for (int i = 0; i < 1024; i++) {
+				_htpa_base[i] = (uint16_t) (2951 + (i / 32) / 2 + (i % 32) / 4);
+			}
+			_millis0 = (uint32_t) (_rng.next() % 3600000);
+			_micros0 = (uint32_t) _rng.next();                     // Wraps every 71.6 minutes.
+		}
+
+		//Writes a whole session: the header, the file-start blocks, the block streams until
+		//the target size is reached, and the file-stop blocks. Returns the writer's status.
+		template <typename Writer> bool write(Writer &writer)
+		{
+			writer.begin();
+			writer.template write_block<OFBC_CLOCK_FILE_START>(_config.start_datenum);
+			writer.template write_block<OFBC_MS_FILE_START>(_millis0);
+			writer.template write_block<OFBC_TIME_ZONE_OFFSET>(_config.time_zone);
+			count(OFBC_CLOCK_FILE_START, 8);
+			count(OFBC_MS_FILE_START, 4);
+			count(OFBC_TIME_ZONE_OFFSET, 8);
+			uint64_t last_millis = _millis0, last_micros = _micros0;
+			while (writer.position() < _config.target_bytes && writer.ok()) {
+				size_t s = 0;
+				for (size_t i = 1; i < OMNITRAK_SYNTH_NUM_STREAMS; i++) {
+					if (_next[i] < _next[s]) {
+						s = i;
+					}
+				}
+				if (isinf(_next[s])) {                             // Every family weighted 0.
+					break;
+				}
+				_time = _next[s];
+				uint64_t millis = device_millis(), micros = device_micros();
+				for (; (last_millis >> 32) < (millis >> 32); last_millis += 1ull << 32) {
+					writer.template write_block<OFBC_MS_TIMER_ROLLOVER>();
+					count(OFBC_MS_TIMER_ROLLOVER, 0);
+				}
+				for (; (last_micros >> 32) < (micros >> 32); last_micros += 1ull << 32) {
+					writer.template write_block<OFBC_US_TIMER_ROLLOVER>();
+					count(OFBC_US_TIMER_ROLLOVER, 0);
+				}
+				write_stream(writer, s, (uint32_t) millis, (uint32_t) micros);
+				_next[s] += (OMNITRAK_SYNTH_STREAMS[s].code == OFBC_POKE_BITMASK) ? -_period[s] * log(1.0 - _rng.uniform()) : _period[s];
+				writer.service();
+			}
+			writer.template write_block<OFBC_CLOCK_FILE_STOP>(datenum());
+			writer.template write_block<OFBC_MS_FILE_STOP>((uint32_t) device_millis());
+			count(OFBC_CLOCK_FILE_STOP, 8);
+			count(OFBC_MS_FILE_STOP, 4);
+			return writer.close();
+		}
+
+		uint64_t blocks(OmniTrak_Synth_Family family) const { return _blocks[family]; }
+		uint64_t payload_bytes(OmniTrak_Synth_Family family) const { return _bytes[family]; }   // Codes and payloads.
+		double seconds() const { return _time; }                   // Simulated session length.
+
+	private:
+
+		template <typename Writer> void write_stream(Writer &writer, size_t s, uint32_t millis, uint32_t micros)
+		{
+			uint16_t code = OMNITRAK_SYNTH_STREAMS[s].code;
+			double t = _time;
+			switch (code) {
+				case OFBC_CLOCK_SYNC: {                            // Datenum, millis, and micros, read together.
+					writer.begin_block(OFBC_CLOCK_SYNC, 3 + 8 + 4 + 4);
+					writer.put((uint8_t) 1);
+					writer.put((uint8_t) 0);
+					writer.put((uint8_t) 0x07);
+					writer.put(datenum() + _rng.noise() * 2e-3 / 86400);   // PC clock jitter.
+					writer.put(millis);
+					writer.put(micros);
+					count(code, 19);
+					break;
+				}
+				case OFBC_AMG8833_PIXELS_FL: {
+					float pixels[64];
+					double bx = 3.5 + 3.0 * sin(t * 0.21), by = 3.5 + 3.0 * cos(t * 0.13);
+					for (int i = 0; i < 64; i++) {
+						double dx = (i % 8) - bx, dy = (i / 8) - by;
+						pixels[i] = _amg_base[i] + (float) (8.0 * exp(-(dx * dx + dy * dy) / 3.0)) + 0.25f * (float) (int) (_rng.next() % 3);
+					}
+					writer.template write_block<OFBC_AMG8833_PIXELS_FL>((uint8_t) 0, millis, pixels);
+					count(code, 5 + 256);
+					break;
+				}
+				case OFBC_HTPA32X32_PIXELS_INT_K: {
+					uint16_t pixels[1024];
+					double bx = 15.5 + 12.0 * sin(t * 0.17), by = 15.5 + 12.0 * cos(t * 0.11);
+					for (int i = 0; i < 1024; i += 16) {
+						uint64_t bits = _rng.next();
+						double dy = (i / 32) - by;
+						for (int j = 0; j < 16; j++, bits >>= 4) {
+							double dx = ((i + j) % 32) - bx;
+							double r2 = dx * dx + dy * dy;
+							uint16_t blob = (r2 < 64) ? (uint16_t) (90.0 * (1.0 - r2 / 64)) : 0;
+							pixels[i + j] = (uint16_t) (_htpa_base[i + j] + blob + (bits & 0x7));
+						}
+					}
+					writer.template write_block<OFBC_HTPA32X32_PIXELS_INT_K>((uint8_t) 0, millis, pixels);
+					count(code, 5 + 2048);
+					break;
+				}
+				case OFBC_BME280_TEMP_FL:
+					_temp += 0.02 * _rng.noise() + 0.001 * (22.5 - _temp);
+					writer.template write_block<OFBC_BME280_TEMP_FL>((uint8_t) 0, millis, (float) _temp);
+					count(code, 9);
+					break;
+				case OFBC_BME280_PRES_FL:
+					writer.template write_block<OFBC_BME280_PRES_FL>((uint8_t) 0, millis, (float) (101325.0 + 150.0 * sin(t / 7200.0) + 3.0 * _rng.noise()));
+					count(code, 9);
+					break;
+				case OFBC_BME280_HUM_FL:
+					writer.template write_block<OFBC_BME280_HUM_FL>((uint8_t) 0, millis, (float) (42.0 + 4.0 * sin(t / 5400.0) + 0.2 * _rng.noise()));
+					count(code, 9);
+					break;
+				case OFBC_POKE_BITMASK:
+					_pokes ^= (uint8_t) (1 << (_rng.next() % OMNITRAK_SYNTH_SENSORS));
+					writer.template write_block<OFBC_POKE_BITMASK>((uint8_t) 1, datenum(), (float) micros, OMNITRAK_SYNTH_SENSORS, _pokes);
+					count(code, 15);
+					break;
+				case OFBC_CAPSENSE_VALUE: {
+					uint8_t sensor = (uint8_t) (_capsense_i++ % OMNITRAK_SYNTH_SENSORS);
+					double value = 600.0 + ((_pokes >> sensor) & 1) * 900.0 + 20.0 * _rng.noise();
+					writer.template write_block<OFBC_CAPSENSE_VALUE>((uint8_t) 1, datenum(), (float) micros, OMNITRAK_SYNTH_SENSORS,
+						_pokes, sensor, (uint16_t) value);
+					count(code, 18);
+					break;
+				}
+				case OFBC_SCOPE_TRACE:
+					write_scope_trace(writer);
+					break;
+			}
+		}
+
+		//A 10 kHz, two-channel recording: a noisy 50 Hz sine and a TTL-like square wave.
+		template <typename Writer> void write_scope_trace(Writer &writer)
+		{
+			static const char *const names[] = {"sample_rate", "gain"};
+			const double params[] = {10000.0, 1.0};
+			const uint32_t n = OMNITRAK_SYNTH_SCOPE_SAMPLES;
+			uint32_t size = 2 + 1 + 8 + 1 + 4 * n * 3;
+			for (const char *name : names) {
+				size += 1 + (uint32_t) strlen(name) + 8;
+			}
+			writer.begin_block(OFBC_SCOPE_TRACE, size);
+			writer.put((uint16_t) 1);
+			writer.put((uint8_t) 2);
+			for (int i = 0; i < 2; i++) {
+				writer.put((uint8_t) strlen(names[i]));
+				writer.put_bytes(names[i], (uint32_t) strlen(names[i]));
+				writer.put(params[i]);
+			}
+			writer.put((uint64_t) n);
+			writer.put((uint8_t) 2);
+			for (uint32_t i = 0; i < n; i++) {
+				writer.put((float) (i / params[0]));
+			}
+			double phase = _rng.uniform() * 6.283185307179586;
+			for (uint32_t i = 0; i < n; i++) {
+				writer.put((float) (0.5 * sin(phase + 6.283185307179586 * 50.0 * i / params[0]) + 0.01 * _rng.noise()));
+			}
+			for (uint32_t i = 0; i < n; i++) {
+				writer.put((float) (((i / 250) & 1) ? 3.3 : 0.0));
+			}
+			count(OFBC_SCOPE_TRACE, size);
+		}
+
+		void count(uint16_t code, uint32_t payload_size)
+		{
+			OmniTrak_Synth_Family family = omnitrak_synth_family(code);
+			_blocks[family]++;
+			_bytes[family] += 2 + payload_size;
+		}
+
+		double datenum() const { return _config.start_datenum + _time / 86400.0; }
+		uint64_t device_millis() const { return _millis0 + (uint64_t) (_time * 1e3 * (1.0 + _config.clock_drift)); }
+		uint64_t device_micros() const { return _micros0 + (uint64_t) (_time * 1e6 * (1.0 + _config.clock_drift)); }
+
+		OmniTrak_Synth_Config _config;
+		OmniTrak_Synth_Random _rng;
+		double _period[OMNITRAK_SYNTH_NUM_STREAMS];
+		double _next[OMNITRAK_SYNTH_NUM_STREAMS];                  // Simulated time of each stream's next block.
+		double _time = 0;
+		uint32_t _millis0, _micros0;
+		float _amg_base[64];
+		uint16_t _htpa_base[1024];
+		double _temp = 22.5;
+		uint8_t _pokes = 0;
+		uint64_t _capsense_i = 0;
+		uint64_t _blocks[OMNITRAK_SYNTH_FAMILIES + 1] = {};
+		uint64_t _bytes[OMNITRAK_SYNTH_FAMILIES + 1] = {};
+};
+
+
+//A stretch of a file to overwrite with random bytes.
+struct OmniTrak_Synth_Damage {
+	uint64_t offset;
+	uint32_t length;
+};
+
+//Picks "count" stretches of 1-16 bytes to overwrite, past the file header, in file order.
+inline std::vector<OmniTrak_Synth_Damage> omnitrak_synth_damage(uint64_t file_size, uint32_t count, uint64_t seed)
+{
+	std::vector<OmniTrak_Synth_Damage> damage;
+	OmniTrak_Synth_Random rng(seed ^ 0xDA3A6Eull);
+	if (file_size <= OFBC_FILE_HEADER_SIZE + 16) {
+		return damage;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t length = 1 + (uint32_t) (rng.next() % 16);
+		damage.push_back({OFBC_FILE_HEADER_SIZE + rng.next() % (file_size - OFBC_FILE_HEADER_SIZE - length), length});
+	}
+	std::sort(damage.begin(), damage.end(),
+		[](const OmniTrak_Synth_Damage &a, const OmniTrak_Synth_Damage &b) { return a.offset < b.offset; });
+	return damage;
+}
+
+//Fills the bytes of one damaged stretch.
+inline void omnitrak_synth_damage_bytes(const OmniTrak_Synth_Damage &d, uint8_t *bytes)
+{
+	OmniTrak_Synth_Random rng(d.offset);
+	for (uint32_t i = 0; i < d.length; i++) {
+		bytes[i] = (uint8_t) rng.next();
+	}
+}
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_SYNTH_H_
@@ -0,0 +1,468 @@
+/*
+	OmniTrak_File_Tail.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Live Tail Reader
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Follows an *.OmniTrak file while a device or program is still writing
+	it. Each poll() reads only the bytes appended since the last poll,
+	decodes the complete blocks among them, and keeps any torn trailing
+	block to finish on a later poll, so the cost of an update depends on
+	what was appended, not on the size of the file. If the file shrinks or
+	is replaced (a new file renamed over the path), the tail starts over
+	from the beginning of whatever the path now names (see restarts()),
+	even after an unreadable block has stopped it.
+
+	Decoded behavioral events (POKE_BITMASK, CAPSENSE_BITMASK,
+	CAPSENSE_VALUE, PELLET_DISPENSE, FR_TASK_TRIAL) are handed to a callback,
+	or pushed into a lock-free single-producer/single-consumer queue for a
+	separate UI thread. poll_blocks() hands over every new block instead.
+
+		OmniTrak_File_Tail tail;
+		tail.open("session.OmniTrak");
+		while (running) {
+			tail.wait(1000);                                       // Wakes on a write (inotify on Linux), or after 1 s.
+			tail.poll([](const OmniTrak_Live_Event &e) { ... });
+		}
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_TAIL_H_
+#define _VULINTUS_OMNITRAK_FILE_TAIL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+	#include <poll.h>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+#include "OmniTrak_File_Reader.h"
+
+const size_t OMNITRAK_TAIL_READ_SIZE = 1 << 20;                    // Bytes read from the file per chunk.
+
+
+//Decoded behavioral event fields.
+struct OmniTrak_Poke_Event {                                       // POKE_BITMASK and CAPSENSE_BITMASK.
+	double datenum;
+	float micros;
+	uint8_t num_sensors;
+	uint8_t bitmask;
+};
+
+struct OmniTrak_Capsense_Event {                                   // CAPSENSE_VALUE.
+	double datenum;
+	float micros;
+	uint8_t num_sensors;
+	uint8_t bitmask;
+	uint8_t sensor;
+	uint16_t value;
+};
+
+struct OmniTrak_Pellet_Event {                                     // PELLET_DISPENSE.
+	uint32_t millis;
+	uint8_t dispenser;
+	uint16_t trial;
+};
+
+struct OmniTrak_Trial_Event {                                      // FR_TASK_TRIAL.
+	uint16_t trial;
+	double datenum;
+	char outcome;
+	uint8_t target_poke;
+	uint8_t thresh;
+	uint16_t poke_count;
+	float hit_time;
+	float reward_dur;
+	uint16_t num_licks;
+	uint16_t num_feedings;
+};
+
+struct OmniTrak_Live_Event {
+	uint16_t code;                                                 // OFBC block code; selects the union member.
+	uint64_t offset;                                               // File offset of the block.
+	union {
+		OmniTrak_Poke_Event poke;
+		OmniTrak_Capsense_Event capsense;
+		OmniTrak_Pellet_Event pellet;
+		OmniTrak_Trial_Event trial;
+	};
+};
+
+//Decodes a behavioral event block, returning false for any other block.
+inline bool omnitrak_decode_event(const OmniTrak_Block_View &blk, uint64_t offset, OmniTrak_Live_Event &e)
+{
+	e.code = blk.code;
+	e.offset = offset;
+	switch (blk.code) {
+		case OFBC_POKE_BITMASK:
+		case OFBC_CAPSENSE_BITMASK:
+			e.poke.datenum = blk.get<double>(1);
+			e.poke.micros = blk.get<float>(9);
+			e.poke.num_sensors = blk.payload[13];
+			e.poke.bitmask = blk.payload[14];
+			return true;
+		case OFBC_CAPSENSE_VALUE:
+			e.capsense.datenum = blk.get<double>(1);
+			e.capsense.micros = blk.get<float>(9);
+			e.capsense.num_sensors = blk.payload[13];
+			e.capsense.bitmask = blk.payload[14];
+			e.capsense.sensor = blk.payload[15];
+			e.capsense.value = blk.get<uint16_t>(16);
+			return true;
+		case OFBC_PELLET_DISPENSE:
+			e.pellet.millis = blk.get<uint32_t>(0);
+			e.pellet.dispenser = blk.payload[4];
+			e.pellet.trial = blk.get<uint16_t>(5);
+			return true;
+		case OFBC_FR_TASK_TRIAL:
+			e.trial.trial = blk.get<uint16_t>(2);
+			e.trial.datenum = blk.get<double>(4);
+			e.trial.outcome = (char) blk.payload[12];
+			e.trial.target_poke = blk.payload[13];
+			e.trial.thresh = blk.payload[14];
+			e.trial.poke_count = blk.get<uint16_t>(15);
+			e.trial.hit_time = blk.get<float>(17);
+			e.trial.reward_dur = blk.get<float>(21);
+			e.trial.num_licks = blk.get<uint16_t>(25);
+			e.trial.num_feedings = blk.get<uint16_t>(27);
+			return true;
+	}
+	return false;
+}
+
+
+//Lock-free single-producer, single-consumer ring buffer. CAPACITY must be a power of two.
+template <typename T, size_t CAPACITY>
+class OmniTrak_SPSC_Queue {
+
+	static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "OmniTrak_SPSC_Queue capacity must be a power of two");
+
+	public:
+
+		//Producer side. Returns false if the queue is full.
+		bool push(const T &item)
+		{
+			size_t head = _head.load(std::memory_order_relaxed);
+			if (head - _tail.load(std::memory_order_acquire) == CAPACITY) {
+				return false;
+			}
+			_items[head & (CAPACITY - 1)] = item;
+			_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		//Consumer side. Returns false if the queue is empty.
+		bool pop(T &item)
+		{
+			size_t tail = _tail.load(std::memory_order_relaxed);
+			if (tail == _head.load(std::memory_order_acquire)) {
+				return false;
+			}
+			item = _items[tail & (CAPACITY - 1)];
+			_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t size() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+
+	private:
+
+		alignas(64) std::atomic<size_t> _head {0};                 // Written only by the producer.
+		alignas(64) std::atomic<size_t> _tail {0};                 // Written only by the consumer.
+		alignas(64) T _items[CAPACITY];
+};
+
+
+class OmniTrak_File_Tail {
+
+	public:
+
+		OmniTrak_File_Tail() = default;
+		OmniTrak_File_Tail(const OmniTrak_File_Tail &) = delete;
+		OmniTrak_File_Tail &operator=(const OmniTrak_File_Tail &) = delete;
+
+		~OmniTrak_File_Tail()
+		{
+			close();
+		}
+
+		//Opens the file for following, from the beginning. The file doesn't need to have
+		//its header yet.
+		bool open(const std::string &path)
+		{
+			close();
+			_path = path;
+			_lost = false;
+			_status = OMNITRAK_READ_OK;
+			_base = 0;
+			_buf.clear();
+			_have_header = false;
+			_fp = fopen(path.c_str(), "rb");
+			if (!_fp) {
+				return fail("can't open \"" + path + "\"");
+			}
+#if defined(__linux__)
+			_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (_inotify >= 0 && inotify_add_watch(_inotify, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+				::close(_inotify);
+				_inotify = -1;
+			}
+#endif
+			return true;
+		}
+
+		void close()
+		{
+			if (_fp) {
+				fclose(_fp);
+			}
+			_fp = nullptr;
+#if defined(__linux__)
+			if (_inotify >= 0) {
+				::close(_inotify);
+			}
+			_inotify = -1;
+#endif
+		}
+
+		//Waits up to "timeout_ms" for the file to be written to (inotify on Linux; elsewhere,
+		//or if inotify isn't available, just sleeps). Returns true if a change was seen.
+		bool wait(int timeout_ms)
+		{
+#if defined(__linux__)
+			if (_inotify >= 0) {
+				struct pollfd pfd = {_inotify, POLLIN, 0};
+				bool changed = ::poll(&pfd, 1, timeout_ms) > 0;
+				char events[4096];
+				while (read(_inotify, events, sizeof(events)) > 0) {}  // Drain; one poll() covers them all.
+				return changed;
+			}
+#endif
+			std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+			return false;
+		}
+
+		//Reads newly appended bytes and calls on_block(const OmniTrak_Block_View &, uint64_t offset)
+		//for each newly completed block. The view is only valid during the call. Returns the
+		//number of blocks, or -1 once the file can't be followed any further (see status()),
+		//until the file is replaced or shrinks and is followed again from its start.
+		template <typename Callback> long poll_blocks(Callback &&on_block)
+		{
+			if (!_fp || !follows()) {
+				bool retry = _fp ? moved() : _lost;                // A new file at the path can be followed, even after an error.
+				if (!retry || !restart()) {
+					return -1;
+				}
+			}
+			long count = 0;
+			bool more = true;
+			while (more) {
+				more = read_chunk();
+				if (!_have_header && !check_header()) {
+					return follows() ? count : -1;
+				}
+				OmniTrak_Block_Reader reader(_buf.data(), _buf.size(), _parse_start);
+				OmniTrak_Block_View blk;
+				while (reader.next(blk)) {
+					on_block(blk, _base + blk.offset);
+					count++;
+				}
+				switch (reader.status()) {
+					case OMNITRAK_READ_END:
+					case OMNITRAK_READ_TRUNCATED:
+					case OMNITRAK_READ_MARKED_INCOMPLETE:          // A torn trailing block: keep it and wait for the rest.
+						consume(reader.position());
+						break;
+					default:
+						_status = reader.status();
+						_error_offset = _base + reader.position();
+						consume(reader.position());
+						return -1;
+				}
+			}
+			return count;
+		}
+
+		//Reads newly appended bytes and calls on_event(const OmniTrak_Live_Event &) for each
+		//new behavioral event. Returns the number of events, or -1 (see poll_blocks()).
+		template <typename Callback> long poll(Callback &&on_event)
+		{
+			long events = 0;
+			OmniTrak_Live_Event e;
+			long blocks = poll_blocks([&](const OmniTrak_Block_View &blk, uint64_t offset) {
+				if (omnitrak_decode_event(blk, offset, e)) {
+					on_event(e);
+					events++;
+				}
+			});
+			return blocks < 0 ? -1 : events;
+		}
+
+		//Reads newly appended bytes and pushes each new behavioral event onto "queue". Events
+		//that don't fit are counted in dropped(). Returns the number pushed, or -1.
+		template <size_t CAPACITY> long poll(OmniTrak_SPSC_Queue<OmniTrak_Live_Event, CAPACITY> &queue)
+		{
+			long pushed = 0;
+			long events = poll([&](const OmniTrak_Live_Event &e) {
+				if (queue.push(e)) {
+					pushed++;
+				}
+				else {
+					_dropped++;
+				}
+			});
+			return events < 0 ? -1 : pushed;
+		}
+
+		OmniTrak_Read_Status status() const { return _status; }
+		const char *status_string() const { return omnitrak_read_status_string(_status); }
+		uint64_t complete_bytes() const { return _base + _parse_start; }  // Offset just past the last complete block.
+		uint64_t error_offset() const { return _error_offset; }   // Where an unreadable block was found.
+		uint64_t dropped() const { return _dropped; }
+		uint64_t restarts() const { return _restarts; }           // Times the file shrank or was replaced and was followed again from its start.
+		uint16_t file_version() const { return _version; }
+		const std::string &error() const { return _error; }
+
+	private:
+
+		//True while the file can still be followed (it hasn't hit a bad header or an unreadable block).
+		bool follows() const
+		{
+			return _status == OMNITRAK_READ_OK;
+		}
+
+		//Appends the bytes written since the last read to the buffer, up to OMNITRAK_TAIL_READ_SIZE
+		//at a time, returning true if there may be more to read right away. Starts over from the
+		//beginning if the file has shrunk or been replaced.
+		bool read_chunk()
+		{
+			uint64_t size;
+			bool replaced;
+			if (!stat_file(size, replaced)) {
+				return false;
+			}
+			if ((replaced || size < _base + _buf.size()) && !(restart() && stat_file(size, replaced))) {
+				return false;                                      // The next poll reports the failure.
+			}
+			size_t have = _buf.size();
+			size_t want = (size_t) std::min<uint64_t>(size - (_base + have), OMNITRAK_TAIL_READ_SIZE);
+			if (want == 0) {
+				return false;
+			}
+			clearerr(_fp);                                         // Forget a previous EOF; the file has grown.
+			_buf.resize(have + want);
+			size_t n = fread(_buf.data() + have, 1, want, _fp);
+			_buf.resize(have + n);
+			return n == OMNITRAK_TAIL_READ_SIZE;
+		}
+
+		//True if the file has shrunk below what's been read, or the path now names a different file.
+		bool moved()
+		{
+			uint64_t size;
+			bool replaced;
+			return stat_file(size, replaced) && (replaced || size < _base + _buf.size());
+		}
+
+		//Reopens the path and follows it from the start. If it can't be reopened, polls keep
+		//retrying and return -1 until it can.
+		bool restart()
+		{
+			std::string path = _path;
+			uint64_t restarts = _restarts + 1;
+			if (!open(path)) {
+				_lost = true;
+				return false;
+			}
+			_restarts = restarts;
+			return true;
+		}
+
+		//Gets the size of the open file, and whether the path now names a different file. A
+		//deleted path isn't a replacement; the open file is still followed.
+		bool stat_file(uint64_t &size, bool &replaced)
+		{
+			replaced = false;
+#if defined(_WIN32)
+			struct _stat64 st;
+			if (_fstat64(_fileno(_fp), &st) != 0) {
+				return fail("can't stat \"" + _path + "\"");
+			}
+#else
+			struct stat st, path_st;
+			if (fstat(fileno(_fp), &st) != 0) {
+				return fail("can't stat \"" + _path + "\"");
+			}
+			replaced = stat(_path.c_str(), &path_st) == 0 && (path_st.st_ino != st.st_ino || path_st.st_dev != st.st_dev);
+#endif
+			size = (uint64_t) st.st_size;
+			return true;
+		}
+
+		bool check_header()
+		{
+			if (_buf.size() < OFBC_FILE_HEADER_SIZE) {
+				return false;                                      // Not written yet.
+			}
+			OmniTrak_Block_Reader reader(_buf.data(), _buf.size());
+			if (reader.status() == OMNITRAK_READ_BAD_HEADER) {
+				_status = OMNITRAK_READ_BAD_HEADER;
+				fail("\"" + _path + "\" isn't an *.OmniTrak file");
+				return false;
+			}
+			_version = reader.file_version();
+			_parse_start = OFBC_FILE_HEADER_SIZE;
+			_have_header = true;
+			return true;
+		}
+
+		//Drops the buffered bytes before "pos", keeping a torn trailing block for the next poll.
+		void consume(uint64_t pos)
+		{
+			_buf.erase(_buf.begin(), _buf.begin() + (std::ptrdiff_t) pos);
+			_base += pos;
+			_parse_start = 0;
+		}
+
+		bool fail(const std::string &msg)
+		{
+			_error = msg;
+			return false;
+		}
+
+		std::string _path;
+		FILE *_fp = nullptr;
+		std::vector<uint8_t> _buf;                                 // Unparsed bytes, starting at file offset _base.
+		uint64_t _base = 0;
+		uint64_t _parse_start = 0;                                 // Where block parsing starts in _buf (past the header at first).
+		uint64_t _error_offset = 0;
+		uint64_t _dropped = 0;
+		uint64_t _restarts = 0;
+		uint16_t _version = 0;
+		bool _have_header = false;
+		bool _lost = false;                                        // Reopening after a shrink or replacement failed.
+		OmniTrak_Read_Status _status = OMNITRAK_READ_OK;
+		std::string _error;
+#if defined(__linux__)
+		int _inotify = -1;
+#endif
+};
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_TAIL_H_
@@ -0,0 +1,383 @@
+/*
+	OmniTrak_File_Thermal.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Thermal Camera Frame Decoders
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Decodes thermal-camera pixel blocks into float32 frames, in batches,
+	into a caller-provided contiguous frame stack (frame k starts at
+	frames + k * ofbc_thermal_pixels(code)). Pixels are written row-major,
+	in the same orientation the MATLAB OmniTrakFileRead functions produce:
+
+		MLX90640_PIXELS_TO/IM/INT	24x32, each row reversed (fliplr).
+		AMG8833_PIXELS_FL/INT		8x8, rows in reverse order and each row reversed.
+		HTPA32X32_PIXELS_*			32x32, as stored.
+
+	Values are converted to Celsius:
+
+		MLX90640_PIXELS_TO			float32 Celsius, copied.
+		MLX90640_PIXELS_IM			float32, copied (uncalibrated image values).
+		MLX90640_PIXELS_INT			first 768 of the 834 RAM words, as signed ADC counts. Converting these
+									to Celsius needs the sensor's EEPROM calibration, which isn't applied here.
+		AMG8833_PIXELS_FL			float32 Celsius, copied.
+		AMG8833_PIXELS_INT			int16 x 0.25 C (the AMG8833's pixel resolution).
+		HTPA32X32_PIXELS_FP62		uint8 fixed-point 6.2, i.e. x 0.25 C.
+		HTPA32X32_PIXELS_INT_K		uint16 deciKelvin, x 0.1 - 273.15.
+		HTPA32X32_PIXELS_INT12_C	int12 deciCelsius, x 0.1. Pixel pairs are packed little-endian into
+									3 bytes: p0 = b0 | (b1 & 0x0F) << 8, p1 = b1 >> 4 | b2 << 4.
+
+	The vectorized decoders are used when the compiler targets AVX2 (-mavx2)
+	or SSE4.1 (-msse4.1); otherwise, or with OFBC_THERMAL_NO_SIMD defined,
+	the scalar decoders are used. The scalar decoders are always available
+	as ofbc_decode_thermal_frames_scalar(), as a reference.
+
+		float frames[64 * 768];
+		uint32_t millis[64];
+		OmniTrak_Block_Reader reader(map.data(), map.size());
+		size_t n;
+		while ((n = omnitrak_read_thermal_frames(reader, OFBC_MLX90640_PIXELS_TO, frames, 64, millis)) > 0) { ... }
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_THERMAL_H_
+#define _VULINTUS_OMNITRAK_FILE_THERMAL_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "OmniTrak_File_Reader.h"
+
+#if !defined(OFBC_THERMAL_NO_SIMD) && defined(__AVX2__)
+	#define OFBC_THERMAL_SIMD 2
+	#include <immintrin.h>
+#elif !defined(OFBC_THERMAL_NO_SIMD) && defined(__SSE4_1__)
+	#define OFBC_THERMAL_SIMD 1
+	#include <smmintrin.h>
+#else
+	#define OFBC_THERMAL_SIMD 0
+#endif
+
+const size_t OFBC_THERMAL_PIXEL_OFFSET = 5;                        // Pixels follow a uint8 sensor ID and uint32 millis.
+const size_t OFBC_THERMAL_BATCH = 64;                              // Frames gathered per decode call by omnitrak_read_thermal_frames().
+
+
+//How stored pixels map onto output frames.
+enum OFBC_Thermal_Orientation : uint8_t {
+	OFBC_THERMAL_AS_STORED,                                        // Row-major, as stored.
+	OFBC_THERMAL_FLIP_ROWS,                                        // Each row reversed.
+	OFBC_THERMAL_ROTATE_180,                                       // Row order and each row reversed.
+};
+
+//How pixel values are stored.
+enum OFBC_Thermal_Encoding : uint8_t {
+	OFBC_THERMAL_F32,                                              // float32, copied.
+	OFBC_THERMAL_I16_RAW,                                          // int16, converted as-is.
+	OFBC_THERMAL_I16_QUARTER_C,                                    // int16, 0.25 C units.
+	OFBC_THERMAL_U8_FP62_C,                                        // uint8 fixed-point 6.2 Celsius.
+	OFBC_THERMAL_U16_DECI_K,                                       // uint16 deciKelvin.
+	OFBC_THERMAL_I12_DECI_C,                                       // Packed int12 deciCelsius, 2 pixels per 3 bytes.
+};
+
+struct OFBC_Thermal_Format {
+	uint16_t code;
+	OFBC_Thermal_Encoding encoding;
+	OFBC_Thermal_Orientation orientation;
+	uint8_t width;                                                 // A multiple of 8, for the vectorized decoders.
+	uint8_t height;
+};
+
+constexpr OFBC_Thermal_Format OFBC_THERMAL_FORMATS[] = {
+	{OFBC_AMG8833_PIXELS_FL,			OFBC_THERMAL_F32,				OFBC_THERMAL_ROTATE_180,	8,	8},
+	{OFBC_AMG8833_PIXELS_INT,			OFBC_THERMAL_I16_QUARTER_C,		OFBC_THERMAL_ROTATE_180,	8,	8},
+	{OFBC_HTPA32X32_PIXELS_FP62,		OFBC_THERMAL_U8_FP62_C,			OFBC_THERMAL_AS_STORED,		32,	32},
+	{OFBC_HTPA32X32_PIXELS_INT_K,		OFBC_THERMAL_U16_DECI_K,		OFBC_THERMAL_AS_STORED,		32,	32},
+	{OFBC_HTPA32X32_PIXELS_INT12_C,		OFBC_THERMAL_I12_DECI_C,		OFBC_THERMAL_AS_STORED,		32,	32},
+	{OFBC_MLX90640_PIXELS_TO,			OFBC_THERMAL_F32,				OFBC_THERMAL_FLIP_ROWS,		32,	24},
+	{OFBC_MLX90640_PIXELS_IM,			OFBC_THERMAL_F32,				OFBC_THERMAL_FLIP_ROWS,		32,	24},
+	{OFBC_MLX90640_PIXELS_INT,			OFBC_THERMAL_I16_RAW,			OFBC_THERMAL_FLIP_ROWS,		32,	24},
+};
+
+inline const OFBC_Thermal_Format *ofbc_find_thermal_format(uint16_t code)
+{
+	for (const OFBC_Thermal_Format &f : OFBC_THERMAL_FORMATS) {
+		if (f.code == code) {
+			return &f;
+		}
+	}
+	return nullptr;
+}
+
+//Pixels per decoded frame for a thermal block code, or 0 if the code isn't a thermal frame.
+inline size_t ofbc_thermal_pixels(uint16_t code)
+{
+	const OFBC_Thermal_Format *f = ofbc_find_thermal_format(code);
+	return f ? (size_t) f->width * f->height : 0;
+}
+
+
+//Output index for stored pixel "i".
+inline size_t ofbc_thermal_dest(const OFBC_Thermal_Format &f, size_t i)
+{
+	size_t w = f.width, n = w * f.height;
+	switch (f.orientation) {
+		case OFBC_THERMAL_FLIP_ROWS:	return i - i % w + (w - 1 - i % w);
+		case OFBC_THERMAL_ROTATE_180:	return n - 1 - i;
+		default:						return i;
+	}
+}
+
+//Celsius value of stored pixel "i" (scalar reference).
+inline float ofbc_thermal_pixel(OFBC_Thermal_Encoding encoding, const uint8_t *px, size_t i)
+{
+	switch (encoding) {
+		case OFBC_THERMAL_F32: {
+			float v;
+			memcpy(&v, px + 4 * i, 4);
+			return v;
+		}
+		case OFBC_THERMAL_I16_RAW:
+		case OFBC_THERMAL_I16_QUARTER_C: {
+			int16_t v;
+			memcpy(&v, px + 2 * i, 2);
+			return encoding == OFBC_THERMAL_I16_RAW ? (float) v : (float) v * 0.25f;
+		}
+		case OFBC_THERMAL_U8_FP62_C:
+			return (float) px[i] * 0.25f;
+		case OFBC_THERMAL_U16_DECI_K: {
+			uint16_t v;
+			memcpy(&v, px + 2 * i, 2);
+			return (float) v * 0.1f - 273.15f;
+		}
+		case OFBC_THERMAL_I12_DECI_C: {
+			const uint8_t *b = px + 3 * (i / 2);
+			uint16_t v = (i & 1) ? (uint16_t) ((b[1] >> 4) | (b[2] << 4)) : (uint16_t) (b[0] | ((b[1] & 0x0F) << 8));
+			int16_t s = (int16_t) (uint16_t) (v << 4);             // Sign-extend from 12 bits.
+			return (float) (s >> 4) * 0.1f;
+		}
+	}
+	return 0;
+}
+
+//Decodes one frame's pixels (scalar reference).
+inline void ofbc_decode_thermal_frame_scalar(const OFBC_Thermal_Format &f, const uint8_t *px, float *out)
+{
+	size_t n = (size_t) f.width * f.height;
+	for (size_t i = 0; i < n; i++) {
+		out[ofbc_thermal_dest(f, i)] = ofbc_thermal_pixel(f.encoding, px, i);
+	}
+}
+
+
+#if OFBC_THERMAL_SIMD
+
+//Eight float lanes: one AVX register, or two SSE registers.
+#if OFBC_THERMAL_SIMD == 2
+
+typedef __m256 ofbc_f32x8;
+
+inline ofbc_f32x8 ofbc_f32x8_load(const uint8_t *p) { return _mm256_loadu_ps((const float *) p); }
+inline ofbc_f32x8 ofbc_f32x8_from_i16(__m128i v) { return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)); }
+inline ofbc_f32x8 ofbc_f32x8_from_u16(__m128i v) { return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v)); }
+inline ofbc_f32x8 ofbc_f32x8_from_u8(__m128i v) { return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)); }
+inline ofbc_f32x8 ofbc_f32x8_scale(ofbc_f32x8 v, float m) { return _mm256_mul_ps(v, _mm256_set1_ps(m)); }
+inline ofbc_f32x8 ofbc_f32x8_offset(ofbc_f32x8 v, float a) { return _mm256_add_ps(v, _mm256_set1_ps(a)); }
+inline void ofbc_f32x8_store(float *p, ofbc_f32x8 v) { _mm256_storeu_ps(p, v); }
+inline void ofbc_f32x8_store_reversed(float *p, ofbc_f32x8 v)
+{
+	_mm256_storeu_ps(p, _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)));
+}
+
+#else
+
+struct ofbc_f32x8 {
+	__m128 lo;
+	__m128 hi;
+};
+
+inline ofbc_f32x8 ofbc_f32x8_load(const uint8_t *p)
+{
+	return {_mm_loadu_ps((const float *) p), _mm_loadu_ps((const float *) p + 4)};
+}
+inline ofbc_f32x8 ofbc_f32x8_from_i16(__m128i v)
+{
+	return {_mm_cvtepi32_ps(_mm_cvtepi16_epi32(v)), _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(v, 8)))};
+}
+inline ofbc_f32x8 ofbc_f32x8_from_u16(__m128i v)
+{
+	return {_mm_cvtepi32_ps(_mm_cvtepu16_epi32(v)), _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)))};
+}
+inline ofbc_f32x8 ofbc_f32x8_from_u8(__m128i v)
+{
+	return {_mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)), _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 4)))};
+}
+inline ofbc_f32x8 ofbc_f32x8_scale(ofbc_f32x8 v, float m)
+{
+	__m128 s = _mm_set1_ps(m);
+	return {_mm_mul_ps(v.lo, s), _mm_mul_ps(v.hi, s)};
+}
+inline ofbc_f32x8 ofbc_f32x8_offset(ofbc_f32x8 v, float a)
+{
+	__m128 s = _mm_set1_ps(a);
+	return {_mm_add_ps(v.lo, s), _mm_add_ps(v.hi, s)};
+}
+inline void ofbc_f32x8_store(float *p, ofbc_f32x8 v)
+{
+	_mm_storeu_ps(p, v.lo);
+	_mm_storeu_ps(p + 4, v.hi);
+}
+inline void ofbc_f32x8_store_reversed(float *p, ofbc_f32x8 v)
+{
+	_mm_storeu_ps(p, _mm_shuffle_ps(v.hi, v.hi, 0x1B));
+	_mm_storeu_ps(p + 4, _mm_shuffle_ps(v.lo, v.lo, 0x1B));
+}
+
+#endif
+
+//Converts stored pixels i..i+7 to Celsius.
+template <OFBC_Thermal_Encoding E> inline ofbc_f32x8 ofbc_thermal_load8(const uint8_t *px, size_t i)
+{
+	if constexpr (E == OFBC_THERMAL_F32) {
+		return ofbc_f32x8_load(px + 4 * i);
+	}
+	else if constexpr (E == OFBC_THERMAL_I16_RAW) {
+		return ofbc_f32x8_from_i16(_mm_loadu_si128((const __m128i *) (px + 2 * i)));
+	}
+	else if constexpr (E == OFBC_THERMAL_I16_QUARTER_C) {
+		return ofbc_f32x8_scale(ofbc_f32x8_from_i16(_mm_loadu_si128((const __m128i *) (px + 2 * i))), 0.25f);
+	}
+	else if constexpr (E == OFBC_THERMAL_U8_FP62_C) {
+		return ofbc_f32x8_scale(ofbc_f32x8_from_u8(_mm_loadl_epi64((const __m128i *) (px + i))), 0.25f);
+	}
+	else if constexpr (E == OFBC_THERMAL_U16_DECI_K) {
+		ofbc_f32x8 v = ofbc_f32x8_from_u16(_mm_loadu_si128((const __m128i *) (px + 2 * i)));
+		return ofbc_f32x8_offset(ofbc_f32x8_scale(v, 0.1f), -273.15f);
+	}
+	else {
+		const uint8_t *b = px + 3 * (i / 2);                      // 8 pixels are 12 bytes; load exactly those.
+		int32_t tail;
+		memcpy(&tail, b + 8, 4);
+		__m128i raw = _mm_insert_epi32(_mm_loadl_epi64((const __m128i *) b), tail, 2);
+		__m128i w = _mm_shuffle_epi8(raw, _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11));
+		__m128i t = _mm_blend_epi16(_mm_slli_epi16(w, 4), w, 0xAA);  // Even pixels sit in the low 12 bits; odd pixels in the high 12.
+		return ofbc_f32x8_scale(ofbc_f32x8_from_i16(_mm_srai_epi16(t, 4)), 0.1f);
+	}
+}
+
+template <OFBC_Thermal_Encoding E> inline void ofbc_decode_thermal_frame_simd(const OFBC_Thermal_Format &f, const uint8_t *px, float *out)
+{
+	size_t w = f.width, n = w * f.height;
+	for (size_t i = 0; i < n; i += 8) {
+		ofbc_f32x8 v = ofbc_thermal_load8<E>(px, i);
+		switch (f.orientation) {
+			case OFBC_THERMAL_AS_STORED:	ofbc_f32x8_store(out + i, v); break;
+			case OFBC_THERMAL_FLIP_ROWS:	ofbc_f32x8_store_reversed(out + i - i % w + (w - 8 - i % w), v); break;
+			case OFBC_THERMAL_ROTATE_180:	ofbc_f32x8_store_reversed(out + n - 8 - i, v); break;
+		}
+	}
+}
+
+template <OFBC_Thermal_Encoding E> inline void ofbc_decode_thermal_batch_simd(const OFBC_Thermal_Format &f,
+	const uint8_t *const *payloads, size_t num_frames, float *frames)
+{
+	size_t n = (size_t) f.width * f.height;
+	for (size_t k = 0; k < num_frames; k++) {
+		ofbc_decode_thermal_frame_simd<E>(f, payloads[k] + OFBC_THERMAL_PIXEL_OFFSET, frames + k * n);
+	}
+}
+
+#endif                                                             // #if OFBC_THERMAL_SIMD
+
+
+//Copies each frame's sensor ID and millisecond timestamp, if requested.
+inline void ofbc_thermal_frame_info(const uint8_t *const *payloads, size_t num_frames, uint32_t *millis, uint8_t *ids)
+{
+	for (size_t k = 0; k < num_frames; k++) {
+		if (ids) {
+			ids[k] = payloads[k][0];
+		}
+		if (millis) {
+			memcpy(&millis[k], payloads[k] + 1, 4);
+		}
+	}
+}
+
+//Decodes a batch of frames with the scalar reference decoder. "payloads" point at
+//block payloads (just past the block code). Returns the number of frames decoded,
+//or 0 if "code" isn't a thermal frame block.
+inline size_t ofbc_decode_thermal_frames_scalar(uint16_t code, const uint8_t *const *payloads, size_t num_frames,
+	float *frames, uint32_t *millis = nullptr, uint8_t *ids = nullptr)
+{
+	const OFBC_Thermal_Format *f = ofbc_find_thermal_format(code);
+	if (!f) {
+		return 0;
+	}
+	size_t n = (size_t) f->width * f->height;
+	for (size_t k = 0; k < num_frames; k++) {
+		ofbc_decode_thermal_frame_scalar(*f, payloads[k] + OFBC_THERMAL_PIXEL_OFFSET, frames + k * n);
+	}
+	ofbc_thermal_frame_info(payloads, num_frames, millis, ids);
+	return num_frames;
+}
+
+//Decodes a batch of frames with the fastest available decoder. See ofbc_decode_thermal_frames_scalar().
+inline size_t ofbc_decode_thermal_frames(uint16_t code, const uint8_t *const *payloads, size_t num_frames,
+	float *frames, uint32_t *millis = nullptr, uint8_t *ids = nullptr)
+{
+#if OFBC_THERMAL_SIMD
+	const OFBC_Thermal_Format *f = ofbc_find_thermal_format(code);
+	if (!f) {
+		return 0;
+	}
+	switch (f->encoding) {
+		case OFBC_THERMAL_F32:				ofbc_decode_thermal_batch_simd<OFBC_THERMAL_F32>(*f, payloads, num_frames, frames); break;
+		case OFBC_THERMAL_I16_RAW:			ofbc_decode_thermal_batch_simd<OFBC_THERMAL_I16_RAW>(*f, payloads, num_frames, frames); break;
+		case OFBC_THERMAL_I16_QUARTER_C:	ofbc_decode_thermal_batch_simd<OFBC_THERMAL_I16_QUARTER_C>(*f, payloads, num_frames, frames); break;
+		case OFBC_THERMAL_U8_FP62_C:		ofbc_decode_thermal_batch_simd<OFBC_THERMAL_U8_FP62_C>(*f, payloads, num_frames, frames); break;
+		case OFBC_THERMAL_U16_DECI_K:		ofbc_decode_thermal_batch_simd<OFBC_THERMAL_U16_DECI_K>(*f, payloads, num_frames, frames); break;
+		case OFBC_THERMAL_I12_DECI_C:		ofbc_decode_thermal_batch_simd<OFBC_THERMAL_I12_DECI_C>(*f, payloads, num_frames, frames); break;
+	}
+	ofbc_thermal_frame_info(payloads, num_frames, millis, ids);
+	return num_frames;
+#else
+	return ofbc_decode_thermal_frames_scalar(code, payloads, num_frames, frames, millis, ids);
+#endif
+}
+
+
+//Reads up to "max_frames" frames of one thermal block code from a reader, skipping other
+//blocks, and decodes them into "frames" (max_frames * ofbc_thermal_pixels(code) floats).
+//Returns the number of frames read; 0 once the reader is done.
+inline size_t omnitrak_read_thermal_frames(OmniTrak_Block_Reader &reader, uint16_t code, float *frames,
+	size_t max_frames, uint32_t *millis = nullptr, uint8_t *ids = nullptr)
+{
+	size_t pixels = ofbc_thermal_pixels(code);
+	if (pixels == 0) {
+		return 0;
+	}
+	const uint8_t *batch[OFBC_THERMAL_BATCH];
+	size_t total = 0, queued = 0;
+	OmniTrak_Block_View blk;
+	auto flush = [&]() {
+		ofbc_decode_thermal_frames(code, batch, queued, frames + total * pixels,
+			millis ? millis + total : nullptr, ids ? ids + total : nullptr);
+		total += queued;
+		queued = 0;
+	};
+	while (total + queued < max_frames && reader.next(blk)) {
+		if (blk.code == code) {
+			batch[queued++] = blk.payload;
+			if (queued == OFBC_THERMAL_BATCH) {
+				flush();
+			}
+		}
+	}
+	flush();
+	return total;
+}
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_THERMAL_H_
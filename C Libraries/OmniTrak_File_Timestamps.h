@@ -0,0 +1,239 @@
+/*
+	OmniTrak_File_Timestamps.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Block Timestamp Table
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Gives the location and type of the primary timestamp inside each
+	timestamped block payload: a device millis() or micros() reading, or a
+	MATLAB serial date number. CLOCK_SYNC and TTL_PULSETRAIN carry optional,
+	bitmasked timestamps and are handled by ofbc_block_timestamp() directly.
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OFBC_TIMESTAMPS_H_
+#define _VULINTUS_OFBC_TIMESTAMPS_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "OmniTrak_File_Block_Codes.h"
+
+enum OFBC_Time_Type : uint8_t {
+	OFBC_TIME_NONE,                                                // No timestamp.
+	OFBC_TIME_MILLIS,                                              // uint32 device millisecond clock.
+	OFBC_TIME_MICROS,                                              // uint32 device microsecond clock.
+	OFBC_TIME_MICROS_FL,                                           // float32 device microsecond clock.
+	OFBC_TIME_DATENUM,                                             // float64 MATLAB serial date number (days).
+};
+
+struct OFBC_Timestamp_Field {
+	uint16_t code;                                                 // OFBC block code.
+	OFBC_Time_Type type;                                           // Timestamp type.
+	uint8_t offset;                                                // Payload offset of the timestamp.
+};
+
+struct OFBC_Timestamp {
+	OFBC_Time_Type type;
+	double value;                                                  // Clock ticks for MILLIS/MICROS, days for DATENUM.
+};
+
+
+//Timestamp locations, in block code order.
+constexpr OFBC_Timestamp_Field OFBC_TIMESTAMP_FIELDS[] = {
+	{OFBC_MS_FILE_START,					OFBC_TIME_MILLIS,	0},
+	{OFBC_MS_FILE_STOP,						OFBC_TIME_MILLIS,	0},
+	{OFBC_CLOCK_FILE_START,					OFBC_TIME_DATENUM,	0},
+	{OFBC_CLOCK_FILE_STOP,					OFBC_TIME_DATENUM,	0},
+	{OFBC_NTP_SYNC,							OFBC_TIME_MILLIS,	4},
+	{OFBC_RTC_STRING,						OFBC_TIME_MILLIS,	0},
+	{OFBC_RTC_VALUES,						OFBC_TIME_MILLIS,	0},
+	{OFBC_RENAMED_FILE,						OFBC_TIME_DATENUM,	0},
+	{OFBC_DOWNLOAD_TIME,					OFBC_TIME_DATENUM,	0},
+	{OFBC_USER_TIME,						OFBC_TIME_MILLIS,	0},
+	{OFBC_BATTERY_SOC,						OFBC_TIME_MILLIS,	0},
+	{OFBC_BATTERY_VOLTS,					OFBC_TIME_MILLIS,	0},
+	{OFBC_BATTERY_CURRENT,					OFBC_TIME_MILLIS,	0},
+	{OFBC_BATTERY_FULL,						OFBC_TIME_MILLIS,	0},
+	{OFBC_BATTERY_REMAIN,					OFBC_TIME_MILLIS,	0},
+	{OFBC_BATTERY_POWER,					OFBC_TIME_MILLIS,	0},
+	{OFBC_BATTERY_SOH,						OFBC_TIME_MILLIS,	0},
+	{OFBC_BATTERY_STATUS,					OFBC_TIME_MILLIS,	0},
+	{OFBC_AMBULATION_XY_THETA,				OFBC_TIME_MICROS,	1},
+	{OFBC_AMBULATION_XY_THETA_PACKED,		OFBC_TIME_MICROS,	12},
+	{OFBC_AMG8833_THERM_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_AMG8833_THERM_INT,				OFBC_TIME_MILLIS,	1},
+	{OFBC_AMG8833_PIXELS_FL,				OFBC_TIME_MILLIS,	1},
+	{OFBC_AMG8833_PIXELS_INT,				OFBC_TIME_MILLIS,	1},
+	{OFBC_HTPA32X32_PIXELS_FP62,			OFBC_TIME_MILLIS,	1},
+	{OFBC_HTPA32X32_PIXELS_INT_K,			OFBC_TIME_MILLIS,	1},
+	{OFBC_HTPA32X32_AMBIENT_TEMP,			OFBC_TIME_MILLIS,	1},
+	{OFBC_HTPA32X32_PIXELS_INT12_C,			OFBC_TIME_MILLIS,	1},
+	{OFBC_BH1749_RGB,						OFBC_TIME_MILLIS,	1},
+	{OFBC_BME280_TEMP_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_BMP280_TEMP_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_BME680_TEMP_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_BME280_PRES_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_BMP280_PRES_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_BME680_PRES_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_BME280_HUM_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_BME680_HUM_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_BME680_GAS_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_VL53L0X_DIST,						OFBC_TIME_MILLIS,	1},
+	{OFBC_VL53L0X_FAIL,						OFBC_TIME_MILLIS,	1},
+	{OFBC_SGP30_EC02,						OFBC_TIME_MILLIS,	1},
+	{OFBC_SGP30_TVOC,						OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_EEPROM_DUMP,				OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_ADC_RES,					OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_REFRESH_RATE,			OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_I2C_CLOCKRATE,			OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_PIXELS_TO,				OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_PIXELS_IM,				OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_PIXELS_INT,				OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_I2C_TIME,				OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_CALC_TIME,				OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_IM_WRITE_TIME,			OFBC_TIME_MILLIS,	1},
+	{OFBC_MLX90640_INT_WRITE_TIME,			OFBC_TIME_MILLIS,	1},
+	{OFBC_ALSPT19_LIGHT,					OFBC_TIME_MILLIS,	1},
+	{OFBC_ALSPT19_LIGHT_PACKED,				OFBC_TIME_MILLIS,	12},
+	{OFBC_ZMOD4410_ERROR,					OFBC_TIME_MILLIS,	1},
+	{OFBC_ZMOD4410_READING_FL,				OFBC_TIME_MILLIS,	1},
+	{OFBC_ZMOD4410_READING_INT,				OFBC_TIME_MILLIS,	1},
+	{OFBC_LSM303_ACC_SETTINGS,				OFBC_TIME_MILLIS,	1},
+	{OFBC_LSM303_MAG_SETTINGS,				OFBC_TIME_MILLIS,	1},
+	{OFBC_LSM303_ACC_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_LSM303_MAG_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_LSM303_TEMP_FL,					OFBC_TIME_MILLIS,	1},
+	{OFBC_SPECTRO_TRACE,					OFBC_TIME_DATENUM,	4},
+	{OFBC_PELLET_DISPENSE,					OFBC_TIME_MILLIS,	0},
+	{OFBC_PELLET_FAILURE,					OFBC_TIME_MILLIS,	1},
+	{OFBC_HARD_PAUSE_START,					OFBC_TIME_MILLIS,	0},
+	{OFBC_HARD_PAUSE_STOP,					OFBC_TIME_MILLIS,	0},
+	{OFBC_SOFT_PAUSE_START,					OFBC_TIME_MILLIS,	0},
+	{OFBC_SOFT_PAUSE_STOP,					OFBC_TIME_MILLIS,	0},
+	{OFBC_TRIAL_START_SERIAL_DATE,			OFBC_TIME_DATENUM,	0},
+	{OFBC_POSITION_MOVE_X,					OFBC_TIME_MILLIS,	1},
+	{OFBC_POSITION_MOVE_XY,					OFBC_TIME_MILLIS,	0},
+	{OFBC_POSITION_MOVE_XYZ,				OFBC_TIME_MILLIS,	0},
+	{OFBC_CALIBRATION_BASELINE_ADJUST,		OFBC_TIME_MILLIS,	0},
+	{OFBC_CALIBRATION_SLOPE_ADJUST,			OFBC_TIME_MILLIS,	0},
+	{OFBC_CALIBRATION_DATE,					OFBC_TIME_DATENUM,	1},
+	{OFBC_REMOTE_MANUAL_FEED,				OFBC_TIME_MILLIS,	1},
+	{OFBC_HWUI_MANUAL_FEED,					OFBC_TIME_DATENUM,	1},
+	{OFBC_FW_RANDOM_FEED,					OFBC_TIME_MILLIS,	1},
+	{OFBC_SWUI_MANUAL_FEED_DEPRECATED,		OFBC_TIME_DATENUM,	0},
+	{OFBC_FW_OPERANT_FEED,					OFBC_TIME_MILLIS,	1},
+	{OFBC_SWUI_MANUAL_FEED,					OFBC_TIME_DATENUM,	1},
+	{OFBC_SW_RANDOM_FEED,					OFBC_TIME_DATENUM,	1},
+	{OFBC_SW_OPERANT_FEED,					OFBC_TIME_DATENUM,	1},
+	{OFBC_MOTOTRAK_V3P0_OUTCOME,			OFBC_TIME_MILLIS,	2},
+	{OFBC_POKE_BITMASK,						OFBC_TIME_DATENUM,	1},
+	{OFBC_POKE_BITMASK_PACKED,				OFBC_TIME_DATENUM,	4},
+	{OFBC_CAPSENSE_BITMASK,					OFBC_TIME_DATENUM,	1},
+	{OFBC_CAPSENSE_VALUE,					OFBC_TIME_DATENUM,	1},
+	{OFBC_CAPSENSE_VALUE_PACKED,			OFBC_TIME_DATENUM,	4},
+	{OFBC_VIBRATION_TASK_TRIAL_OUTCOME,		OFBC_TIME_DATENUM,	2},
+	{OFBC_VIBROTACTILE_DETECTION_TASK_TRIAL,	OFBC_TIME_DATENUM,	4},
+	{OFBC_LED_DETECTION_TASK_TRIAL_OUTCOME,	OFBC_TIME_DATENUM,	2},
+	{OFBC_STTC_2AFC_TRIAL_OUTCOME,			OFBC_TIME_DATENUM,	2},
+	{OFBC_STAP_2AFC_TRIAL_OUTCOME,			OFBC_TIME_DATENUM,	2},
+	{OFBC_FR_TASK_TRIAL,					OFBC_TIME_DATENUM,	4},
+};
+
+const size_t OFBC_NUM_TIMESTAMP_FIELDS = sizeof(OFBC_TIMESTAMP_FIELDS) / sizeof(OFBC_TIMESTAMP_FIELDS[0]);
+
+
+//Returns the fixed timestamp location for a block code, or nullptr if it has none.
+constexpr const OFBC_Timestamp_Field *ofbc_find_timestamp_field(uint16_t code)
+{
+	size_t lo = 0, hi = OFBC_NUM_TIMESTAMP_FIELDS;
+	while (lo < hi) {                                              // Binary search; the table is in code order.
+		size_t mid = (lo + hi) / 2;
+		if (OFBC_TIMESTAMP_FIELDS[mid].code < code) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	return (lo < OFBC_NUM_TIMESTAMP_FIELDS && OFBC_TIMESTAMP_FIELDS[lo].code == code) ? &OFBC_TIMESTAMP_FIELDS[lo] : nullptr;
+}
+
+constexpr bool ofbc_timestamp_table_is_sorted()
+{
+	for (size_t i = 1; i < OFBC_NUM_TIMESTAMP_FIELDS; i++) {
+		if (OFBC_TIMESTAMP_FIELDS[i - 1].code >= OFBC_TIMESTAMP_FIELDS[i].code) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(ofbc_timestamp_table_is_sorted(), "OFBC_TIMESTAMP_FIELDS must be in ascending block code order.");
+
+
+//Reads a timestamp of the given type at a payload offset, if the payload is long enough.
+inline OFBC_Timestamp ofbc_read_timestamp(OFBC_Time_Type type, const uint8_t *payload, uint64_t payload_size, uint64_t offset)
+{
+	OFBC_Timestamp ts = {OFBC_TIME_NONE, 0};
+	switch (type) {
+		case OFBC_TIME_MILLIS:
+		case OFBC_TIME_MICROS:
+			if (offset + 4 <= payload_size) {
+				uint32_t v;
+				memcpy(&v, payload + offset, 4);
+				ts = {type, (double) v};
+			}
+			break;
+		case OFBC_TIME_MICROS_FL:
+			if (offset + 4 <= payload_size) {
+				float v;
+				memcpy(&v, payload + offset, 4);
+				ts = {type, (double) v};
+			}
+			break;
+		case OFBC_TIME_DATENUM:
+			if (offset + 8 <= payload_size) {
+				double v;
+				memcpy(&v, payload + offset, 8);
+				ts = {type, v};
+			}
+			break;
+		case OFBC_TIME_NONE:
+			break;
+	}
+	return ts;
+}
+
+//Returns the primary timestamp of a complete block payload, or OFBC_TIME_NONE.
+inline OFBC_Timestamp ofbc_block_timestamp(uint16_t code, const uint8_t *payload, uint64_t payload_size)
+{
+	if (code == OFBC_CLOCK_SYNC && payload_size >= 3) {            // Earliest of the bitmasked date/millis/micros fields.
+		uint8_t mask = payload[2];
+		if (mask & 0x01) return ofbc_read_timestamp(OFBC_TIME_DATENUM, payload, payload_size, 3);
+		if (mask & 0x02) return ofbc_read_timestamp(OFBC_TIME_MILLIS, payload, payload_size, 3);
+		if (mask & 0x04) return ofbc_read_timestamp(OFBC_TIME_MICROS, payload, payload_size, 3);
+		return {OFBC_TIME_NONE, 0};
+	}
+	if (code == OFBC_TTL_PULSETRAIN && payload_size >= 1) {
+		if (payload[0] == 1) return ofbc_read_timestamp(OFBC_TIME_DATENUM, payload, payload_size, 1);
+		if (payload[0] == 2 && payload_size >= 4) {
+			uint8_t mask = payload[3];
+			if (mask & 0x01) return ofbc_read_timestamp(OFBC_TIME_DATENUM, payload, payload_size, 4);
+			if (mask & 0x02) return ofbc_read_timestamp(OFBC_TIME_MILLIS, payload, payload_size, 4);
+		}
+		return {OFBC_TIME_NONE, 0};
+	}
+	const OFBC_Timestamp_Field *field = ofbc_find_timestamp_field(code);
+	if (!field) {
+		return {OFBC_TIME_NONE, 0};
+	}
+	return ofbc_read_timestamp(field->type, payload, payload_size, field->offset);
+}
+
+#endif                                                             // #ifndef _VULINTUS_OFBC_TIMESTAMPS_H_
@@ -0,0 +1,335 @@
+/*
+	OmniTrak_File_Writer.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Buffered Device Writer
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	An *.OmniTrak writer for device firmware (SAMD, ESP8266) that never
+	allocates and makes no virtual calls. Blocks are copied into one of two
+	statically sized, 512-byte-sector-multiple buffers. When a buffer fills,
+	the writer switches to the other one and leaves the full buffer pending,
+	to be written by service() from the main loop, so taking a sensor reading
+	never waits on the SD card unless both buffers are full. Every device
+	write starts on a sector boundary.
+
+	The storage device is a template parameter with two member functions:
+		bool write(uint64_t offset, const uint8_t *data, uint32_t n);   // offset is always sector-aligned
+		bool sync();
+	OmniTrak_Stream_Device adapts an Arduino SD/SdFat File, and, on
+	Linux/macOS, OmniTrak_File_Block_Device writes to a regular file so the
+	writer can be tested on a host.
+
+	A block that won't fit in what's left of the current buffer is preceded
+	by an INCOMPLETE_BLOCK marker giving its code and its start and end byte
+	offsets, because that block will be split across two device writes.
+	Only blocks that straddle a buffer boundary are marked, so larger
+	buffers mean fewer markers; with the default 2-sector buffers, every
+	block over 1 KB is marked. The offsets are the low 32 bits and wrap
+	past 4 GiB, which is harmless because readers only match a marker
+	against the block right after it. If power is lost between the two
+	writes, the file ends inside the block the marker announced (or inside
+	the marker itself, when it's the marker that straddles the buffer
+	boundary), and OmniTrak_Block_Reader stops with
+	OMNITRAK_READ_MARKED_INCOMPLETE instead of reporting a corrupt file.
+	Buffers that are written by sync() always end on a block boundary.
+
+		OmniTrak_File_Block_Device sd;                             // Or OmniTrak_Stream_Device<File> on a device.
+		sd.open("session.OmniTrak");
+		OmniTrak_File_Writer<OmniTrak_File_Block_Device> writer(sd);
+		writer.begin();
+		writer.write_string_block<OFBC_SUBJECT_NAME>("Rat 7");
+		writer.write_block<OFBC_AMG8833_PIXELS_FL>(id, millis(), pixels);  // uint8_t, uint32_t, float[64]
+		...
+		writer.service();                                          // In loop().
+		writer.close();
+
+	Block fields are written in native byte order, which is little-endian on
+	every supported target.
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_FILE_WRITER_H_
+#define _VULINTUS_OMNITRAK_FILE_WRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "OmniTrak_File_Block_Sizes.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+const uint32_t OFBC_SECTOR_SIZE = 512;
+const uint32_t OFBC_INCOMPLETE_MARKER_SIZE = 2 + 10;               // INCOMPLETE_BLOCK code and payload.
+
+
+//Sums the sizes of a block's fields at compile time, allowing only numbers and arrays of numbers.
+template <typename... Fields> constexpr uint32_t ofbc_fields_size()
+{
+	static_assert((std::is_arithmetic<typename std::remove_all_extents<Fields>::type>::value && ...),
+		"block fields must be numbers or arrays of numbers");
+	return (0 + ... + (uint32_t) sizeof(Fields));
+}
+
+
+template <typename Device, uint16_t SECTORS_PER_BUFFER = 2>
+class OmniTrak_File_Writer {
+
+	public:
+
+		static const uint32_t BUFFER_SIZE = OFBC_SECTOR_SIZE * SECTORS_PER_BUFFER;
+
+		explicit OmniTrak_File_Writer(Device &device) : _device(device) {}
+
+		//Writes the file header (0xABCD verify code and file format version).
+		bool begin(uint16_t file_version = 1)
+		{
+			_active = 0;
+			_fill = 0;
+			_pending = false;
+			_offset[0] = 0;
+			_block_left = 0;
+			_ok = true;
+			put(OFBC_OMNITRAK_FILE_VERIFY);
+			put(OFBC_FILE_VERSION);
+			put(file_version);
+			return _ok;
+		}
+
+		//Writes a fixed-size block from its fields, in order. The fields' sizes must add up
+		//to the block's payload size, which is checked at compile time.
+		template <uint16_t CODE, typename... Fields> bool write_block(const Fields &... fields)
+		{
+			constexpr uint32_t size = ofbc_fields_size<Fields...>();
+			static_assert(ofbc_fixed_payload_size(CODE) == (int32_t) size,
+				"write_block<CODE>(): the fields don't match the block's payload size");
+			if (!begin_block(CODE, size)) {
+				return false;
+			}
+			(put(fields), ...);
+			return _ok;
+		}
+
+		//Writes a block that is just a length-prefixed string (SUBJECT_NAME, SYSTEM_NAME, ...).
+		template <uint16_t CODE> bool write_string_block(const char *str, size_t len)
+		{
+			constexpr const OFBC_Block_Layout *layout = ofbc_find_layout(CODE);
+			static_assert(layout && layout->rule == OFBC_RULE_COUNTED && layout->fixed == layout->count_bytes
+				&& layout->elem_size == 1 && layout->version_bytes == 0,
+				"write_string_block<CODE>(): the block isn't a plain length-prefixed string");
+			size_t max_len = (layout->count_bytes == 1) ? 0xFF : ((layout->count_bytes == 2) ? 0xFFFF : 0xFFFFFFFF);
+			if (len > max_len) {
+				len = max_len;
+			}
+			if (!begin_block(CODE, layout->count_bytes + (uint32_t) len)) {
+				return false;
+			}
+			uint32_t n = (uint32_t) len;
+			put_bytes(&n, layout->count_bytes);
+			put_bytes(str, (uint32_t) len);
+			return _ok;
+		}
+
+		template <uint16_t CODE> bool write_string_block(const char *str)
+		{
+			return write_string_block<CODE>(str, strlen(str));
+		}
+
+		//Starts a block whose payload is then added with put() and put_bytes(), for
+		//variable-size blocks without a typed writer. "payload_size" must be exact.
+		bool begin_block(uint16_t code, uint32_t payload_size)
+		{
+			if (_block_left != 0) {                                // The previous block was left short.
+				_ok = false;
+			}
+			if (!_ok) {
+				return false;
+			}
+			uint32_t total = 2 + payload_size;
+			if (_fill + total > BUFFER_SIZE && code != OFBC_INCOMPLETE_BLOCK) {
+				uint64_t start = position() + OFBC_INCOMPLETE_MARKER_SIZE;
+				put(OFBC_INCOMPLETE_BLOCK);
+				put(code);
+				put((uint32_t) start);
+				put((uint32_t) (start + total));
+			}
+			put(code);
+			_block_left = payload_size;
+			return _ok;
+		}
+
+		template <typename T> void put(const T &value)
+		{
+			put_bytes(&value, sizeof(T));
+		}
+
+		void put_bytes(const void *data, uint32_t n)
+		{
+			const uint8_t *p = (const uint8_t *) data;
+			_block_left = (n > _block_left) ? 0 : _block_left - n;
+			while (n > 0 && _ok) {
+				uint32_t chunk = BUFFER_SIZE - _fill;
+				if (chunk > n) {
+					chunk = n;
+				}
+				memcpy(_buffer[_active] + _fill, p, chunk);
+				_fill += chunk;
+				p += chunk;
+				n -= chunk;
+				if (_fill == BUFFER_SIZE) {
+					swap_buffers();
+				}
+			}
+		}
+
+		//Writes a full, pending buffer to the device, if there is one. Call this regularly
+		//from the main loop so the buffers never both fill.
+		bool service()
+		{
+			if (_pending) {
+				uint8_t other = _active ^ 1;
+				_ok = _device.write(_offset[other], _buffer[other], BUFFER_SIZE) && _ok;
+				_pending = false;
+			}
+			return _ok;
+		}
+
+		//Writes everything buffered, including the partly filled sectors of the current
+		//buffer, and syncs the device. Those sectors are rewritten once the buffer fills.
+		bool sync()
+		{
+			service();
+			if (_fill > 0 && _ok) {
+				_ok = _device.write(_offset[_active], _buffer[_active], _fill);
+			}
+			return _device.sync() && _ok;
+		}
+
+		bool close()
+		{
+			return sync();
+		}
+
+		uint64_t position() const { return _offset[_active] + _fill; }   // Bytes written so far, buffered or not.
+		uint32_t stalls() const { return _stalls; }                // Times a write waited for a full buffer to reach the device.
+		bool ok() const { return _ok; }                            // False after any device write failure.
+
+	private:
+
+		void swap_buffers()
+		{
+			if (_pending) {                                        // Both buffers full: the write has to wait.
+				_stalls++;
+				service();
+			}
+			_pending = true;
+			_offset[_active ^ 1] = _offset[_active] + BUFFER_SIZE;
+			_active ^= 1;
+			_fill = 0;
+		}
+
+		Device &_device;
+		uint8_t _buffer[2][BUFFER_SIZE];
+		uint64_t _offset[2] = {0, 0};                              // File offset of each buffer's first byte.
+		uint32_t _fill = 0;                                        // Bytes used in the active buffer.
+		uint32_t _block_left = 0;                                  // Payload bytes still owed to the current block.
+		uint32_t _stalls = 0;
+		uint8_t _active = 0;
+		bool _pending = false;                                     // The inactive buffer is full and not yet written.
+		bool _ok = true;
+};
+
+
+//Adapts an Arduino SD or SdFat File (anything with seek(), write(), and flush()) as a writer device.
+template <typename File>
+class OmniTrak_Stream_Device {
+
+	public:
+
+		explicit OmniTrak_Stream_Device(File &file) : _file(file) {}
+
+		bool write(uint64_t offset, const uint8_t *data, uint32_t n)
+		{
+			return _file.seek(offset) && _file.write(data, n) == n;
+		}
+
+		bool sync()
+		{
+			_file.flush();
+			return true;
+		}
+
+	private:
+
+		File &_file;
+};
+
+
+#if defined(__unix__) || defined(__APPLE__)
+
+//Writes to a regular file, for running and testing the writer on a host.
+class OmniTrak_File_Block_Device {
+
+	public:
+
+		OmniTrak_File_Block_Device() = default;
+		OmniTrak_File_Block_Device(const OmniTrak_File_Block_Device &) = delete;
+		OmniTrak_File_Block_Device &operator=(const OmniTrak_File_Block_Device &) = delete;
+
+		~OmniTrak_File_Block_Device()
+		{
+			close();
+		}
+
+		//Creates (or truncates) the file.
+		bool open(const char *path)
+		{
+			close();
+			_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			return _fd >= 0;
+		}
+
+		bool write(uint64_t offset, const uint8_t *data, uint32_t n)
+		{
+			while (n > 0) {
+				ssize_t written = pwrite(_fd, data, n, (off_t) offset);
+				if (written <= 0) {
+					return false;
+				}
+				data += written;
+				offset += (uint64_t) written;
+				n -= (uint32_t) written;
+			}
+			return true;
+		}
+
+		bool sync()
+		{
+			return _fd >= 0 && fsync(_fd) == 0;
+		}
+
+		void close()
+		{
+			if (_fd >= 0) {
+				::close(_fd);
+			}
+			_fd = -1;
+		}
+
+	private:
+
+		int _fd = -1;
+};
+
+#endif
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_FILE_WRITER_H_
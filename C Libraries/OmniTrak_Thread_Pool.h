@@ -0,0 +1,170 @@
+/*
+	OmniTrak_Thread_Pool.h
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Work-Stealing Thread Pool
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	A small fixed-size pool for fanning *.OmniTrak work (one file, or one
+	chunk of a file, per task) out across cores. Each worker owns a task
+	queue; it pops from the back of its own queue and, when that runs dry,
+	steals from the front of the others', so a few very large session files
+	don't leave the remaining cores idle.
+
+		OmniTrak_Thread_Pool pool;                                 // One worker per hardware thread.
+		for (const std::string &path : files) {
+			pool.submit([&, path]() { convert(path); });
+		}
+		pool.wait();
+
+	Requires C++17.
+*/
+
+#ifndef _VULINTUS_OMNITRAK_THREAD_POOL_H_
+#define _VULINTUS_OMNITRAK_THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class OmniTrak_Thread_Pool {
+
+	public:
+
+		//Starts "num_threads" workers (0 = one per hardware thread).
+		explicit OmniTrak_Thread_Pool(unsigned num_threads = 0)
+		{
+			if (num_threads == 0) {
+				num_threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			for (unsigned i = 0; i < num_threads; i++) {
+				_queues.emplace_back(new Queue);
+			}
+			for (unsigned i = 0; i < num_threads; i++) {
+				_workers.emplace_back([this, i]() { run(i); });
+			}
+		}
+
+		OmniTrak_Thread_Pool(const OmniTrak_Thread_Pool &) = delete;
+		OmniTrak_Thread_Pool &operator=(const OmniTrak_Thread_Pool &) = delete;
+
+		//Finishes all queued tasks, then stops the workers.
+		~OmniTrak_Thread_Pool()
+		{
+			wait();
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stopping = true;
+			}
+			_wake.notify_all();
+			for (std::thread &worker : _workers) {
+				worker.join();
+			}
+		}
+
+		//Queues a task, spreading submissions round-robin over the workers' queues.
+		void submit(std::function<void()> task)
+		{
+			size_t q = _next_queue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_pending++;
+			}
+			{
+				std::lock_guard<std::mutex> lock(_queues[q]->mutex);
+				_queues[q]->tasks.push_back(std::move(task));
+			}
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_queued++;
+			}
+			_wake.notify_one();
+		}
+
+		//Blocks until every submitted task has finished.
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_idle.wait(lock, [this]() { return _pending == 0; });
+		}
+
+		size_t size() const { return _workers.size(); }
+
+	private:
+
+		struct Queue {
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		//Pops from the back of the worker's own queue, else steals from the front of another's.
+		bool take(size_t self, std::function<void()> &task)
+		{
+			{
+				Queue &own = *_queues[self];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (!own.tasks.empty()) {
+					task = std::move(own.tasks.back());
+					own.tasks.pop_back();
+					return true;
+				}
+			}
+			for (size_t i = 1; i < _queues.size(); i++) {
+				Queue &victim = *_queues[(self + i) % _queues.size()];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (!victim.tasks.empty()) {
+					task = std::move(victim.tasks.front());
+					victim.tasks.pop_front();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void run(size_t self)
+		{
+			std::function<void()> task;
+			for (;;) {
+				if (take(self, task)) {
+					{
+						std::lock_guard<std::mutex> lock(_mutex);
+						_queued--;
+					}
+					task();
+					task = nullptr;
+					std::lock_guard<std::mutex> lock(_mutex);
+					if (--_pending == 0) {
+						_idle.notify_all();
+					}
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(_mutex);
+				_wake.wait(lock, [this]() { return _stopping || _queued > 0; });
+				if (_stopping && _queued <= 0) {
+					return;
+				}
+			}
+		}
+
+		std::vector<std::unique_ptr<Queue>> _queues;
+		std::vector<std::thread> _workers;
+		std::atomic<size_t> _next_queue {0};
+		std::mutex _mutex;                                         // Guards the counters and _stopping.
+		std::condition_variable _wake;
+		std::condition_variable _idle;
+		size_t _pending = 0;                                       // Submitted but not yet finished.
+		long _queued = 0;                                          // Submitted but not yet taken (may briefly go negative).
+		bool _stopping = false;
+};
+
+#endif                                                             // #ifndef _VULINTUS_OMNITRAK_THREAD_POOL_H_
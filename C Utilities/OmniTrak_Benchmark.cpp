@@ -0,0 +1,596 @@
+/*
+	OmniTrak_Benchmark.cpp
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Throughput Benchmark
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Measures the writer and the readers, per block family (see
+	OmniTrak_File_Synth.h), on a synthetic session generated in memory or on
+	a given *.OmniTrak file:
+
+		write <family>		OmniTrak_File_Writer, generating that family alone
+		decode <family>		decoding that family's blocks into values (thermal frames
+							through OmniTrak_File_Thermal.h), from a prebuilt offset list
+		walk				OmniTrak_Block_Reader over the whole file
+		scan				OmniTrak_Parallel_Parser over the whole file, on -j threads
+
+	Each row gives MB/s and blocks/s, heap allocations per pass, and, where
+	the kernel allows perf_event_open (see /proc/sys/kernel/perf_event_paranoid),
+	cycles per byte, instructions per cycle, and last-level cache misses per
+	MB, counted across all threads.
+
+	With --check, the decoded values are compared against a fixture
+	exported from OmniTrakFileRead.m for the same file by
+	MATLAB/OmniTrak_Export_Fixture.m: the count and sum of each numeric
+	field this harness also decodes must match.
+
+		OmniTrak_Generate --size 1G --seed 3 fixture.OmniTrak
+		(MATLAB) OmniTrak_Export_Fixture('fixture.OmniTrak')
+		OmniTrak_Benchmark --check fixture_fixture.csv fixture.OmniTrak
+
+	Build:
+		g++ -std=c++17 -O2 -march=native -pthread -I"../C Libraries" OmniTrak_Benchmark.cpp -o OmniTrak_Benchmark
+
+	Requires C++17.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <math.h>
+#include <memory>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+	#include <linux/perf_event.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+#include "OmniTrak_File_Parallel.h"
+#include "OmniTrak_File_Synth.h"
+#include "OmniTrak_File_Thermal.h"
+#include "OmniTrak_File_Writer.h"
+
+
+//Every heap allocation in the program goes through these, so each phase can count its own.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+	#pragma GCC diagnostic ignored "-Wmismatched-new-delete"       // GCC doesn't see that these are a matched pair.
+#endif
+
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(size_t n)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void *p = malloc(n ? n : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void *operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+
+//Hardware counters for this process and every thread it starts after open().
+class Perf_Counters {
+
+	public:
+
+		enum { CYCLES, INSTRUCTIONS, CACHE_MISSES, NUM_COUNTERS };
+
+		~Perf_Counters()
+		{
+#if defined(__linux__)
+			for (int fd : _fd) {
+				if (fd >= 0) {
+					close(fd);
+				}
+			}
+#endif
+		}
+
+		bool open()
+		{
+#if defined(__linux__)
+			const uint64_t configs[NUM_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+			for (int i = 0; i < NUM_COUNTERS; i++) {
+				perf_event_attr attr;
+				memset(&attr, 0, sizeof(attr));
+				attr.size = sizeof(attr);
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = configs[i];
+				attr.disabled = 1;
+				attr.inherit = 1;                                  // Count the thread pool's workers too.
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+				_fd[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+				if (_fd[i] < 0) {
+					_error = strerror(errno);
+				}
+			}
+#else
+			_error = "perf_event_open is Linux-only";
+#endif
+			return _error.empty();
+		}
+
+		void start()
+		{
+#if defined(__linux__)
+			for (int fd : _fd) {
+				if (fd >= 0) {
+					ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+					ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+				}
+			}
+#endif
+		}
+
+		//Stops counting and reads each counter, scaled for multiplexing (NaN if unavailable).
+		void stop(double *values)
+		{
+			for (int i = 0; i < NUM_COUNTERS; i++) {
+				values[i] = NAN;
+#if defined(__linux__)
+				uint64_t v[3];
+				if (_fd[i] >= 0 && ioctl(_fd[i], PERF_EVENT_IOC_DISABLE, 0) == 0 && read(_fd[i], v, sizeof(v)) == sizeof(v) && v[2] > 0) {
+					values[i] = (double) v[0] * ((double) v[1] / (double) v[2]);
+				}
+#endif
+			}
+		}
+
+		const std::string &error() const { return _error; }
+
+	private:
+
+		int _fd[NUM_COUNTERS] = {-1, -1, -1};
+		std::string _error;
+};
+
+static Perf_Counters perf;
+static volatile uint64_t sink;                                     // Keeps the walk from being optimized away.
+
+
+//Writer device that collects the file in memory.
+struct Memory_Device {
+
+	std::vector<uint8_t> data;
+
+	bool write(uint64_t offset, const uint8_t *bytes, uint32_t n)
+	{
+		if (data.size() < offset + n) {
+			data.resize(offset + n);
+		}
+		memcpy(data.data() + offset, bytes, n);
+		return true;
+	}
+
+	bool sync() { return true; }
+};
+
+typedef OmniTrak_File_Writer<Memory_Device, 2048> Memory_Writer;
+
+
+//The numeric fields, by OmniTrakFileRead.m data structure path, that the decoders total up.
+enum Field {
+	AMG_TIMESTAMP, AMG_FLOAT, HTPA_TIMESTAMP, HTPA_DECIKELVIN,
+	TEMP_ID, TEMP_TIME, TEMP_FLOAT, PRES_ID, PRES_TIME, PRES_FLOAT, HUM_ID, HUM_TIME, HUM_FLOAT,
+	POKE_DATENUM, POKE_MICROS, POKE_STATUS, CAPSENSE_DATENUM, CAPSENSE_MICROS,
+	TRACE_SAMPLE_TIMES, TRACE_SIGNAL,
+	SYNC_PORT, SYNC_DATENUM, SYNC_MILLIS, SYNC_MICROS,
+	NUM_FIELDS
+};
+
+static const char *const FIELD_PATHS[NUM_FIELDS] = {
+	"amg.pixels.timestamp", "amg.pixels.float", "htpa.pixels.timestamp", "htpa.pixels.decikelvin",
+	"temp.id", "temp.time", "temp.float", "pres.id", "pres.time", "pres.float", "hum.id", "hum.time", "hum.float",
+	"poke.datenum", "poke.micros", "poke.status", "capsense.datenum", "capsense.micros",
+	"trace.sample_times", "trace.signal",
+	"clock.sync.port", "clock.sync.datenum", "clock.sync.millis", "clock.sync.micros",
+};
+
+struct Totals {
+
+	double count[NUM_FIELDS];
+	double sum[NUM_FIELDS];
+
+	Totals() { clear(); }
+
+	void clear()
+	{
+		memset(count, 0, sizeof(count));
+		memset(sum, 0, sizeof(sum));
+	}
+
+	void add(Field f, double value, double n = 1)
+	{
+		count[f] += n;
+		sum[f] += value;
+	}
+};
+
+//One block of the file, for decoding without walking the rest.
+struct Block_Ref {
+	uint64_t offset;
+	uint16_t code;
+	uint32_t payload_size;
+};
+
+template <typename T> static T load(const uint8_t *p)
+{
+	T v;
+	memcpy(&v, p, sizeof(T));
+	return v;
+}
+
+static void decode_environment(uint16_t code, const uint8_t *p, Totals &totals)
+{
+	Field first = (code == OFBC_BME280_TEMP_FL) ? TEMP_ID : ((code == OFBC_BME280_PRES_FL) ? PRES_ID : HUM_ID);
+	totals.add(first, p[0]);
+	totals.add((Field) (first + 1), load<uint32_t>(p + 1));
+	totals.add((Field) (first + 2), load<float>(p + 5));
+}
+
+static void decode_operant(uint16_t code, const uint8_t *p, Totals &totals)
+{
+	bool poke = (code == OFBC_POKE_BITMASK);
+	totals.add(poke ? POKE_DATENUM : CAPSENSE_DATENUM, load<double>(p + 1));
+	totals.add(poke ? POKE_MICROS : CAPSENSE_MICROS, load<float>(p + 9));
+	if (poke) {
+		uint8_t sensors = p[13];
+		uint32_t mask = p[14] & ((sensors >= 8) ? 0xFF : ((1u << sensors) - 1));
+		totals.add(POKE_STATUS, __builtin_popcount(mask), sensors);
+	}
+}
+
+static void decode_scope_trace(const uint8_t *p, uint32_t size, Totals &totals)
+{
+	uint32_t at = 3;
+	for (uint8_t i = 0; i < p[2] && at < size; i++) {
+		at += 1 + p[at] + 8;
+	}
+	uint64_t samples = load<uint64_t>(p + at);
+	uint8_t signals = p[at + 8];
+	const uint8_t *values = p + at + 9;
+	double sum = 0;
+	for (uint64_t i = 0; i < samples; i++) {
+		sum += load<float>(values + 4 * i);
+	}
+	totals.add(TRACE_SAMPLE_TIMES, sum, (double) samples);
+	sum = 0;
+	for (uint64_t i = samples; i < samples * (signals + 1); i++) {
+		sum += load<float>(values + 4 * i);
+	}
+	totals.add(TRACE_SIGNAL, sum, (double) (samples * signals));
+}
+
+static void decode_clock_sync(const uint8_t *p, Totals &totals)
+{
+	uint8_t mask = p[2];
+	uint32_t at = 3;
+	totals.add(SYNC_PORT, p[1]);
+	if (mask & 0x01) {
+		totals.add(SYNC_DATENUM, load<double>(p + at));
+		at += 8;
+	}
+	if (mask & 0x02) {
+		totals.add(SYNC_MILLIS, load<uint32_t>(p + at));
+		at += 4;
+	}
+	if (mask & 0x04) {
+		totals.add(SYNC_MICROS, load<uint32_t>(p + at));
+	}
+}
+
+//Decodes thermal frames a batch at a time with the vectorized decoders.
+static void decode_thermal(const uint8_t *file, const std::vector<Block_Ref> &blocks, Totals &totals)
+{
+	static float frames[OFBC_THERMAL_BATCH * 1024];
+	uint32_t millis[OFBC_THERMAL_BATCH];
+	const uint8_t *batch[OFBC_THERMAL_BATCH];
+	size_t queued = 0;
+	uint16_t code = 0;
+	auto flush = [&]() {
+		if (queued == 0) {
+			return;
+		}
+		size_t pixels = ofbc_thermal_pixels(code);
+		ofbc_decode_thermal_frames(code, batch, queued, frames, millis);
+		double sum = 0;
+		if (code == OFBC_HTPA32X32_PIXELS_INT_K) {                 // Back to the stored deciKelvin.
+			for (size_t i = 0; i < queued * pixels; i++) {
+				sum += rintf((frames[i] + 273.15f) * 10.0f);
+			}
+		}
+		else {
+			for (size_t i = 0; i < queued * pixels; i++) {
+				sum += frames[i];
+			}
+		}
+		double time_sum = 0;
+		for (size_t i = 0; i < queued; i++) {
+			time_sum += millis[i];
+		}
+		bool htpa = (code == OFBC_HTPA32X32_PIXELS_INT_K);
+		totals.add(htpa ? HTPA_DECIKELVIN : AMG_FLOAT, sum, (double) (queued * pixels));
+		totals.add(htpa ? HTPA_TIMESTAMP : AMG_TIMESTAMP, time_sum, (double) queued);
+		queued = 0;
+	};
+	for (const Block_Ref &b : blocks) {
+		if (!ofbc_find_thermal_format(b.code)) {
+			continue;
+		}
+		if (b.code != code || queued == OFBC_THERMAL_BATCH) {
+			flush();
+			code = b.code;
+		}
+		batch[queued++] = file + b.offset + 2;
+	}
+	flush();
+}
+
+static void decode_family(int family, const uint8_t *file, const std::vector<Block_Ref> &blocks, Totals &totals)
+{
+	if (family == OMNITRAK_SYNTH_THERMAL) {
+		decode_thermal(file, blocks, totals);
+		return;
+	}
+	for (const Block_Ref &b : blocks) {
+		const uint8_t *p = file + b.offset + 2;
+		switch (b.code) {
+			case OFBC_BME280_TEMP_FL:
+			case OFBC_BME280_PRES_FL:
+			case OFBC_BME280_HUM_FL:	decode_environment(b.code, p, totals); break;
+			case OFBC_POKE_BITMASK:
+			case OFBC_CAPSENSE_VALUE:	decode_operant(b.code, p, totals); break;
+			case OFBC_SCOPE_TRACE:		decode_scope_trace(p, b.payload_size, totals); break;
+			case OFBC_CLOCK_SYNC:		decode_clock_sync(p, totals); break;
+		}
+	}
+}
+
+
+//One measured phase: repeats "fn" for at least "min_seconds" and reports per-pass figures.
+template <typename Fn> static void measure(const char *name, double bytes, double blocks, Fn fn, double min_seconds = 0.5)
+{
+	using clock = std::chrono::steady_clock;
+	double counters[Perf_Counters::NUM_COUNTERS];
+	uint64_t allocs = allocations.load();
+	perf.start();
+	clock::time_point start = clock::now();
+	size_t calls = 0;
+	double elapsed = 0;
+	do {
+		fn();
+		calls++;
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (elapsed < min_seconds);
+	perf.stop(counters);
+	allocs = allocations.load() - allocs;
+	double secs = elapsed / calls;
+	double total_bytes = bytes * calls;
+	printf("%-22s %10.1f %12.4g %10.4g %9.1f", name, bytes / 1e6, bytes / secs / 1e6, blocks / secs, (double) allocs / calls);
+	if (isnan(counters[Perf_Counters::CYCLES])) {
+		printf(" %8s %6s %10s\n", "-", "-", "-");
+	}
+	else {
+		printf(" %8.3f %6.2f %10.1f\n", counters[Perf_Counters::CYCLES] / total_bytes,
+			counters[Perf_Counters::INSTRUCTIONS] / counters[Perf_Counters::CYCLES],
+			counters[Perf_Counters::CACHE_MISSES] / (total_bytes / 1e6));
+	}
+}
+
+//Compares the totals against a "path,count,sum" fixture export. Returns the number of mismatches.
+static int check_fixture(const char *path, const Totals &totals)
+{
+	FILE *fp = fopen(path, "r");
+	if (!fp) {
+		perror(path);
+		return 1;
+	}
+	std::vector<std::string> paths;
+	std::vector<double> counts, sums;
+	char line[1024];
+	while (fgets(line, sizeof(line), fp)) {
+		char *comma1 = strchr(line, ',');
+		char *comma2 = comma1 ? strchr(comma1 + 1, ',') : nullptr;
+		if (!comma2) {
+			continue;
+		}
+		paths.push_back(std::string(line, comma1 - line));
+		counts.push_back(atof(comma1 + 1));
+		sums.push_back(atof(comma2 + 1));
+	}
+	fclose(fp);
+
+	int mismatches = 0;
+	printf("\n%-26s %14s %14s %22s %22s %s\n", "field", "count", "MATLAB count", "sum", "MATLAB sum", "");
+	for (int f = 0; f < NUM_FIELDS; f++) {
+		size_t i = 0;
+		while (i < paths.size() && paths[i] != FIELD_PATHS[f]) {
+			i++;
+		}
+		if (i == paths.size()) {
+			if (totals.count[f] > 0) {
+				printf("%-26s %14.0f %14s %22.17g %22s MISSING\n", FIELD_PATHS[f], totals.count[f], "-", totals.sum[f], "-");
+				mismatches++;
+			}
+			continue;
+		}
+		double tolerance = 1e-9 * fmax(1.0, fabs(sums[i])) + 1e-7 * fabs(sums[i]);   // Summation order differs.
+		bool match = totals.count[f] == counts[i] && fabs(totals.sum[f] - sums[i]) <= tolerance;
+		mismatches += !match;
+		printf("%-26s %14.0f %14.0f %22.17g %22.17g %s\n", FIELD_PATHS[f], totals.count[f], counts[i], totals.sum[f], sums[i],
+			match ? "ok" : "MISMATCH");
+	}
+	return mismatches;
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: OmniTrak_Benchmark [--size N[K|M|G]] [--mix family=weight,...] [--seed N] [-j threads]\n"
+		"                          [--check fixture.csv] [file.OmniTrak]\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	OmniTrak_Synth_Config config;
+	config.target_bytes = 256ull << 20;
+	unsigned threads = 0;
+	const char *fixture = nullptr;
+	const char *path = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+			if ((config.target_bytes = omnitrak_synth_parse_size(argv[++i])) == 0) {
+				usage();
+			}
+		}
+		else if (!strcmp(argv[i], "--mix") && i + 1 < argc) {
+			if (!config.set_mix(argv[++i])) {
+				usage();
+			}
+		}
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+			config.seed = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			threads = (unsigned) atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--check") && i + 1 < argc) {
+			fixture = argv[++i];
+		}
+		else if (argv[i][0] == '-' || path) {
+			usage();
+		}
+		else {
+			path = argv[i];
+		}
+	}
+	if (fixture && !path) {
+		fprintf(stderr, "--check needs the file the fixture was exported from\n");
+		return 2;
+	}
+
+	if (!perf.open()) {
+		fprintf(stderr, "hardware counters unavailable (%s)\n", perf.error().c_str());
+	}
+	OmniTrak_Thread_Pool pool(threads);                            // After perf.open(), so its workers are counted.
+
+	printf("%-22s %10s %12s %10s %9s %8s %6s %10s\n", "phase", "MB", "MB/s", "blocks/s", "allocs", "cyc/B", "IPC", "LLCmiss/MB");
+
+	//Writer, one family at a time.
+	for (int f = 0; f < OMNITRAK_SYNTH_FAMILIES; f++) {
+		OmniTrak_Synth_Config alone = config;
+		for (int g = 0; g < OMNITRAK_SYNTH_FAMILIES; g++) {
+			alone.weights[g] = (g == f) ? fmax(config.weights[g], 1.0) : 0;
+		}
+		alone.target_bytes = std::min<uint64_t>(config.target_bytes, 64ull << 20);
+		Memory_Device device;
+		device.data.reserve(alone.target_bytes + (4 << 20));
+		std::unique_ptr<Memory_Writer> writer(new Memory_Writer(device));
+		OmniTrak_Synthesizer probe(alone);                         // One untimed pass for the block count.
+		probe.write(*writer);
+		std::string name = std::string("write ") + OMNITRAK_SYNTH_FAMILY_NAMES[f];
+		measure(name.c_str(), (double) writer->position(), (double) probe.blocks((OmniTrak_Synth_Family) f), [&]() {
+			OmniTrak_Synthesizer synth(alone);
+			synth.write(*writer);
+		});
+	}
+
+	//The file to read: given, or generated with the requested mix.
+	OmniTrak_File_Map map;
+	Memory_Device generated;
+	const uint8_t *data;
+	uint64_t size;
+	if (path) {
+		if (!map.open(path)) {
+			fprintf(stderr, "%s\n", map.error().c_str());
+			return 1;
+		}
+		data = map.data();
+		size = map.size();
+	}
+	else {
+		std::unique_ptr<Memory_Writer> writer(new Memory_Writer(generated));
+		OmniTrak_Synthesizer synth(config);
+		synth.write(*writer);
+		data = generated.data.data();
+		size = writer->position();
+	}
+
+	//Decoders, from a list of each family's blocks.
+	std::vector<Block_Ref> families[OMNITRAK_SYNTH_FAMILIES + 1];
+	uint64_t family_bytes[OMNITRAK_SYNTH_FAMILIES + 1] = {};
+	uint64_t total_blocks = 0;
+	OmniTrak_Block_Reader reader(data, size);
+	OmniTrak_Block_View blk;
+	while (reader.next(blk)) {
+		int f = omnitrak_synth_family(blk.code);
+		families[f].push_back({blk.offset, blk.code, (uint32_t) blk.payload_size});
+		family_bytes[f] += 2 + blk.payload_size;
+		total_blocks++;
+	}
+	if (reader.status() != OMNITRAK_READ_END) {
+		fprintf(stderr, "stopped at byte %llu: %s\n", (unsigned long long) reader.position(), omnitrak_read_status_string(reader.status()));
+	}
+	Totals totals;
+	for (int f = 0; f <= OMNITRAK_SYNTH_FAMILIES; f++) {
+		if (families[f].empty() || f == OMNITRAK_SYNTH_OTHER) {
+			continue;
+		}
+		std::string name = std::string("decode ") + OMNITRAK_SYNTH_FAMILY_NAMES[f];
+		measure(name.c_str(), (double) family_bytes[f], (double) families[f].size(), [&]() {
+			Totals pass;
+			decode_family(f, data, families[f], pass);
+			for (int i = 0; i < NUM_FIELDS; i++) {
+				if (pass.count[i] > 0) {
+					totals.count[i] = pass.count[i];
+					totals.sum[i] = pass.sum[i];
+				}
+			}
+		});
+	}
+
+	//Whole-file readers.
+	measure("walk", (double) size, (double) total_blocks, [&]() {
+		OmniTrak_Block_Reader r(data, size);
+		OmniTrak_Block_View b;
+		uint64_t codes = 0;
+		while (r.next(b)) {
+			codes += b.code;
+		}
+		sink = codes;
+	});
+	std::string scan_name = "scan (" + std::to_string(pool.size()) + " threads)";
+	measure(scan_name.c_str(), (double) size, (double) total_blocks, [&]() {
+		OmniTrak_Parallel_Parser parser;
+		parser.scan(data, size, pool);
+	});
+
+	if (fixture) {
+		int mismatches = check_fixture(fixture, totals);
+		printf("fixture check: %s\n", mismatches ? "MISMATCH" : "identical");
+		return mismatches ? 1 : 0;
+	}
+	return 0;
+}
@@ -0,0 +1,271 @@
+/*
+	OmniTrak_Convert.cpp
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Batch Column Converter
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Converts *.OmniTrak files (or every *.OmniTrak file under a directory)
+	into memory-mappable column files (see OmniTrak_File_Columns.h), one
+	output directory per session, spreading the files across all cores.
+	Sessions that would share an output directory (e.g. day1/s.OmniTrak
+	and day2/s.OmniTrak) go under a subdirectory named for their input
+	or parent directory instead (day1/s, day2/s). With --catalog, only
+	the header blocks of each file are read and a CSV catalog (subject,
+	system type, start time) is printed instead.
+
+		OmniTrak_Convert -o columns/ -j 16 archive/
+		OmniTrak_Convert --catalog archive/ > catalog.csv
+
+	Build:
+		g++ -std=c++17 -O2 -pthread -I"../C Libraries" OmniTrak_Convert.cpp -o OmniTrak_Convert
+
+	Requires C++17.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "OmniTrak_File_Catalog.h"
+#include "OmniTrak_File_Columns.h"
+#include "OmniTrak_Thread_Pool.h"
+
+namespace fs = std::filesystem;
+
+
+//One input file and the output directory it converts into.
+struct Convert_Job {
+	fs::path source;
+	fs::path out_dir;
+	fs::path alt_out_dir;                                          // Used instead if another job has the same out_dir.
+};
+
+
+static void print_usage()
+{
+	fprintf(stderr,
+		"Usage: OmniTrak_Convert [options] <file or directory>...\n"
+		"  -o <dir>     output directory (default: current directory)\n"
+		"  -j <n>       worker threads (default: one per core)\n"
+		"  --catalog    print a CSV catalog of the file headers instead of converting\n");
+}
+
+
+//Case-insensitive check for the *.OmniTrak extension.
+static bool is_omnitrak_file(const fs::path &path)
+{
+	std::string ext = path.extension().string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char) tolower(c); });
+	return ext == ".omnitrak";
+}
+
+
+//Name of the directory "path" is in, or names, for telling apart outputs that would collide.
+static std::string directory_label(const fs::path &dir)
+{
+	std::error_code ec;
+	fs::path full = fs::weakly_canonical(dir, ec);
+	std::string label = (ec ? fs::absolute(dir) : full).filename().string();
+	return label.empty() ? "root" : label;
+}
+
+
+//Expands the command-line inputs into jobs, skipping files named more than once. Files
+//found under a directory keep their relative path in the output; files named directly
+//are placed at the top level.
+static bool collect_jobs(const std::vector<std::string> &inputs, const fs::path &out_root, std::vector<Convert_Job> &jobs)
+{
+	std::set<fs::path> seen;
+	auto add_job = [&](const fs::path &source, const fs::path &rel, const std::string &label) {
+		std::error_code ec;
+		fs::path key = fs::weakly_canonical(source, ec);
+		if (seen.insert(ec ? source : key).second) {
+			jobs.push_back({source, out_root / rel, out_root / label / rel});
+		}
+	};
+	for (const std::string &input : inputs) {
+		std::error_code ec;
+		if (fs::is_directory(input, ec)) {
+			std::string label = directory_label(input);
+			for (fs::recursive_directory_iterator it(input, ec), end; !ec && it != end; it.increment(ec)) {
+				if (it->is_regular_file(ec) && is_omnitrak_file(it->path())) {
+					fs::path rel = fs::relative(it->path(), input, ec);
+					add_job(it->path(), rel.replace_extension(), label);
+				}
+			}
+		}
+		else if (fs::is_regular_file(input, ec)) {
+			fs::path source = input;
+			add_job(source, source.stem(), directory_label(source.parent_path().empty() ? "." : source.parent_path()));
+		}
+		if (ec) {
+			fprintf(stderr, "ERROR: can't read \"%s\" (%s)\n", input.c_str(), ec.message().c_str());
+			return false;
+		}
+	}
+	std::sort(jobs.begin(), jobs.end(), [](const Convert_Job &a, const Convert_Job &b) { return a.source < b.source; });
+	return true;
+}
+
+
+//Moves jobs that would share an output directory (files with the same name, or the same
+//relative path under different input directories) into a subdirectory named for their
+//input or parent directory. Returns false if any output directory is still shared.
+static bool make_out_dirs_unique(std::vector<Convert_Job> &jobs)
+{
+	std::map<fs::path, size_t> uses;
+	for (const Convert_Job &job : jobs) {
+		uses[job.out_dir]++;
+	}
+	for (Convert_Job &job : jobs) {
+		if (uses[job.out_dir] > 1) {
+			job.out_dir = job.alt_out_dir;
+		}
+	}
+	std::map<fs::path, const Convert_Job *> owner;
+	for (const Convert_Job &job : jobs) {
+		auto it = owner.emplace(job.out_dir, &job);
+		if (!it.second) {
+			fprintf(stderr, "ERROR: \"%s\" and \"%s\" would both be converted into \"%s\"; convert them separately.\n",
+				it.first->second->source.string().c_str(), job.source.string().c_str(), job.out_dir.string().c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+
+//Quotes a CSV field if it needs it.
+static std::string csv_field(const std::string &s)
+{
+	if (s.find_first_of(",\"\r\n") == std::string::npos) {
+		return s;
+	}
+	std::string out = "\"";
+	for (char c : s) {
+		out += c;
+		if (c == '"') {
+			out += '"';
+		}
+	}
+	return out + "\"";
+}
+
+
+static int run_catalog(const std::vector<Convert_Job> &jobs, unsigned threads)
+{
+	std::vector<OmniTrak_Catalog_Entry> entries(jobs.size());
+	std::vector<char> ok(jobs.size(), 0);
+	{
+		OmniTrak_Thread_Pool pool(threads);
+		for (size_t i = 0; i < jobs.size(); i++) {
+			pool.submit([&, i]() { ok[i] = omnitrak_read_catalog(jobs[i].source.string(), entries[i]); });
+		}
+		pool.wait();
+	}
+	printf("file,file_version,subject,system_type,system_name,start_datenum,start_millis,status\n");
+	int failures = 0;
+	for (size_t i = 0; i < jobs.size(); i++) {
+		const OmniTrak_Catalog_Entry &e = entries[i];
+		printf("%s,", csv_field(jobs[i].source.string()).c_str());
+		if (!ok[i]) {
+			printf(",,,,,,%s\n", e.status == OMNITRAK_READ_BAD_HEADER ? "not an OmniTrak file" : "can't open");
+			failures++;
+			continue;
+		}
+		printf("%u,%s,", e.file_version, csv_field(e.subject).c_str());
+		e.has_system_type ? printf("%u,", e.system_type) : printf(",");
+		printf("%s,", csv_field(e.system_name).c_str());
+		e.has_start_datenum ? printf("%.10f,", e.start_datenum) : printf(",");
+		e.has_start_millis ? printf("%u,", e.start_millis) : printf(",");
+		printf("%s\n", e.complete ? "OK" : omnitrak_read_status_string(e.status));
+	}
+	return failures ? 1 : 0;
+}
+
+
+static int run_convert(const std::vector<Convert_Job> &jobs, unsigned threads)
+{
+	std::atomic<uint64_t> total_blocks {0};
+	std::atomic<int> failures {0};
+	std::mutex print_mutex;
+	{
+		OmniTrak_Thread_Pool pool(threads);
+		for (const Convert_Job &job : jobs) {
+			pool.submit([&]() {
+				OmniTrak_Column_Converter converter;
+				bool ok = converter.convert(job.source.string(), job.out_dir.string());
+				total_blocks += converter.blocks();
+				std::lock_guard<std::mutex> lock(print_mutex);
+				if (!ok) {
+					fprintf(stderr, "ERROR: %s\n", converter.error().c_str());
+					failures++;
+				}
+				else if (converter.stop_status() != OMNITRAK_READ_END) {
+					fprintf(stderr, "WARNING: \"%s\": %s at byte %llu; converted the blocks before it.\n",
+						job.source.string().c_str(), omnitrak_read_status_string(converter.stop_status()),
+						(unsigned long long) converter.stop_offset());
+				}
+			});
+		}
+		pool.wait();
+	}
+	fprintf(stderr, "Converted %zu file(s), %llu blocks, %d failure(s).\n",
+		jobs.size() - failures, (unsigned long long) total_blocks, (int) failures);
+	return failures ? 1 : 0;
+}
+
+
+int main(int argc, char **argv)
+{
+	std::string out_root = ".";
+	unsigned threads = 0;
+	bool catalog = false;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			out_root = argv[++i];
+		}
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			threads = (unsigned) atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--catalog") == 0) {
+			catalog = true;
+		}
+		else if (argv[i][0] == '-') {
+			print_usage();
+			return 2;
+		}
+		else {
+			inputs.push_back(argv[i]);
+		}
+	}
+	if (inputs.empty()) {
+		print_usage();
+		return 2;
+	}
+
+	std::vector<Convert_Job> jobs;
+	if (!collect_jobs(inputs, out_root, jobs)) {
+		return 1;
+	}
+	if (catalog) {
+		return run_catalog(jobs, threads);
+	}
+	if (!make_out_dirs_unique(jobs)) {
+		return 1;
+	}
+	return run_convert(jobs, threads);
+}
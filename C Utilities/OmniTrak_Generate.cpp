@@ -0,0 +1,134 @@
+/*
+	OmniTrak_Generate.cpp
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Synthetic File Generator
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Writes a synthetic *.OmniTrak session (see OmniTrak_File_Synth.h) of the
+	given size and block mix, streamed through OmniTrak_File_Writer so even
+	tens of gigabytes need only a few megabytes of memory. Optionally
+	overwrites random stretches with garbage (--corrupt) and cuts bytes off
+	the end (--truncate), printing where, so readers' recovery can be tested
+	against a known file.
+
+		OmniTrak_Generate --size 10G --mix thermal=4,scope=0 --corrupt 20 big.OmniTrak
+
+	Build:
+		g++ -std=c++17 -O2 -I"../C Libraries" OmniTrak_Generate.cpp -o OmniTrak_Generate
+
+	Requires C++17.
+*/
+
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "OmniTrak_File_Synth.h"
+#include "OmniTrak_File_Writer.h"
+
+typedef OmniTrak_File_Writer<OmniTrak_File_Block_Device, 2048> Big_Writer;   // 1 MB buffers.
+
+
+static void usage()
+{
+	fprintf(stderr, "usage: OmniTrak_Generate [--size N[K|M|G|T]] [--mix family=weight,...] [--seed N]\n"
+		"                         [--corrupt N] [--truncate BYTES] file.OmniTrak\n"
+		"families: clock, thermal, environment, operant, scope\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	OmniTrak_Synth_Config config;
+	uint32_t corrupt = 0;
+	uint64_t truncate_bytes = 0;
+	const char *path = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+			if ((config.target_bytes = omnitrak_synth_parse_size(argv[++i])) == 0) {
+				usage();
+			}
+		}
+		else if (!strcmp(argv[i], "--mix") && i + 1 < argc) {
+			if (!config.set_mix(argv[++i])) {
+				usage();
+			}
+		}
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+			config.seed = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (!strcmp(argv[i], "--corrupt") && i + 1 < argc) {
+			corrupt = (uint32_t) atol(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--truncate") && i + 1 < argc) {
+			truncate_bytes = strtoull(argv[++i], nullptr, 0);
+		}
+		else if (argv[i][0] == '-' || path) {
+			usage();
+		}
+		else {
+			path = argv[i];
+		}
+	}
+	if (!path) {
+		usage();
+	}
+
+	OmniTrak_File_Block_Device device;
+	if (!device.open(path)) {
+		perror(path);
+		return 1;
+	}
+	std::unique_ptr<Big_Writer> writer(new Big_Writer(device));
+	OmniTrak_Synthesizer synth(config);
+	auto t0 = std::chrono::steady_clock::now();
+	if (!synth.write(*writer)) {
+		perror(path);
+		return 1;
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	uint64_t size = writer->position();
+	device.close();
+
+	printf("%s: %llu bytes in %.2f s (%.0f MB/s), %.1f simulated hours\n", path, (unsigned long long) size, secs,
+		size / secs / 1e6, synth.seconds() / 3600);
+	for (int f = 0; f < OMNITRAK_SYNTH_FAMILIES; f++) {
+		printf("  %-12s %12llu blocks %14llu bytes\n", OMNITRAK_SYNTH_FAMILY_NAMES[f],
+			(unsigned long long) synth.blocks((OmniTrak_Synth_Family) f), (unsigned long long) synth.payload_bytes((OmniTrak_Synth_Family) f));
+	}
+
+	if (corrupt > 0 || truncate_bytes > 0) {
+		int fd = open(path, O_WRONLY);
+		if (fd < 0) {
+			perror(path);
+			return 1;
+		}
+		for (const OmniTrak_Synth_Damage &d : omnitrak_synth_damage(size, corrupt, config.seed)) {
+			uint8_t bytes[16];
+			omnitrak_synth_damage_bytes(d, bytes);
+			if (pwrite(fd, bytes, d.length, (off_t) d.offset) != (ssize_t) d.length) {
+				perror(path);
+				return 1;
+			}
+			printf("  corrupted %llu-%llu\n", (unsigned long long) d.offset, (unsigned long long) (d.offset + d.length));
+		}
+		if (truncate_bytes > 0) {
+			uint64_t keep = (truncate_bytes < size - OFBC_FILE_HEADER_SIZE) ? size - truncate_bytes : OFBC_FILE_HEADER_SIZE;
+			if (ftruncate(fd, (off_t) keep) != 0) {
+				perror(path);
+				return 1;
+			}
+			printf("  truncated to %llu bytes\n", (unsigned long long) keep);
+		}
+		close(fd);
+	}
+	return 0;
+}
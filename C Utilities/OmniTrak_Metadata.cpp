@@ -0,0 +1,172 @@
+/*
+	OmniTrak_Metadata.cpp
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Metadata Utility
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Shows and records file metadata (see OmniTrak_File_Metadata.h) without
+	rewriting the file: "rename" appends a RENAMED_FILE record (plus
+	ORIGINAL_FILENAME the first time) and renames the file, "download"
+	appends DOWNLOAD_TIME and DOWNLOAD_SYSTEM, and "original" appends
+	ORIGINAL_FILENAME, each as one synced trailer at the end of the file.
+	"repair" fixes files whose last block is torn, including files where
+	older tools appended metadata after the torn block, by cutting the
+	file short; with --output it writes a repaired copy instead.
+
+		OmniTrak_Metadata download session.OmniTrak COM4
+		OmniTrak_Metadata rename session.OmniTrak 2025-08-26_Rat12_Session3.OmniTrak
+		OmniTrak_Metadata show *.OmniTrak
+
+	Build:
+		g++ -std=c++17 -O2 -I"../C Libraries" OmniTrak_Metadata.cpp -o OmniTrak_Metadata
+
+	Requires C++17.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+
+#include "OmniTrak_File_Metadata.h"
+
+
+static void usage()
+{
+	fprintf(stderr, "usage: OmniTrak_Metadata show file.OmniTrak [file.OmniTrak ...]\n"
+		"       OmniTrak_Metadata rename old.OmniTrak new.OmniTrak\n"
+		"       OmniTrak_Metadata download file.OmniTrak port [--system name]\n"
+		"       OmniTrak_Metadata original file.OmniTrak name\n"
+		"       OmniTrak_Metadata repair file.OmniTrak [--output repaired.OmniTrak]\n");
+	exit(2);
+}
+
+//Formats a serial date number as "yyyy-mm-dd HH:MM:SS".
+static std::string datenum_string(double datenum)
+{
+	time_t t = (time_t) llround(omnitrak_datenum_to_unix(datenum));
+	struct tm tm;
+	char buf[32];
+	if (!gmtime_r(&t, &tm) || !strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm)) {
+		snprintf(buf, sizeof(buf), "%.6f", datenum);
+	}
+	return buf;
+}
+
+static bool failed(const char *path, OmniTrak_Metadata_Status status)
+{
+	if (status == OMNITRAK_METADATA_OK) {
+		return false;
+	}
+	fprintf(stderr, "%s: %s\n", path, omnitrak_metadata_status_string(status));
+	if (status == OMNITRAK_METADATA_TORN_TAIL) {
+		fprintf(stderr, "  run \"OmniTrak_Metadata repair %s\" first\n", path);
+	}
+	return true;
+}
+
+static int show(int argc, char **argv)
+{
+	int result = 0;
+	for (int i = 0; i < argc; i++) {
+		OmniTrak_File_Metadata meta;
+		OmniTrak_Metadata_Status status = omnitrak_read_metadata(argv[i], meta);
+		if (status != OMNITRAK_METADATA_OK && status != OMNITRAK_METADATA_NO_TRAILER) {
+			failed(argv[i], status);
+			result = 1;
+			if (status != OMNITRAK_METADATA_BAD_TRAILER) {
+				continue;
+			}
+		}
+		printf("%s: %u trailer(s), %u metadata block(s) after the header\n", argv[i], meta.trailers, meta.leading_blocks);
+		if (!meta.original_filename.empty()) {
+			printf("  original filename: %s\n", meta.original_filename.c_str());
+		}
+		for (const OmniTrak_File_Rename &r : meta.renames) {
+			printf("  renamed %s: %s -> %s\n", datenum_string(r.datenum).c_str(), r.from.c_str(), r.to.c_str());
+		}
+		if (meta.download_time != 0) {
+			printf("  downloaded: %s\n", datenum_string(meta.download_time).c_str());
+		}
+		if (!meta.download_computer.empty() || !meta.download_port.empty()) {
+			printf("  download system: %s, %s\n", meta.download_computer.c_str(), meta.download_port.c_str());
+		}
+	}
+	return result;
+}
+
+static int repair(const char *path, const char *output)
+{
+	OmniTrak_Tail_Repair r;
+	OmniTrak_Metadata_Status status = omnitrak_repair_tail(path, r, output);
+	if (status == OMNITRAK_METADATA_DAMAGED) {
+		fprintf(stderr, "%s: %s (%s at byte %llu)\n", path, omnitrak_metadata_status_string(status),
+			omnitrak_read_status_string(r.stream), (unsigned long long) r.kept);
+		return 1;
+	}
+	if (failed(path, status)) {
+		return 1;
+	}
+	if (!r.changed()) {
+		printf("%s: nothing to repair\n", path);
+		return 0;
+	}
+	if (r.torn_bytes > 0) {
+		printf("%s: dropped a torn %s block (%llu bytes at byte %llu)\n", path, ofbc_block_name(r.torn_code),
+			(unsigned long long) r.torn_bytes, (unsigned long long) r.kept);
+	}
+	if (r.legacy_blocks > 0) {
+		printf("%s: moved %u metadata block(s) appended after the block stream into a trailer\n", path, r.legacy_blocks);
+	}
+	printf("%s: kept %llu of %llu bytes%s%s\n", path, (unsigned long long) r.kept, (unsigned long long) r.size,
+		output ? ", written to " : "", output ? output : "");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 3) {
+		usage();
+	}
+	const char *command = argv[1];
+	const char *path = argv[2];
+	if (!strcmp(command, "show")) {
+		return show(argc - 2, argv + 2);
+	}
+	else if (!strcmp(command, "rename") && argc == 4) {
+		return failed(path, omnitrak_rename_file(path, argv[3], omnitrak_datenum_now())) ? 1 : 0;
+	}
+	else if (!strcmp(command, "download") && (argc == 4 || (argc == 6 && !strcmp(argv[4], "--system")))) {
+		char host[256] = "";
+		if (argc == 6) {
+			snprintf(host, sizeof(host), "%s", argv[5]);
+		}
+		else if (gethostname(host, sizeof(host)) != 0) {
+			host[0] = '\0';
+		}
+		host[sizeof(host) - 1] = '\0';
+		OmniTrak_Metadata_Trailer trailer;
+		if (!trailer.download_time(omnitrak_datenum_now()) || !trailer.download_system(host, argv[3])) {
+			return failed(path, OMNITRAK_METADATA_TOO_LONG) ? 1 : 0;
+		}
+		return failed(path, omnitrak_append_metadata(path, trailer)) ? 1 : 0;
+	}
+	else if (!strcmp(command, "original") && argc == 4) {
+		OmniTrak_Metadata_Trailer trailer;
+		if (!trailer.original_filename(argv[3])) {
+			return failed(path, OMNITRAK_METADATA_TOO_LONG) ? 1 : 0;
+		}
+		return failed(path, omnitrak_append_metadata(path, trailer)) ? 1 : 0;
+	}
+	else if (!strcmp(command, "repair") && (argc == 3 || (argc == 5 && !strcmp(argv[3], "--output")))) {
+		return repair(path, (argc == 5) ? argv[4] : nullptr);
+	}
+	usage();
+	return 2;
+}
@@ -0,0 +1,286 @@
+/*
+	OmniTrak_Packed_Benchmark.cpp
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Packed Stream Benchmark
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Writes synthetic CAPSENSE_VALUE, POKE_BITMASK, AMBULATION_XY_THETA, and
+	ALSPT19_LIGHT streams both as one block per sample and as *_PACKED
+	batches (see OmniTrak_File_Packed.h), then reports the size reduction
+	and the decode rate, in samples per second, of reading each back into
+	arrays, and checks that both decode to the same samples.
+
+		OmniTrak_Packed_Benchmark [samples per stream]
+
+	Build (add -DOFBC_PACKED_NO_SIMD for the scalar decoder):
+		g++ -std=c++17 -O2 -I"../C Libraries" OmniTrak_Packed_Benchmark.cpp -o OmniTrak_Packed_Benchmark
+
+	Requires C++17.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "OmniTrak_File_Packed.h"
+#include "OmniTrak_File_Reader.h"
+#include "OmniTrak_File_Writer.h"
+
+
+//Writer device that collects the file in memory.
+struct Memory_Device {
+
+	std::vector<uint8_t> data;
+
+	bool write(uint64_t offset, const uint8_t *bytes, uint32_t n)
+	{
+		if (data.size() < offset + n) {
+			data.resize(offset + n);
+		}
+		memcpy(data.data() + offset, bytes, n);
+		return true;
+	}
+
+	bool sync() { return true; }
+};
+
+typedef OmniTrak_File_Writer<Memory_Device, 64> Memory_Writer;
+
+//One synthetic stream: timestamps and up to 3 value channels per sample.
+struct Stream {
+	uint16_t code;                                                 // Unpacked block code.
+	std::vector<uint32_t> times;
+	std::vector<int32_t> values[3];
+	double datenum = 738000.5;                                     // Serial date of the first sample.
+};
+
+
+//Seconds per call of "fn", repeated until at least "min_seconds" have passed.
+template <typename Fn> static double time_per_call(Fn fn, double min_seconds = 0.5)
+{
+	using clock = std::chrono::steady_clock;
+	size_t calls = 0;
+	clock::time_point start = clock::now();
+	double elapsed = 0;
+	do {
+		fn();
+		calls++;
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (elapsed < min_seconds);
+	return elapsed / calls;
+}
+
+//The unpacked POKE_BITMASK and CAPSENSE_VALUE blocks hold float32 microseconds; this is what they read back as.
+static uint32_t float_micros(float micros)
+{
+	return (micros >= 4294967296.0f) ? 0 : (uint32_t) micros;
+}
+
+static Stream make_stream(uint16_t code, size_t n, std::mt19937 &rng)
+{
+	Stream s;
+	s.code = code;
+	uint32_t t = 4000000000u;                                      // Close to rollover, so the clock wraps mid-stream.
+	int32_t v[3] = {3, 0, 500};
+	float x = 100, y = 100, theta = 0;
+	std::uniform_int_distribution<int> jitter(-20, 20), noise(-12, 12), coin(0, 199);
+	for (size_t i = 0; i < n; i++) {
+		switch (code) {
+			case OFBC_CAPSENSE_VALUE:                              // 100 Hz sensor loop with a few microseconds of jitter.
+				t += 10000 + jitter(rng);
+				v[2] = std::min(4095, std::max(0, v[2] + noise(rng)));    // 12-bit ADC.
+				if (coin(rng) == 0) {
+					v[1] ^= 1 << (coin(rng) % 3);
+				}
+				break;
+			case OFBC_POKE_BITMASK:                                // Written only on a change, at irregular times.
+				t += 50000 + (uint32_t) (rng() % 3000000);
+				v[1] ^= 1 << (rng() % 3);
+				break;
+			case OFBC_ALSPT19_LIGHT:                               // 10 Hz, millisecond clock.
+				t += 100 + jitter(rng) / 20;
+				v[0] = 700 + noise(rng) / 4;
+				break;
+			case OFBC_AMBULATION_XY_THETA:                         // 30 Hz video tracking, 0.25 mm pixels.
+				t += 33333 + jitter(rng);
+				x += 0.25f * (float) (noise(rng) / 4);
+				y += 0.25f * (float) (noise(rng) / 4);
+				theta = (float) ((int) (theta + (float) noise(rng) + 360) % 360);
+				v[0] = ofbc_float_bits(x);
+				v[1] = ofbc_float_bits(y);
+				v[2] = ofbc_float_bits(theta);
+				break;
+		}
+		s.times.push_back(t);
+		for (int c = 0; c < 3; c++) {
+			s.values[c].push_back(v[c]);
+		}
+	}
+	return s;
+}
+
+static std::vector<uint8_t> write_unpacked(const Stream &s)
+{
+	Memory_Device device;
+	Memory_Writer writer(device);
+	writer.begin();
+	for (size_t i = 0; i < s.times.size(); i++) {
+		double datenum = s.datenum + (double) (uint32_t) (s.times[i] - s.times[0]) / 86400e6;
+		switch (s.code) {
+			case OFBC_CAPSENSE_VALUE:
+				writer.write_block<OFBC_CAPSENSE_VALUE>((uint8_t) 1, datenum, (float) s.times[i], (uint8_t) s.values[0][i],
+					(uint8_t) s.values[1][i], (uint8_t) 0, (uint16_t) s.values[2][i]);
+				break;
+			case OFBC_POKE_BITMASK:
+				writer.write_block<OFBC_POKE_BITMASK>((uint8_t) 1, datenum, (float) s.times[i], (uint8_t) s.values[0][i],
+					(uint8_t) s.values[1][i]);
+				break;
+			case OFBC_ALSPT19_LIGHT:
+				writer.write_block<OFBC_ALSPT19_LIGHT>((uint8_t) 0, s.times[i], (uint16_t) s.values[0][i]);
+				break;
+			case OFBC_AMBULATION_XY_THETA:
+				writer.write_block<OFBC_AMBULATION_XY_THETA>((uint8_t) 1, s.times[i], ofbc_bits_float(s.values[0][i]),
+					ofbc_bits_float(s.values[1][i]), ofbc_bits_float(s.values[2][i]));
+				break;
+		}
+		writer.service();
+	}
+	writer.close();
+	return device.data;
+}
+
+template <uint16_t CODE> static std::vector<uint8_t> write_packed(const Stream &s)
+{
+	typedef OmniTrak_Packed_Encoder<CODE> Encoder;
+	Memory_Device device;
+	Memory_Writer writer(device);
+	Encoder encoder;
+	writer.begin();
+	int32_t values[Encoder::CHANNELS];
+	for (size_t i = 0; i < s.times.size(); i++) {
+		for (int c = 0; c < Encoder::CHANNELS; c++) {
+			values[c] = s.values[c][i];
+		}
+		encoder.add(writer, s.times[i], values, s.datenum + (double) (uint32_t) (s.times[i] - s.times[0]) / 86400e6);
+		writer.service();
+	}
+	encoder.write(writer);
+	writer.close();
+	return device.data;
+}
+
+//Reads the one-block-per-sample file into a timestamp array and a channel-major value array.
+static size_t read_unpacked(const std::vector<uint8_t> &file, uint16_t code, uint32_t *times, int32_t *values, size_t n)
+{
+	OmniTrak_Block_Reader reader(file.data(), file.size());
+	OmniTrak_Code_Set wanted = {code};
+	OmniTrak_Block_View blk;
+	size_t i = 0;
+	while (i < n && reader.next(blk, wanted)) {
+		switch (code) {
+			case OFBC_CAPSENSE_VALUE:
+				times[i] = float_micros(blk.get<float>(9));
+				values[i] = blk.payload[13];
+				values[n + i] = blk.payload[14];
+				values[2 * n + i] = blk.get<uint16_t>(16);
+				break;
+			case OFBC_POKE_BITMASK:
+				times[i] = float_micros(blk.get<float>(9));
+				values[i] = blk.payload[13];
+				values[n + i] = blk.payload[14];
+				break;
+			case OFBC_ALSPT19_LIGHT:
+				times[i] = blk.get<uint32_t>(1);
+				values[i] = blk.get<uint16_t>(5);
+				break;
+			case OFBC_AMBULATION_XY_THETA:
+				times[i] = blk.get<uint32_t>(1);
+				values[i] = blk.get<int32_t>(5);
+				values[n + i] = blk.get<int32_t>(9);
+				values[2 * n + i] = blk.get<int32_t>(13);
+				break;
+		}
+		i++;
+	}
+	return i;
+}
+
+//Reads the packed file into the same arrays.
+static size_t read_packed(const std::vector<uint8_t> &file, uint16_t code, uint32_t *times, int32_t *values, size_t n)
+{
+	OmniTrak_Block_Reader reader(file.data(), file.size());
+	OmniTrak_Code_Set wanted = {code};
+	OmniTrak_Block_View blk;
+	OmniTrak_Packed_Batch batch;
+	uint32_t batch_times[OFBC_PACKED_MAX_SAMPLES];
+	int32_t batch_values[3 * OFBC_PACKED_MAX_SAMPLES];
+	size_t i = 0;
+	while (reader.next(blk, wanted)) {
+		if (!omnitrak_parse_packed(blk.code, blk.payload, blk.payload_size, batch) || i + batch.samples > n) {
+			break;
+		}
+		size_t m = omnitrak_decode_packed(batch, batch_times, batch_values);
+		memcpy(times + i, batch_times, m * sizeof(uint32_t));
+		for (uint8_t c = 0; c < batch.channels; c++) {
+			memcpy(values + c * n + i, batch_values + c * m, m * sizeof(int32_t));
+		}
+		i += m;
+	}
+	return i;
+}
+
+
+int main(int argc, char **argv)
+{
+	size_t n = (argc > 1) ? (size_t) atol(argv[1]) : 1000000;
+	if (n == 0) {
+		fprintf(stderr, "Usage: OmniTrak_Packed_Benchmark [samples per stream]\n");
+		return 2;
+	}
+	printf("Decoder: %s\n", OFBC_PACKED_SIMD ? "SSE2" : "scalar only");
+	printf("%-22s %12s %12s %7s %14s %14s %6s\n", "stream", "block bytes", "packed bytes", "ratio", "block samp/s", "packed samp/s", "match");
+
+	std::mt19937 rng(12345);
+	int mismatches = 0;
+	for (const OFBC_Packed_Stream &info : OFBC_PACKED_STREAMS) {
+		Stream s = make_stream(info.source, n, rng);
+		std::vector<uint8_t> unpacked = write_unpacked(s);
+		std::vector<uint8_t> packed;
+		switch (info.code) {
+			case OFBC_AMBULATION_XY_THETA_PACKED:	packed = write_packed<OFBC_AMBULATION_XY_THETA_PACKED>(s); break;
+			case OFBC_ALSPT19_LIGHT_PACKED:			packed = write_packed<OFBC_ALSPT19_LIGHT_PACKED>(s); break;
+			case OFBC_POKE_BITMASK_PACKED:			packed = write_packed<OFBC_POKE_BITMASK_PACKED>(s); break;
+			case OFBC_CAPSENSE_VALUE_PACKED:		packed = write_packed<OFBC_CAPSENSE_VALUE_PACKED>(s); break;
+		}
+
+		std::vector<uint32_t> times_a(n), times_b(n);
+		std::vector<int32_t> values_a(3 * n), values_b(3 * n);
+		size_t got_a = 0, got_b = 0;
+		double secs_a = time_per_call([&]() { got_a = read_unpacked(unpacked, info.source, times_a.data(), values_a.data(), n); });
+		double secs_b = time_per_call([&]() { got_b = read_packed(packed, info.code, times_b.data(), values_b.data(), n); });
+
+		bool match = got_a == n && got_b == n;
+		for (size_t i = 0; match && i < n; i++) {
+			uint32_t t = times_b[i];
+			if (info.source == OFBC_CAPSENSE_VALUE || info.source == OFBC_POKE_BITMASK) {
+				t = float_micros((float) t);
+			}
+			match = times_a[i] == t;
+			for (uint8_t c = 0; match && c < info.channels; c++) {
+				match = values_a[c * n + i] == values_b[c * n + i];
+			}
+		}
+		mismatches += !match;
+		printf("%-22s %12zu %12zu %6.1fx %14.3g %14.3g %6s\n", ofbc_block_name(info.source), unpacked.size(), packed.size(),
+			(double) unpacked.size() / (double) packed.size(), n / secs_a, n / secs_b, match ? "yes" : "NO");
+	}
+	return mismatches ? 1 : 0;
+}
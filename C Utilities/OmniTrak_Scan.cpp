@@ -0,0 +1,133 @@
+/*
+	OmniTrak_Scan.cpp
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Parallel Scanner
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Scans an *.OmniTrak file on every core (see OmniTrak_File_Parallel.h),
+	printing the block count, the number of blocks of each code, and every
+	unreadable stretch that was skipped. With --verify, the file is also
+	walked sequentially and the two results are compared.
+
+		OmniTrak_Scan -j 8 --verify session.OmniTrak
+
+	Build:
+		g++ -std=c++17 -O2 -pthread -I"../C Libraries" OmniTrak_Scan.cpp -o OmniTrak_Scan
+
+	Requires C++17.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "OmniTrak_File_Parallel.h"
+
+
+static void usage()
+{
+	fprintf(stderr, "usage: OmniTrak_Scan [-j threads] [--chunk MB] [--verify] file.OmniTrak\n");
+	exit(2);
+}
+
+//Walks the file sequentially and checks that it finds the same blocks and gaps as the parallel scan.
+static bool verify(const uint8_t *data, uint64_t size, const OmniTrak_Parallel_Parser &parser, const std::vector<uint64_t> &offsets)
+{
+	uint64_t blocks = 0;
+	size_t gap = 0;
+	bool ok = true;
+	OmniTrak_Walk_Step step;
+	for (uint64_t pos = OFBC_FILE_HEADER_SIZE; pos < size && ok; pos = step.next) {
+		omnitrak_walk_step(data, size, pos, step);
+		if (step.is_block) {
+			ok = blocks < offsets.size() && offsets[blocks] == pos;
+			blocks++;
+		}
+		else {
+			ok = gap < parser.gaps().size() && parser.gaps()[gap].start == step.gap.start && parser.gaps()[gap].end == step.gap.end;
+			gap++;
+		}
+	}
+	return ok && blocks == offsets.size() && gap == parser.gaps().size();
+}
+
+int main(int argc, char **argv)
+{
+	unsigned threads = 0;
+	uint64_t chunk_size = OMNITRAK_CHUNK_SIZE;
+	bool check = false;
+	const char *path = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			threads = (unsigned) atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--chunk") && i + 1 < argc) {
+			chunk_size = (uint64_t) atof(argv[++i]) * (1 << 20);
+		}
+		else if (!strcmp(argv[i], "--verify")) {
+			check = true;
+		}
+		else if (argv[i][0] == '-' || path) {
+			usage();
+		}
+		else {
+			path = argv[i];
+		}
+	}
+	if (!path) {
+		usage();
+	}
+
+	OmniTrak_File_Map map;
+	if (!map.open(path)) {
+		fprintf(stderr, "%s\n", map.error().c_str());
+		return 1;
+	}
+	OmniTrak_Thread_Pool pool(threads);
+	OmniTrak_Parallel_Parser parser;
+	auto t0 = std::chrono::steady_clock::now();
+	if (!parser.scan(map.data(), map.size(), pool, chunk_size)) {
+		fprintf(stderr, "%s: %s\n", path, omnitrak_read_status_string(OMNITRAK_READ_BAD_HEADER));
+		return 1;
+	}
+	std::vector<std::atomic<uint64_t>> counts(65536);
+	std::vector<std::vector<uint64_t>> offsets(check ? parser.chunks().size() : 0);
+	parser.decode(pool, [&](size_t chunk, const OmniTrak_Block_View &blk) {
+		counts[blk.code].fetch_add(1, std::memory_order_relaxed);
+		if (check) {
+			offsets[chunk].push_back(blk.offset);
+		}
+	});
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	printf("%s: %llu blocks in %.3f s (%.0f MB/s, %zu threads), %zu gaps, %llu bytes re-walked\n", path,
+		(unsigned long long) parser.blocks(), secs, map.size() / secs / 1e6, pool.size(), parser.gaps().size(),
+		(unsigned long long) parser.respeculated_bytes());
+	for (uint32_t code = 0; code < counts.size(); code++) {
+		if (counts[code] > 0) {
+			printf("  0x%04X %-32s %llu\n", code, ofbc_block_name((uint16_t) code), (unsigned long long) counts[code].load());
+		}
+	}
+	for (const OmniTrak_Parse_Gap &gap : parser.gaps()) {
+		printf("  gap %llu-%llu (%llu bytes): code 0x%04X, %s\n", (unsigned long long) gap.start, (unsigned long long) gap.end,
+			(unsigned long long) (gap.end - gap.start), gap.code, omnitrak_read_status_string(gap.status));
+	}
+
+	if (check) {
+		std::vector<uint64_t> all;
+		for (const std::vector<uint64_t> &chunk : offsets) {
+			all.insert(all.end(), chunk.begin(), chunk.end());
+		}
+		bool ok = verify(map.data(), map.size(), parser, all);
+		printf("sequential check: %s\n", ok ? "identical" : "MISMATCH");
+		return ok ? 0 : 1;
+	}
+	return 0;
+}
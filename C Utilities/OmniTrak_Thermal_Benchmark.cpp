@@ -0,0 +1,110 @@
+/*
+	OmniTrak_Thermal_Benchmark.cpp
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Thermal Decoder Benchmark
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Measures the throughput, in frames per second, of the thermal frame
+	decoders in OmniTrak_File_Thermal.h against the scalar reference decoder
+	on synthetic frames, and checks that both produce the same pixels.
+
+		OmniTrak_Thermal_Benchmark [frames per format]
+
+	Build (vectorized; drop -mavx2 for SSE4.1, or add -DOFBC_THERMAL_NO_SIMD for scalar only):
+		g++ -std=c++17 -O2 -mavx2 -I"../C Libraries" OmniTrak_Thermal_Benchmark.cpp -o OmniTrak_Thermal_Benchmark
+
+	Requires C++17.
+*/
+
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "OmniTrak_File_Thermal.h"
+
+
+//Seconds per call of "fn", repeated until at least "min_seconds" have passed.
+template <typename Fn> static double time_per_call(Fn fn, double min_seconds = 0.5)
+{
+	using clock = std::chrono::steady_clock;
+	size_t calls = 0;
+	clock::time_point start = clock::now();
+	double elapsed = 0;
+	do {
+		fn();
+		calls++;
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (elapsed < min_seconds);
+	return elapsed / calls;
+}
+
+
+int main(int argc, char **argv)
+{
+	size_t num_frames = (argc > 1) ? (size_t) atol(argv[1]) : 4096;
+	if (num_frames == 0) {
+		fprintf(stderr, "Usage: OmniTrak_Thermal_Benchmark [frames per format]\n");
+		return 2;
+	}
+	printf("Decoder: %s\n", OFBC_THERMAL_SIMD == 2 ? "AVX2" : (OFBC_THERMAL_SIMD == 1 ? "SSE4.1" : "scalar only"));
+	printf("%-28s %14s %14s %8s %10s\n", "block", "scalar fr/s", "decoder fr/s", "speedup", "max diff");
+
+	std::mt19937 rng(12345);
+	int mismatches = 0;
+	for (const OFBC_Thermal_Format &f : OFBC_THERMAL_FORMATS) {
+		size_t payload_size = (size_t) ofbc_fixed_payload_size(f.code);
+		size_t pixels = (size_t) f.width * f.height;
+
+		//Random payloads, with plausible values for float formats so the comparison is meaningful.
+		std::vector<uint8_t> payloads(num_frames * payload_size);
+		std::uniform_int_distribution<int> byte(0, 255);
+		std::uniform_real_distribution<float> celsius(15.0f, 40.0f);
+		for (size_t k = 0; k < num_frames; k++) {
+			uint8_t *p = payloads.data() + k * payload_size;
+			for (size_t i = 0; i < payload_size; i++) {
+				p[i] = (uint8_t) byte(rng);
+			}
+			if (f.encoding == OFBC_THERMAL_F32) {
+				for (size_t i = 0; i < pixels; i++) {
+					float v = celsius(rng);
+					memcpy(p + OFBC_THERMAL_PIXEL_OFFSET + 4 * i, &v, 4);
+				}
+			}
+		}
+		std::vector<const uint8_t *> ptrs(num_frames);
+		for (size_t k = 0; k < num_frames; k++) {
+			ptrs[k] = payloads.data() + k * payload_size;
+		}
+
+		std::vector<float> ref(num_frames * pixels), out(num_frames * pixels);
+		std::vector<uint32_t> millis(num_frames);
+		double t_ref = time_per_call([&]() {
+			ofbc_decode_thermal_frames_scalar(f.code, ptrs.data(), num_frames, ref.data(), millis.data());
+		});
+		double t_out = time_per_call([&]() {
+			ofbc_decode_thermal_frames(f.code, ptrs.data(), num_frames, out.data(), millis.data());
+		});
+
+		double max_diff = 0;
+		for (size_t i = 0; i < ref.size(); i++) {
+			max_diff = fmax(max_diff, fabs((double) ref[i] - out[i]));
+		}
+		if (max_diff > 1e-4) {
+			mismatches++;
+		}
+		printf("%-28s %14.0f %14.0f %7.2fx %10.2g\n", ofbc_block_name(f.code),
+			num_frames / t_ref, num_frames / t_out, t_ref / t_out, max_diff);
+	}
+	if (mismatches) {
+		printf("ERROR: %d decoder(s) disagree with the scalar reference.\n", mismatches);
+		return 1;
+	}
+	return 0;
+}
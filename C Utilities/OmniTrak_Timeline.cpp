@@ -0,0 +1,177 @@
+/*
+	OmniTrak_Timeline.cpp
+
+	Vulintus, Inc.
+
+	OmniTrak File Format Multi-File Timeline
+
+	Library documentation:
+	https://github.com/Vulintus/OmniTrak_File_Format
+
+	Puts every timestamped block from one or more *.OmniTrak files on a
+	common clock (see OmniTrak_File_Clock.h) and prints them as one
+	time-ordered CSV: the UTC serial date number, the file, the block
+	offset, and the block name. Blocks timed only by a device clock that
+	has no sync points are left out and counted.
+
+		OmniTrak_Timeline --summary rig1.OmniTrak rig2.OmniTrak > timeline.csv
+
+	--self-test checks the clock unwrapping against known rollover orders.
+
+	Build:
+		g++ -std=c++17 -O2 -I"../C Libraries" OmniTrak_Timeline.cpp -o OmniTrak_Timeline
+
+	Requires C++17.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "OmniTrak_File_Clock.h"
+
+
+//The timestamped blocks of one file.
+struct Timeline_File {
+	const char *path;
+	OmniTrak_File_Map map;
+	OmniTrak_Time_Base clock;
+	std::vector<uint64_t> offsets;
+	std::vector<uint16_t> codes;
+	std::vector<double> utc;
+	size_t unsynced = 0;
+};
+
+static bool load(Timeline_File &f)
+{
+	if (!f.map.open(f.path)) {
+		fprintf(stderr, "%s\n", f.map.error().c_str());
+		return false;
+	}
+	if (!f.clock.build(f.map.data(), f.map.size())) {
+		fprintf(stderr, "%s: %s\n", f.path, omnitrak_read_status_string(f.clock.status()));
+		return false;
+	}
+
+	//Gather the raw timestamps by clock, then convert each clock's column in one call.
+	std::vector<uint32_t> raw[2];
+	std::vector<uint64_t> raw_offsets[2];
+	std::vector<size_t> raw_rows[2];
+	OmniTrak_Block_Reader reader(f.map.data(), f.map.size());
+	OmniTrak_Block_View blk;
+	while (reader.next(blk)) {
+		OFBC_Timestamp ts = ofbc_block_timestamp(blk.code, blk.payload, blk.payload_size);
+		if (ts.type == OFBC_TIME_NONE || ts.type == OFBC_TIME_MICROS_FL) {
+			continue;
+		}
+		f.offsets.push_back(blk.offset);
+		f.codes.push_back(blk.code);
+		f.utc.push_back(f.clock.local_to_utc(ts.value));
+		if (ts.type != OFBC_TIME_DATENUM) {
+			int c = (ts.type == OFBC_TIME_MILLIS) ? OMNITRAK_CLOCK_MILLIS : OMNITRAK_CLOCK_MICROS;
+			raw[c].push_back((uint32_t) ts.value);
+			raw_offsets[c].push_back(blk.offset);
+			raw_rows[c].push_back(f.utc.size() - 1);
+		}
+	}
+	for (int c = 0; c < 2; c++) {
+		size_t n = raw[c].size();
+		std::vector<int64_t> ticks(n);
+		std::vector<double> utc(n);
+		f.clock.unwrap((OmniTrak_Clock) c, raw[c].data(), raw_offsets[c].data(), n, ticks.data());
+		f.clock.to_datenum((OmniTrak_Clock) c, ticks.data(), n, utc.data(), true);
+		for (size_t i = 0; i < n; i++) {
+			f.utc[raw_rows[c][i]] = utc[i];
+			f.unsynced += isnan(utc[i]);
+		}
+	}
+	return true;
+}
+
+//One step of a clock rollover check: a timestamp (or a rollover marker) and the epoch it should unwrap into.
+struct Rollover_Step {
+	bool marker;
+	uint32_t t;
+	uint32_t epoch;
+};
+
+//Runs OmniTrak_Clock_Track over each known rollover order, printing any step that unwraps wrongly.
+static int self_test()
+{
+	static const std::vector<std::vector<Rollover_Step>> cases = {
+		{{0, 0xFFFFFF00, 0}, {0, 0x10, 1}, {1, 0, 0}, {0, 0x20, 1}},                         // Rollover seen in the timestamps, then its marker.
+		{{0, 0xFFFFFF00, 0}, {1, 0, 0}, {0, 0x10, 1}, {0, 0x20, 1}},                         // Marker, then the wrapped timestamps.
+		{{0, 0xFFFFFF00, 0}, {1, 0, 0}, {0, 0xFFFFFF05, 0}, {0, 0x10, 1}, {0, 0x20, 1}},     // A block stamped before the marked rollover.
+		{{0, 0xFFFFFF00, 0}, {0, 0x10, 1}, {1, 0, 0}, {0, 0xFFFFFF05, 0}, {0, 0x20, 1}},     // ...or after the marker follows the wrap.
+		{{0, 0x10, 0}, {1, 0, 0}, {0, 0x20, 1}, {1, 0, 0}, {0, 0x30, 2}},                    // Rollovers hidden by long gaps.
+	};
+	int failures = 0;
+	for (size_t c = 0; c < cases.size(); c++) {
+		OmniTrak_Clock_Track track;
+		uint64_t offset = 0;
+		for (const Rollover_Step &step : cases[c]) {
+			offset++;
+			if (step.marker) {
+				track.marker();
+				continue;
+			}
+			int64_t ticks = track.sample(step.t, offset);
+			int64_t expect = ((int64_t) step.epoch << 32) + step.t;
+			if (ticks != expect || track.epoch_at(offset) != step.epoch) {
+				fprintf(stderr, "case %zu, 0x%08X: unwrapped to epoch %lld (epoch_at %u), expected %u\n", c + 1, step.t,
+					(long long) (ticks >> 32), track.epoch_at(offset), step.epoch);
+				failures++;
+			}
+		}
+	}
+	fprintf(stderr, "%zu rollover cases, %d failure(s).\n", cases.size(), failures);
+	return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	bool summary = false;
+	std::vector<Timeline_File> files;
+	files.reserve(argc);
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--summary")) {
+			summary = true;
+		}
+		else if (!strcmp(argv[i], "--self-test")) {
+			return self_test();
+		}
+		else {
+			files.emplace_back();
+			files.back().path = argv[i];
+		}
+	}
+	if (files.empty()) {
+		fprintf(stderr, "usage: OmniTrak_Timeline [--summary] file.OmniTrak [file.OmniTrak ...]\n       OmniTrak_Timeline --self-test\n");
+		return 2;
+	}
+
+	std::vector<OmniTrak_Timeline_Source> sources;
+	for (Timeline_File &f : files) {
+		if (!load(f)) {
+			return 1;
+		}
+		sources.push_back({f.utc.data(), f.utc.size()});
+	}
+	std::vector<OmniTrak_Timeline_Event> events;
+	omnitrak_merge_timelines(sources, events);
+
+	printf("utc_datenum,file,offset,block\n");
+	for (const OmniTrak_Timeline_Event &e : events) {
+		const Timeline_File &f = files[e.source];
+		printf("%.10f,%s,%llu,%s\n", e.time, f.path, (unsigned long long) f.offsets[e.index], ofbc_block_name(f.codes[e.index]));
+	}
+	if (summary) {
+		for (const Timeline_File &f : files) {
+			fprintf(stderr, "%s: %zu ms / %zu us sync points, %zu ms / %zu us rollovers, time zone %s, %zu blocks without a sync\n",
+				f.path, f.clock.sync_points(OMNITRAK_CLOCK_MILLIS).size(), f.clock.sync_points(OMNITRAK_CLOCK_MICROS).size(),
+				f.clock.track(OMNITRAK_CLOCK_MILLIS).epoch_starts().size(), f.clock.track(OMNITRAK_CLOCK_MICROS).epoch_starts().size(),
+				f.clock.has_time_zone() ? "set" : "not set (UTC = local)", f.unsynced);
+		}
+	}
+	return 0;
+}
@@ -42,8 +42,9 @@ ofbc('ORIGINAL_FILENAME') = 40;                       %The original filename for
 ofbc('RENAMED_FILE') = 41;                            %A timestamped event to indicate when a file has been renamed by one of Vulintus' automatic data organizing programs.
 ofbc('DOWNLOAD_TIME') = 42;                           %A timestamp indicating when the data file was downloaded from the OmniTrak device to a computer.
 ofbc('DOWNLOAD_SYSTEM') = 43;                         %The computer system name and the COM port used to download the data file form the OmniTrak device.
+ofbc('METADATA_TRAILER') = 44;                        %Frames the file metadata blocks (ORIGINAL_FILENAME, RENAMED_FILE, DOWNLOAD_TIME, DOWNLOAD_SYSTEM) appended as a trailer at the end of the file, so they can be found with one read from the end.
 
-ofbc('INCOMPLETE_BLOCK') = 50;                        %Indicates that the file will end in an incomplete block.
+ofbc('INCOMPLETE_BLOCK') = 50;                        %Marks the next block as split across two device writes, giving its code and start and end bytes; a file that ends inside that block was cut off between the writes.
 
 ofbc('USER_TIME') = 60;                               %Date/time values from a user-set timestamp.
 
@@ -120,6 +121,7 @@ ofbc('MLX90640_ENABLED') = 1008;                      %Indicates that an MLX9064
 ofbc('ZMOD4410_ENABLED') = 1009;                      %Indicates that an ZMOD4410 VOC/eC02 sensor is present in the system.
 
 ofbc('AMBULATION_XY_THETA') = 1024;                   %A point in a tracked ambulation path, with absolute x- and y-coordinates in millimeters, with facing direction theta, in degrees.
+ofbc('AMBULATION_XY_THETA_PACKED') = 1025;            %A batch of tracked ambulation path points (see AMBULATION_XY_THETA), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
 
 ofbc('AMG8833_THERM_CONV') = 1100;                    %The conversion factor, in degrees Celsius, for converting 16-bit integer AMG8833 pixel readings to temperature.
 ofbc('AMG8833_THERM_FL') = 1101;                      %The current AMG8833 thermistor reading as a converted float32 value, in Celsius.
@@ -175,6 +177,7 @@ ofbc('MLX90640_IM_WRITE_TIME') = 1522;                %The SD card write time fo
 ofbc('MLX90640_INT_WRITE_TIME') = 1523;               %The SD card write time for the MLX90640 raw uint16 data.
 
 ofbc('ALSPT19_LIGHT') = 1600;                         %The current analog value of the ALS-PT19 ambient light sensor, as an unsigned integer ADC value.
+ofbc('ALSPT19_LIGHT_PACKED') = 1601;                  %A batch of ALS-PT19 ambient light sensor ADC values (see ALSPT19_LIGHT), packed as delta-of-delta millisecond timestamps and bit-packed value deltas.
 
 ofbc('ZMOD4410_MOX_BOUND') = 1700;                    %The current lower and upper bounds for the ZMOD4410 ADC reading used in calculations.
 ofbc('ZMOD4410_CONFIG_PARAMS') = 1701;                %Current configuration values for the ZMOD4410.
@@ -242,9 +245,11 @@ ofbc('MOTOTRAK_V3P0_OUTCOME') = 2500;                 %MotoTrak version 3.0 tria
 ofbc('MOTOTRAK_V3P0_SIGNAL') = 2501;                  %MotoTrak version 3.0 trial stream signal.
 
 ofbc('POKE_BITMASK') = 2560;                          %Nosepoke status bitmask, typically written only when it changes.
+ofbc('POKE_BITMASK_PACKED') = 2561;                   %A batch of nosepoke status bitmasks (see POKE_BITMASK), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
 
 ofbc('CAPSENSE_BITMASK') = 2576;                      %Capacitive sensor status bitmask, typically written only when it changes.
 ofbc('CAPSENSE_VALUE') = 2577;                        %Capacitive sensor reading for one sensor, in ADC ticks or clock cycles.
+ofbc('CAPSENSE_VALUE_PACKED') = 2578;                 %A batch of capacitive sensor readings for one sensor (see CAPSENSE_VALUE), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
 
 ofbc('OUTPUT_TRIGGER_NAME') = 2600;                   %Name/description of the output trigger type for the given index.
 
@@ -0,0 +1,18 @@
+function data = OmniTrakFileRead_ReadBlock_ALSPT19_LIGHT_PACKED(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		1601
+%		ALSPT19_LIGHT_PACKED
+
+batch = OmniTrakFileRead_Read_Packed_Batch(fid,86400e3);                    %Read in the batch (millisecond timestamps).
+
+if ~isfield(data,'amb')                                                     %If the structure doesn't yet have an "amb" field..
+    data.amb = [];                                                          %Create the field.
+end
+for j = 1:numel(batch.times)                                                %Step through each reading in the batch.
+    i = length(data.amb) + 1;                                               %Grab a new ambient light reading index.
+    data.amb(i).src = 'ALSPT19';                                            %Save the source of the ambient light reading.
+    data.amb(i).id = batch.id;                                              %Save the ambient light sensor index.
+    data.amb(i).time = batch.times(j);                                      %Save the millisecond clock timestamp for the reading.
+    data.amb(i).int = batch.values(j,1);                                    %Save the ambient light reading as an unsigned 16-bit value.
+end
\ No newline at end of file
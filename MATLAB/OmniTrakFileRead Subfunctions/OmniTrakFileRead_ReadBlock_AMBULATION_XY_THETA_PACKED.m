@@ -0,0 +1,23 @@
+function data = OmniTrakFileRead_ReadBlock_AMBULATION_XY_THETA_PACKED(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		1025
+%		AMBULATION_XY_THETA_PACKED
+
+batch = OmniTrakFileRead_Read_Packed_Batch(fid,86400e6);                    %Read in the batch (microsecond timestamps).
+
+data = OmniTrakFileRead_Check_Field_Name(data,'ambulation',...
+    {'path_xy','orientation','micros'});                                    %Call the subfunction to check for existing fieldnames.
+xy_theta = typecast(int32(batch.values(:)),'single');                       %The values are float32 bit patterns.
+xy_theta = reshape(double(xy_theta),[],3);                                  %Columns of x, y, and theta.
+
+if isempty(data.ambulation.micros)                                          %If these are the first samples...
+    data.ambulation.micros = batch.times;                                   %Microcontroller microsecond clock timestamps.
+    data.ambulation.path_xy = xy_theta(:,1:2);                              %x- and y-coordinates, in millimeters.
+    data.ambulation.orientation = xy_theta(:,3);                            %Animal overhead orientation, in degrees.
+else                                                                        %Otherwise...
+    i = size(data.ambulation.micros,1) + (1:numel(batch.times))';           %Grab new ambulation path sample indices.
+    data.ambulation.micros(i,1) = batch.times;                              %Microcontroller microsecond clock timestamps.
+    data.ambulation.path_xy(i,1:2) = xy_theta(:,1:2);                       %x- and y-coordinates, in millimeters.
+    data.ambulation.orientation(i,1) = xy_theta(:,3);                       %Animal overhead orientation, in degrees.
+end
\ No newline at end of file
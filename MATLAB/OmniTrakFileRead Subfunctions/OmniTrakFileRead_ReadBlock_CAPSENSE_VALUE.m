@@ -46,7 +46,7 @@ sensor_index = fread(fid,1,'uint8');                                        %Rea
 sensor_val = fread(fid,1,'uint16');                                         %Read the sensor value.
 j = size(data.capsense.value,1) + 1;                                        %Find the next value index.
 if j == 1                                                                   %If this is the first value reading...
-    data.capsense.status = [sensor_index, sensor_val, i];                   %Create the status matrix.
+    data.capsense.value = [sensor_index, sensor_val, i];                    %Create the value matrix.
 else                                                                        %Otherwise...
-    data.capsense.status(j,:) = [sensor_index, sensor_val, i];              %Add the new status to the matrix.
+    data.capsense.value(j,:) = [sensor_index, sensor_val, i];               %Add the new value to the matrix.
 end
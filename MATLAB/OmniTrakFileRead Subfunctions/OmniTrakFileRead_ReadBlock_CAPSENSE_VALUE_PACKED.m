@@ -0,0 +1,34 @@
+function data = OmniTrakFileRead_ReadBlock_CAPSENSE_VALUE_PACKED(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		2578
+%		CAPSENSE_VALUE_PACKED
+
+batch = OmniTrakFileRead_Read_Packed_Batch(fid,86400e6);                    %Read in the batch (microsecond timestamps).
+
+data = OmniTrakFileRead_Check_Field_Name(data,'capsense',...
+    {'datenum','micros','status','value'});                                 %Call the subfunction to check for existing fieldnames.
+num_sensors = max(batch.values(:,1));                                       %Grab the largest number of sensors.
+N = numel(batch.times);                                                     %Number of samples in the batch.
+status = bitget(repmat(batch.values(:,2),1,num_sensors),...
+    repmat(1:num_sensors,N,1));                                             %Grab the status of each sensor.
+
+if isempty(data.capsense.datenum)                                           %If these are the first readings...
+    i = (1:N)';                                                             %Indices of the new readings.
+    data.capsense.datenum = batch.datenum;                                  %Save the serial date number timestamps.
+    data.capsense.micros = batch.times;                                     %Save the microcontroller microsecond timestamps.
+    data.capsense.status = status;                                          %Create the status matrix.
+else                                                                        %Otherwise...
+    i = size(data.capsense.datenum,1) + (1:N)';                             %Find the next indices.
+    data.capsense.datenum(i,1) = batch.datenum;                             %Save the serial date number timestamps.
+    data.capsense.micros(i,1) = batch.times;                                %Save the microcontroller microsecond timestamps.
+    data.capsense.status(i,1:num_sensors) = status;                         %Add the new status to the matrix.
+end
+
+values = [repmat(batch.id,N,1), batch.values(:,3), i];                      %Sensor index, sensor value, and reading index.
+if isempty(data.capsense.value)                                             %If these are the first values...
+    data.capsense.value = values;                                           %Create the value matrix.
+else                                                                        %Otherwise...
+    j = size(data.capsense.value,1) + (1:N)';                               %Find the next value indices.
+    data.capsense.value(j,:) = values;                                      %Add the new values to the matrix.
+end
\ No newline at end of file
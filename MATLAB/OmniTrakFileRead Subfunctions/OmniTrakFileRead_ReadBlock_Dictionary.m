@@ -84,8 +84,11 @@ block_read(42) = struct('def_name', 'DOWNLOAD_TIME', 'fcn', @(data)OmniTrakFileR
 % The computer system name and the COM port used to download the data file form the OmniTrak device.
 block_read(43) = struct('def_name', 'DOWNLOAD_SYSTEM', 'fcn', @(data)OmniTrakFileRead_ReadBlock_DOWNLOAD_SYSTEM(fid,data));
 
+% Frames the file metadata blocks (ORIGINAL_FILENAME, RENAMED_FILE, DOWNLOAD_TIME, DOWNLOAD_SYSTEM) appended as a trailer at the end of the file, so they can be found with one read from the end.
+block_read(44) = struct('def_name', 'METADATA_TRAILER', 'fcn', @(data)OmniTrakFileRead_ReadBlock_METADATA_TRAILER(fid,data));
 
-% Indicates that the file will end in an incomplete block.
+
+% Marks the next block as split across two device writes, giving its code and start and end bytes; a file that ends inside that block was cut off between the writes.
 block_read(50) = struct('def_name', 'INCOMPLETE_BLOCK', 'fcn', @(data)OmniTrakFileRead_ReadBlock_INCOMPLETE_BLOCK(fid,data));
 
 
@@ -286,6 +289,10 @@ block_read(1009) = struct('def_name', 'ZMOD4410_ENABLED', 'fcn', @(data)OmniTrak
 block_read(1024) = struct('def_name', 'AMBULATION_XY_THETA', 'fcn', @(data)OmniTrakFileRead_ReadBlock_AMBULATION_XY_THETA(fid,data));
 
 
+% A batch of tracked ambulation path points (see AMBULATION_XY_THETA), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
+block_read(1025) = struct('def_name', 'AMBULATION_XY_THETA_PACKED', 'fcn', @(data)OmniTrakFileRead_ReadBlock_AMBULATION_XY_THETA_PACKED(fid,data));
+
+
 % The conversion factor, in degrees Celsius, for converting 16-bit integer AMG8833 pixel readings to temperature.
 block_read(1100) = struct('def_name', 'AMG8833_THERM_CONV', 'fcn', @(data)OmniTrakFileRead_ReadBlock_AMG8833_THERM_CONV(fid,data));
 
@@ -421,6 +428,10 @@ block_read(1523) = struct('def_name', 'MLX90640_INT_WRITE_TIME', 'fcn', @(data)O
 block_read(1600) = struct('def_name', 'ALSPT19_LIGHT', 'fcn', @(data)OmniTrakFileRead_ReadBlock_ALSPT19_LIGHT(fid,data));
 
 
+% A batch of ALS-PT19 ambient light sensor ADC values (see ALSPT19_LIGHT), packed as delta-of-delta millisecond timestamps and bit-packed value deltas.
+block_read(1601) = struct('def_name', 'ALSPT19_LIGHT_PACKED', 'fcn', @(data)OmniTrakFileRead_ReadBlock_ALSPT19_LIGHT_PACKED(fid,data));
+
+
 % The current lower and upper bounds for the ZMOD4410 ADC reading used in calculations.
 block_read(1700) = struct('def_name', 'ZMOD4410_MOX_BOUND', 'fcn', @(data)OmniTrakFileRead_ReadBlock_ZMOD4410_MOX_BOUND(fid,data));
 
@@ -590,6 +601,10 @@ block_read(2501) = struct('def_name', 'MOTOTRAK_V3P0_SIGNAL', 'fcn', @(data)Omni
 block_read(2560) = struct('def_name', 'POKE_BITMASK', 'fcn', @(data)OmniTrakFileRead_ReadBlock_POKE_BITMASK(fid,data));
 
 
+% A batch of nosepoke status bitmasks (see POKE_BITMASK), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
+block_read(2561) = struct('def_name', 'POKE_BITMASK_PACKED', 'fcn', @(data)OmniTrakFileRead_ReadBlock_POKE_BITMASK_PACKED(fid,data));
+
+
 % Capacitive sensor status bitmask, typically written only when it changes.
 block_read(2576) = struct('def_name', 'CAPSENSE_BITMASK', 'fcn', @(data)OmniTrakFileRead_ReadBlock_CAPSENSE_BITMASK(fid,data));
 
@@ -597,6 +612,10 @@ block_read(2576) = struct('def_name', 'CAPSENSE_BITMASK', 'fcn', @(data)OmniTrak
 block_read(2577) = struct('def_name', 'CAPSENSE_VALUE', 'fcn', @(data)OmniTrakFileRead_ReadBlock_CAPSENSE_VALUE(fid,data));
 
 
+% A batch of capacitive sensor readings for one sensor (see CAPSENSE_VALUE), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
+block_read(2578) = struct('def_name', 'CAPSENSE_VALUE_PACKED', 'fcn', @(data)OmniTrakFileRead_ReadBlock_CAPSENSE_VALUE_PACKED(fid,data));
+
+
 % Name/description of the output trigger type for the given index.
 block_read(2600) = struct('def_name', 'OUTPUT_TRIGGER_NAME', 'fcn', @(data)OmniTrakFileRead_ReadBlock_OUTPUT_TRIGGER_NAME(fid,data));
 
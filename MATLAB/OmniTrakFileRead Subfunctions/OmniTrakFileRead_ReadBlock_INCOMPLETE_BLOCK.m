@@ -4,4 +4,5 @@ function data = OmniTrakFileRead_ReadBlock_INCOMPLETE_BLOCK(fid,data)
 %		50
 %		INCOMPLETE_BLOCK
 
-fprintf(1,'Need to finish coding for Block 50: INCOMPLETE_BLOCK');
\ No newline at end of file
+fread(fid,1,'uint16');                                                      %Skip the code of the block that was split across two writes.
+fread(fid,2,'uint32');                                                      %Skip that block's start and end byte offsets.
\ No newline at end of file
@@ -0,0 +1,10 @@
+function data = OmniTrakFileRead_ReadBlock_METADATA_TRAILER(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		44
+%		METADATA_TRAILER
+
+fread(fid,2,'uint8');                                                       %Skip the trailer version and block count.
+fread(fid,1,'uint32');                                                      %Skip the number of trailer bytes.
+fread(fid,1,'uint64');                                                      %Skip the offset of the previous trailer.
+fread(fid,1,'uint32');                                                      %Skip the trailer checksum.
\ No newline at end of file
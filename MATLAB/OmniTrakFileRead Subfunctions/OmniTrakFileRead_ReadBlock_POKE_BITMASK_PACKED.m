@@ -0,0 +1,25 @@
+function data = OmniTrakFileRead_ReadBlock_POKE_BITMASK_PACKED(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		2561
+%		POKE_BITMASK_PACKED
+
+batch = OmniTrakFileRead_Read_Packed_Batch(fid,86400e6);                    %Read in the batch (microsecond timestamps).
+
+data = OmniTrakFileRead_Check_Field_Name(data,'poke',...
+    {'datenum','micros','status'});                                         %Call the subfunction to check for existing fieldnames.
+num_sensors = max(batch.values(:,1));                                       %Grab the largest number of sensors.
+N = numel(batch.times);                                                     %Number of samples in the batch.
+status = bitget(repmat(batch.values(:,2),1,num_sensors),...
+    repmat(1:num_sensors,N,1));                                             %Grab the status of each nosepoke.
+
+if isempty(data.poke.datenum)                                               %If these are the first bitmask readings...
+    data.poke.datenum = batch.datenum;                                      %Save the serial date number timestamps.
+    data.poke.micros = batch.times;                                         %Save the microcontroller microsecond timestamps.
+    data.poke.status = status;                                              %Create the status matrix.
+else                                                                        %Otherwise...
+    i = size(data.poke.datenum,1) + (1:N)';                                 %Find the next indices.
+    data.poke.datenum(i,1) = batch.datenum;                                 %Save the serial date number timestamps.
+    data.poke.micros(i,1) = batch.times;                                    %Save the microcontroller microsecond timestamps.
+    data.poke.status(i,1:num_sensors) = status;                             %Add the new status to the matrix.
+end
\ No newline at end of file
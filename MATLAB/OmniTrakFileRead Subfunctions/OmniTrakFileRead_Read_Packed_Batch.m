@@ -0,0 +1,58 @@
+function batch = OmniTrakFileRead_Read_Packed_Batch(fid,ticks_per_day)
+
+%
+%OmniTrakFileRead_Read_Packed_Batch.m - Vulintus, Inc.
+%
+%   OMNITRAKFILEREAD_READ_PACKED_BATCH reads and decodes the payload of a
+%   "*_PACKED" data block: a batch of samples stored as delta-of-delta
+%   clock timestamps and bit-packed value deltas. It returns the sensor
+%   index or ID, the N sample timestamps (N x 1), the values of the C
+%   channels as signed 32-bit integers (N x C), and each sample's serial
+%   date number, counted on from the first sample's at "ticks_per_day".
+%
+%   Packed fields are stored LSB-first: N-2 timestamp fields, then N-1
+%   value fields for each channel. Each field is zigzag-encoded (0, -1, 1,
+%   -2, ... -> 0, 1, 2, 3, ...) and summed onto the previous value, with
+%   timestamps wrapping like the device's 32-bit clock.
+%
+%   UPDATE LOG:
+%   2026-10-17 - Function first implemented.
+%
+
+ver = fread(fid,1,'uint8');                                                 %Packed batch version.
+if ver ~= 1                                                                 %If the batch version isn't recognized...
+    error(['ERROR IN %s: Packed batch version #%1.0f is not '...
+        'recognized!'], upper(mfilename), ver);                             %Show an error.
+end
+batch.id = fread(fid,1,'uint8');                                            %Sensor index or ID.
+C = fread(fid,1,'uint8');                                                   %Number of value channels.
+N = fread(fid,1,'uint8');                                                   %Number of samples in the batch.
+datenum0 = fread(fid,1,'float64');                                          %Serial date number of the first sample.
+time0 = fread(fid,1,'uint32');                                              %First sample's clock timestamp.
+delta0 = fread(fid,1,'int32');                                              %First timestamp delta.
+time_width = fread(fid,1,'uint8');                                          %Timestamp field width, in bits.
+value_widths = fread(fid,C,'uint8');                                        %Each channel's value field width, in bits.
+first_values = fread(fid,C,'int32');                                        %Each channel's first value.
+num_bits = max(N-2,0)*time_width + (N-1)*sum(value_widths);                 %Count the bits in the packed fields.
+packed = fread(fid,ceil(num_bits/8),'uint8');                               %Read in the packed fields.
+
+bits = bitget(repmat(packed(:)',8,1),repmat((1:8)',1,numel(packed)));       %Split the packed bytes into bits, LSB first.
+bits = bits(:);                                                             %Make the bits one continuous stream.
+unpack = @(start,width,n)(2.^(0:width-1))*...
+    reshape(bits(start + (1:width*n)),width,n);                             %Unpack n fields of the given width.
+unzigzag = @(z)floor(z/2).*(1 - 2*mod(z,2)) - mod(z,2);                     %Convert zigzag-encoded fields to signed values.
+
+bit = max(N-2,0)*time_width;                                                %Value fields start after the timestamp fields.
+dd = unzigzag(unpack(0,time_width,max(N-2,0)))';                            %Timestamp delta-of-deltas.
+deltas = delta0 + [0; cumsum(dd)];                                          %Timestamp deltas.
+times = mod(time0 + [0; cumsum(deltas)],2^32);                              %Timestamps, wrapped like the 32-bit device clock.
+batch.times = times(1:N);                                                   %Trim the extra timestamp a 1-sample batch gets.
+batch.datenum = datenum0 + mod(batch.times - time0,2^32)/ticks_per_day;     %Serial date number of each sample.
+
+batch.values = zeros(N,C);                                                  %Pre-allocate the value matrix.
+for c = 1:C                                                                 %Step through each value channel.
+    dv = unzigzag(unpack(bit,value_widths(c),N-1))';                        %Value deltas.
+    v = first_values(c) + [0; cumsum(dv)];                                  %Values, before wrapping.
+    batch.values(:,c) = mod(v + 2^31,2^32) - 2^31;                          %Wrap the values to signed 32-bit integers.
+    bit = bit + (N-1)*value_widths(c);                                      %Skip to the next channel's fields.
+end
\ No newline at end of file
@@ -280,6 +280,26 @@ data.amb(i).time = fread(fid,1,'uint32');                                   %Sav
 data.amb(i).int = fread(fid,1,'uint16');                                    %Save the ambient light reading as an unsigned 16-bit value.
 
 
+function data = OmniTrakFileRead_ReadBlock_ALSPT19_LIGHT_PACKED(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		1601
+%		ALSPT19_LIGHT_PACKED
+
+batch = OmniTrakFileRead_Read_Packed_Batch(fid,86400e3);                    %Read in the batch (millisecond timestamps).
+
+if ~isfield(data,'amb')                                                     %If the structure doesn't yet have an "amb" field..
+    data.amb = [];                                                          %Create the field.
+end
+for j = 1:numel(batch.times)                                                %Step through each reading in the batch.
+    i = length(data.amb) + 1;                                               %Grab a new ambient light reading index.
+    data.amb(i).src = 'ALSPT19';                                            %Save the source of the ambient light reading.
+    data.amb(i).id = batch.id;                                              %Save the ambient light sensor index.
+    data.amb(i).time = batch.times(j);                                      %Save the millisecond clock timestamp for the reading.
+    data.amb(i).int = batch.values(j,1);                                    %Save the ambient light reading as an unsigned 16-bit value.
+end
+
+
 function data = OmniTrakFileRead_ReadBlock_AMBULATION_XY_THETA(fid,data)
 
 %	OmniTrak File Block Code (OFBC):
@@ -313,6 +333,31 @@ switch ver                                                                  %Swi
 end
 
 
+function data = OmniTrakFileRead_ReadBlock_AMBULATION_XY_THETA_PACKED(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		1025
+%		AMBULATION_XY_THETA_PACKED
+
+batch = OmniTrakFileRead_Read_Packed_Batch(fid,86400e6);                    %Read in the batch (microsecond timestamps).
+
+data = OmniTrakFileRead_Check_Field_Name(data,'ambulation',...
+    {'path_xy','orientation','micros'});                                    %Call the subfunction to check for existing fieldnames.
+xy_theta = typecast(int32(batch.values(:)),'single');                       %The values are float32 bit patterns.
+xy_theta = reshape(double(xy_theta),[],3);                                  %Columns of x, y, and theta.
+
+if isempty(data.ambulation.micros)                                          %If these are the first samples...
+    data.ambulation.micros = batch.times;                                   %Microcontroller microsecond clock timestamps.
+    data.ambulation.path_xy = xy_theta(:,1:2);                              %x- and y-coordinates, in millimeters.
+    data.ambulation.orientation = xy_theta(:,3);                            %Animal overhead orientation, in degrees.
+else                                                                        %Otherwise...
+    i = size(data.ambulation.micros,1) + (1:numel(batch.times))';           %Grab new ambulation path sample indices.
+    data.ambulation.micros(i,1) = batch.times;                              %Microcontroller microsecond clock timestamps.
+    data.ambulation.path_xy(i,1:2) = xy_theta(:,1:2);                       %x- and y-coordinates, in millimeters.
+    data.ambulation.orientation(i,1) = xy_theta(:,3);                       %Animal overhead orientation, in degrees.
+end
+
+
 function data = OmniTrakFileRead_ReadBlock_AMG8833_ENABLED(fid,data)
 
 %	OmniTrak File Block Code (OFBC):
@@ -888,9 +933,45 @@ sensor_index = fread(fid,1,'uint8');                                        %Rea
 sensor_val = fread(fid,1,'uint16');                                         %Read the sensor value.
 j = size(data.capsense.value,1) + 1;                                        %Find the next value index.
 if j == 1                                                                   %If this is the first value reading...
-    data.capsense.status = [sensor_index, sensor_val, i];                   %Create the status matrix.
+    data.capsense.value = [sensor_index, sensor_val, i];                    %Create the value matrix.
 else                                                                        %Otherwise...
-    data.capsense.status(j,:) = [sensor_index, sensor_val, i];              %Add the new status to the matrix.
+    data.capsense.value(j,:) = [sensor_index, sensor_val, i];               %Add the new value to the matrix.
+end
+
+
+function data = OmniTrakFileRead_ReadBlock_CAPSENSE_VALUE_PACKED(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		2578
+%		CAPSENSE_VALUE_PACKED
+
+batch = OmniTrakFileRead_Read_Packed_Batch(fid,86400e6);                    %Read in the batch (microsecond timestamps).
+
+data = OmniTrakFileRead_Check_Field_Name(data,'capsense',...
+    {'datenum','micros','status','value'});                                 %Call the subfunction to check for existing fieldnames.
+num_sensors = max(batch.values(:,1));                                       %Grab the largest number of sensors.
+N = numel(batch.times);                                                     %Number of samples in the batch.
+status = bitget(repmat(batch.values(:,2),1,num_sensors),...
+    repmat(1:num_sensors,N,1));                                             %Grab the status of each sensor.
+
+if isempty(data.capsense.datenum)                                           %If these are the first readings...
+    i = (1:N)';                                                             %Indices of the new readings.
+    data.capsense.datenum = batch.datenum;                                  %Save the serial date number timestamps.
+    data.capsense.micros = batch.times;                                     %Save the microcontroller microsecond timestamps.
+    data.capsense.status = status;                                          %Create the status matrix.
+else                                                                        %Otherwise...
+    i = size(data.capsense.datenum,1) + (1:N)';                             %Find the next indices.
+    data.capsense.datenum(i,1) = batch.datenum;                             %Save the serial date number timestamps.
+    data.capsense.micros(i,1) = batch.times;                                %Save the microcontroller microsecond timestamps.
+    data.capsense.status(i,1:num_sensors) = status;                         %Add the new status to the matrix.
+end
+
+values = [repmat(batch.id,N,1), batch.values(:,3), i];                      %Sensor index, sensor value, and reading index.
+if isempty(data.capsense.value)                                             %If these are the first values...
+    data.capsense.value = values;                                           %Create the value matrix.
+else                                                                        %Otherwise...
+    j = size(data.capsense.value,1) + (1:N)';                               %Find the next value indices.
+    data.capsense.value(j,:) = values;                                      %Add the new values to the matrix.
 end
 
 
@@ -1312,8 +1393,11 @@ block_read(42) = struct('def_name', 'DOWNLOAD_TIME', 'fcn', @(data)OmniTrakFileR
 % The computer system name and the COM port used to download the data file form the OmniTrak device.
 block_read(43) = struct('def_name', 'DOWNLOAD_SYSTEM', 'fcn', @(data)OmniTrakFileRead_ReadBlock_DOWNLOAD_SYSTEM(fid,data));
 
+% Frames the file metadata blocks (ORIGINAL_FILENAME, RENAMED_FILE, DOWNLOAD_TIME, DOWNLOAD_SYSTEM) appended as a trailer at the end of the file, so they can be found with one read from the end.
+block_read(44) = struct('def_name', 'METADATA_TRAILER', 'fcn', @(data)OmniTrakFileRead_ReadBlock_METADATA_TRAILER(fid,data));
+
 
-% Indicates that the file will end in an incomplete block.
+% Marks the next block as split across two device writes, giving its code and start and end bytes; a file that ends inside that block was cut off between the writes.
 block_read(50) = struct('def_name', 'INCOMPLETE_BLOCK', 'fcn', @(data)OmniTrakFileRead_ReadBlock_INCOMPLETE_BLOCK(fid,data));
 
 
@@ -1514,6 +1598,10 @@ block_read(1009) = struct('def_name', 'ZMOD4410_ENABLED', 'fcn', @(data)OmniTrak
 block_read(1024) = struct('def_name', 'AMBULATION_XY_THETA', 'fcn', @(data)OmniTrakFileRead_ReadBlock_AMBULATION_XY_THETA(fid,data));
 
 
+% A batch of tracked ambulation path points (see AMBULATION_XY_THETA), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
+block_read(1025) = struct('def_name', 'AMBULATION_XY_THETA_PACKED', 'fcn', @(data)OmniTrakFileRead_ReadBlock_AMBULATION_XY_THETA_PACKED(fid,data));
+
+
 % The conversion factor, in degrees Celsius, for converting 16-bit integer AMG8833 pixel readings to temperature.
 block_read(1100) = struct('def_name', 'AMG8833_THERM_CONV', 'fcn', @(data)OmniTrakFileRead_ReadBlock_AMG8833_THERM_CONV(fid,data));
 
@@ -1649,6 +1737,10 @@ block_read(1523) = struct('def_name', 'MLX90640_INT_WRITE_TIME', 'fcn', @(data)O
 block_read(1600) = struct('def_name', 'ALSPT19_LIGHT', 'fcn', @(data)OmniTrakFileRead_ReadBlock_ALSPT19_LIGHT(fid,data));
 
 
+% A batch of ALS-PT19 ambient light sensor ADC values (see ALSPT19_LIGHT), packed as delta-of-delta millisecond timestamps and bit-packed value deltas.
+block_read(1601) = struct('def_name', 'ALSPT19_LIGHT_PACKED', 'fcn', @(data)OmniTrakFileRead_ReadBlock_ALSPT19_LIGHT_PACKED(fid,data));
+
+
 % The current lower and upper bounds for the ZMOD4410 ADC reading used in calculations.
 block_read(1700) = struct('def_name', 'ZMOD4410_MOX_BOUND', 'fcn', @(data)OmniTrakFileRead_ReadBlock_ZMOD4410_MOX_BOUND(fid,data));
 
@@ -1818,6 +1910,10 @@ block_read(2501) = struct('def_name', 'MOTOTRAK_V3P0_SIGNAL', 'fcn', @(data)Omni
 block_read(2560) = struct('def_name', 'POKE_BITMASK', 'fcn', @(data)OmniTrakFileRead_ReadBlock_POKE_BITMASK(fid,data));
 
 
+% A batch of nosepoke status bitmasks (see POKE_BITMASK), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
+block_read(2561) = struct('def_name', 'POKE_BITMASK_PACKED', 'fcn', @(data)OmniTrakFileRead_ReadBlock_POKE_BITMASK_PACKED(fid,data));
+
+
 % Capacitive sensor status bitmask, typically written only when it changes.
 block_read(2576) = struct('def_name', 'CAPSENSE_BITMASK', 'fcn', @(data)OmniTrakFileRead_ReadBlock_CAPSENSE_BITMASK(fid,data));
 
@@ -1825,6 +1921,10 @@ block_read(2576) = struct('def_name', 'CAPSENSE_BITMASK', 'fcn', @(data)OmniTrak
 block_read(2577) = struct('def_name', 'CAPSENSE_VALUE', 'fcn', @(data)OmniTrakFileRead_ReadBlock_CAPSENSE_VALUE(fid,data));
 
 
+% A batch of capacitive sensor readings for one sensor (see CAPSENSE_VALUE), packed as delta-of-delta microsecond timestamps and bit-packed value deltas.
+block_read(2578) = struct('def_name', 'CAPSENSE_VALUE_PACKED', 'fcn', @(data)OmniTrakFileRead_ReadBlock_CAPSENSE_VALUE_PACKED(fid,data));
+
+
 % Name/description of the output trigger type for the given index.
 block_read(2600) = struct('def_name', 'OUTPUT_TRIGGER_NAME', 'fcn', @(data)OmniTrakFileRead_ReadBlock_OUTPUT_TRIGGER_NAME(fid,data));
 
@@ -2183,7 +2283,8 @@ function data = OmniTrakFileRead_ReadBlock_INCOMPLETE_BLOCK(fid,data)
 %		50
 %		INCOMPLETE_BLOCK
 
-fprintf(1,'Need to finish coding for Block 50: INCOMPLETE_BLOCK');
+fread(fid,1,'uint16');                                                      %Skip the code of the block that was split across two writes.
+fread(fid,2,'uint32');                                                      %Skip that block's start and end byte offsets.
 
 
 function data = OmniTrakFileRead_ReadBlock_INIT_THRESH_TYPE(fid,data)
@@ -2329,6 +2430,18 @@ data.temp(i).timestamp = fread(fid,1,'uint32');                             %Sav
 data.temp(i).celsius = fread(fid,1,'float32');                              %Save the temperature reading as a float32 value.
 
 
+function data = OmniTrakFileRead_ReadBlock_METADATA_TRAILER(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		44
+%		METADATA_TRAILER
+
+fread(fid,2,'uint8');                                                       %Skip the trailer version and block count.
+fread(fid,1,'uint32');                                                      %Skip the number of trailer bytes.
+fread(fid,1,'uint64');                                                      %Skip the offset of the previous trailer.
+fread(fid,1,'uint32');                                                      %Skip the trailer checksum.
+
+
 function data = OmniTrakFileRead_ReadBlock_MLX90640_ADC_RES(fid,data)
 
 %	OmniTrak File Block Code (OFBC):
@@ -2890,6 +3003,33 @@ else                                                                        %Oth
 end
 
 
+function data = OmniTrakFileRead_ReadBlock_POKE_BITMASK_PACKED(fid,data)
+
+%	OmniTrak File Block Code (OFBC):
+%		2561
+%		POKE_BITMASK_PACKED
+
+batch = OmniTrakFileRead_Read_Packed_Batch(fid,86400e6);                    %Read in the batch (microsecond timestamps).
+
+data = OmniTrakFileRead_Check_Field_Name(data,'poke',...
+    {'datenum','micros','status'});                                         %Call the subfunction to check for existing fieldnames.
+num_sensors = max(batch.values(:,1));                                       %Grab the largest number of sensors.
+N = numel(batch.times);                                                     %Number of samples in the batch.
+status = bitget(repmat(batch.values(:,2),1,num_sensors),...
+    repmat(1:num_sensors,N,1));                                             %Grab the status of each nosepoke.
+
+if isempty(data.poke.datenum)                                               %If these are the first bitmask readings...
+    data.poke.datenum = batch.datenum;                                      %Save the serial date number timestamps.
+    data.poke.micros = batch.times;                                         %Save the microcontroller microsecond timestamps.
+    data.poke.status = status;                                              %Create the status matrix.
+else                                                                        %Otherwise...
+    i = size(data.poke.datenum,1) + (1:N)';                                 %Find the next indices.
+    data.poke.datenum(i,1) = batch.datenum;                                 %Save the serial date number timestamps.
+    data.poke.micros(i,1) = batch.times;                                    %Save the microcontroller microsecond timestamps.
+    data.poke.status(i,1:num_sensors) = status;                             %Add the new status to the matrix.
+end
+
+
 function data = OmniTrakFileRead_ReadBlock_POSITION_MOVE_X(fid,data)
 
 %	OmniTrak File Block Code (OFBC):
@@ -4162,6 +4302,66 @@ function data = OmniTrakFileRead_ReadBlock_ZMOD4410_TVOC(fid,data)
 fprintf(1,'Need to finish coding for Block 1712: ZMOD4410_TVOC');
 
 
+function batch = OmniTrakFileRead_Read_Packed_Batch(fid,ticks_per_day)
+
+%
+%OmniTrakFileRead_Read_Packed_Batch.m - Vulintus, Inc.
+%
+%   OMNITRAKFILEREAD_READ_PACKED_BATCH reads and decodes the payload of a
+%   "*_PACKED" data block: a batch of samples stored as delta-of-delta
+%   clock timestamps and bit-packed value deltas. It returns the sensor
+%   index or ID, the N sample timestamps (N x 1), the values of the C
+%   channels as signed 32-bit integers (N x C), and each sample's serial
+%   date number, counted on from the first sample's at "ticks_per_day".
+%
+%   Packed fields are stored LSB-first: N-2 timestamp fields, then N-1
+%   value fields for each channel. Each field is zigzag-encoded (0, -1, 1,
+%   -2, ... -> 0, 1, 2, 3, ...) and summed onto the previous value, with
+%   timestamps wrapping like the device's 32-bit clock.
+%
+%   UPDATE LOG:
+%   2026-10-17 - Function first implemented.
+%
+
+ver = fread(fid,1,'uint8');                                                 %Packed batch version.
+if ver ~= 1                                                                 %If the batch version isn't recognized...
+    error(['ERROR IN %s: Packed batch version #%1.0f is not '...
+        'recognized!'], upper(mfilename), ver);                             %Show an error.
+end
+batch.id = fread(fid,1,'uint8');                                            %Sensor index or ID.
+C = fread(fid,1,'uint8');                                                   %Number of value channels.
+N = fread(fid,1,'uint8');                                                   %Number of samples in the batch.
+datenum0 = fread(fid,1,'float64');                                          %Serial date number of the first sample.
+time0 = fread(fid,1,'uint32');                                              %First sample's clock timestamp.
+delta0 = fread(fid,1,'int32');                                              %First timestamp delta.
+time_width = fread(fid,1,'uint8');                                          %Timestamp field width, in bits.
+value_widths = fread(fid,C,'uint8');                                        %Each channel's value field width, in bits.
+first_values = fread(fid,C,'int32');                                        %Each channel's first value.
+num_bits = max(N-2,0)*time_width + (N-1)*sum(value_widths);                 %Count the bits in the packed fields.
+packed = fread(fid,ceil(num_bits/8),'uint8');                               %Read in the packed fields.
+
+bits = bitget(repmat(packed(:)',8,1),repmat((1:8)',1,numel(packed)));       %Split the packed bytes into bits, LSB first.
+bits = bits(:);                                                             %Make the bits one continuous stream.
+unpack = @(start,width,n)(2.^(0:width-1))*...
+    reshape(bits(start + (1:width*n)),width,n);                             %Unpack n fields of the given width.
+unzigzag = @(z)floor(z/2).*(1 - 2*mod(z,2)) - mod(z,2);                     %Convert zigzag-encoded fields to signed values.
+
+bit = max(N-2,0)*time_width;                                                %Value fields start after the timestamp fields.
+dd = unzigzag(unpack(0,time_width,max(N-2,0)))';                            %Timestamp delta-of-deltas.
+deltas = delta0 + [0; cumsum(dd)];                                          %Timestamp deltas.
+times = mod(time0 + [0; cumsum(deltas)],2^32);                              %Timestamps, wrapped like the 32-bit device clock.
+batch.times = times(1:N);                                                   %Trim the extra timestamp a 1-sample batch gets.
+batch.datenum = datenum0 + mod(batch.times - time0,2^32)/ticks_per_day;     %Serial date number of each sample.
+
+batch.values = zeros(N,C);                                                  %Pre-allocate the value matrix.
+for c = 1:C                                                                 %Step through each value channel.
+    dv = unzigzag(unpack(bit,value_widths(c),N-1))';                        %Value deltas.
+    v = first_values(c) + [0; cumsum(dv)];                                  %Values, before wrapping.
+    batch.values(:,c) = mod(v + 2^31,2^32) - 2^31;                          %Wrap the values to signed 32-bit integers.
+    bit = bit + (N-1)*value_widths(c);                                      %Skip to the next channel's fields.
+end
+
+
 function waitbar = big_waitbar(varargin)
 
 figsize = [2,16];                                                           %Set the default figure size, in centimeters.
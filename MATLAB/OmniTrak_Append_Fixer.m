@@ -33,7 +33,7 @@ if any(strfind(str,'COM')) || any(strfind(str,'.OmniTrak'))                 %If
             fwrite(new_fid,N,'uint16');                                             %Write the the number of characters in the new filename.
             fwrite(new_fid,new_filename,'uchar');                             %Write the old filename.
             while ftell(old_fid) < pos
-                fwrite(new_fid,fread(old_fid,1,'uint8'),'uint8');
+                fwrite(new_fid,fread(old_fid,min(8388608,pos - ftell(old_fid)),'*uint8'),'uint8');
             end
             fclose(new_fid);
             fclose(old_fid);
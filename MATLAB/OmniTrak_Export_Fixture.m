@@ -0,0 +1,66 @@
+function OmniTrak_Export_Fixture(file, csv_file)
+
+%
+% OmniTrak_Export_Fixture.m
+%
+%   copyright 2026, Vulintus, Inc.
+%
+%   OMNITRAK_EXPORT_FIXTURE reads an *.OmniTrak file with OmniTrakFileRead
+%   and writes the element count and sum of every numeric field in the
+%   returned data structure to a CSV file, one "path,count,sum" row per
+%   field (e.g. "amg.pixels.float"), totalled across struct array
+%   elements. The C++ benchmark harness (OmniTrak_Benchmark --check)
+%   compares its own decoding of the same file against these totals.
+%
+%   If no CSV filename is given, the fixture is saved next to the input
+%   file as "<name>_fixture.csv".
+%
+
+
+if nargin < 2                                                               %If no CSV filename was specified...
+    [path, name, ~] = fileparts(file);                                      %Grab the parts of the input filename.
+    csv_file = fullfile(path, [name '_fixture.csv']);                       %Save the fixture next to the input file.
+end
+
+data = OmniTrakFileRead(file);                                              %Read in the file.
+
+totals = containers.Map('KeyType','char','ValueType','any');                %Create a map to hold the totals for each field path.
+Export_Fixture_Totals(data, '', totals);                                    %Total up every numeric field.
+
+fid = fopen(csv_file,'wt');                                                 %Open the CSV file for writing.
+if fid == -1                                                                %If the file couldn't be opened...
+    error(['ERROR IN ' upper(mfilename) ': Could not create the fixture '...
+        'file!\n\t%s'],csv_file);                                           %Throw an error.
+end
+fprintf(fid,'path,count,sum\n');                                            %Write the column headings.
+paths = sort(keys(totals));                                                 %Grab the field paths in alphabetical order.
+for i = 1:numel(paths)                                                      %Step through the field paths.
+    t = totals(paths{i});                                                   %Grab the totals for this field.
+    fprintf(fid,'%s,%1.0f,%0.17g\n', paths{i}, t(1), t(2));                 %Write the count and sum, at full precision.
+end
+fclose(fid);                                                                %Close the CSV file.
+
+
+%% This subfunction adds the element counts and sums of every numeric field below a structure to a map.
+function Export_Fixture_Totals(value, path, totals)
+
+if isstruct(value)                                                          %If the value is a structure...
+    fields = fieldnames(value);                                             %Grab the field names.
+    for i = 1:numel(value)                                                  %Step through each element of the structure array.
+        for j = 1:numel(fields)                                             %Step through each field.
+            if isempty(path)                                                %If this is the top level...
+                sub_path = fields{j};                                       %The path is just the field name.
+            else                                                            %Otherwise...
+                sub_path = [path '.' fields{j}];                            %Add the field name to the path.
+            end
+            Export_Fixture_Totals(value(i).(fields{j}), sub_path, totals);  %Recursively total up the field.
+        end
+    end
+elseif (isnumeric(value) || islogical(value)) && ~isempty(path)             %If the value is numeric...
+    if isKey(totals, path)                                                  %If this path was already seen...
+        t = totals(path);                                                   %Grab the running totals.
+    else                                                                    %Otherwise...
+        t = [0, 0];                                                         %Start new totals.
+    end
+    totals(path) = t + [numel(value), sum(double(value(:)),'omitnan')];     %Add this value's count and sum.
+end
@@ -47,7 +47,7 @@ fwrite(new_fid,length(port),'uint8');                                       %Wri
 fwrite(new_fid,port,'uchar');                                               %Write the characters of the port name.
 
 while ~feof(old_fid)                                                        %Loop until the end of the original file.
-    fwrite(new_fid, fread(old_fid, 1, 'uint8'), 'uint8');                   %Copy each subsequent byte from the original file to the temporary file.
+    fwrite(new_fid, fread(old_fid, 8388608, '*uint8'), 'uint8');            %Copy the original file to the temporary file in 8 MB chunks.
 end
 
 fclose(new_fid);                                                            %Close the temporary file.
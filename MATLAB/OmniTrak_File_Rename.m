@@ -43,7 +43,9 @@ if ~strcmpi(old_filename_short, new_filename_short)                         %If
     fwrite(new_fid,N,'uint16');                                             %Write the the number of characters in the new filename.
     fwrite(new_fid,new_filename_short,'uchar');                             %Write the old filename.
 
-    fwrite(new_fid, fread(old_fid,'uint8'), 'uint8');                       %Copy over the rest of the file.
+    while ~feof(old_fid)                                                    %Loop until the end of the original file.
+        fwrite(new_fid, fread(old_fid, 8388608, '*uint8'), 'uint8');        %Copy over the rest of the file in 8 MB chunks.
+    end
 
     fclose(new_fid);                                                        %Close the temporary file.
     fclose(old_fid);                                                        %Close the original file.